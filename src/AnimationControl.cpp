@@ -3,6 +3,7 @@
 #include "core/utility/Logger.h"
 #include "core/game/GameClientAdaptor.h"
 #include "Formatting.h"
+#include "WMVxSettings.h"
 
 using namespace core;
 
@@ -23,9 +24,12 @@ AnimationControl::AnimationControl(QWidget* parent)
 
 	connect(ui.comboBoxAnimations, &QComboBox::currentIndexChanged, this, &AnimationControl::selectAnimationFromIndex);
 
+	connect(ui.checkBoxBaked, &QCheckBox::stateChanged, this, &AnimationControl::toggleBakedPlayback);
+
 	connect(ui.horizontalSliderSpeed, &QSlider::valueChanged, [&]() {
 		if (model != nullptr) {
 			model->animator.setSpeed(ui.horizontalSliderSpeed->value() / 10.0f);
+			scene->requestRedraw();
 		}
 	});
 
@@ -36,6 +40,8 @@ AnimationControl::AnimationControl(QWidget* parent)
 			if (!frameTimer->isActive()) {
 				frameTimer->start();
 			}
+
+			scene->requestRedraw();
 		}
 		updateFrameSlider();
 	});
@@ -47,6 +53,8 @@ AnimationControl::AnimationControl(QWidget* parent)
 			if (frameTimer->isActive()) {
 				frameTimer->stop();
 			}
+
+			scene->requestRedraw();
 		}
 		updateFrameSlider();
 	});
@@ -55,6 +63,7 @@ AnimationControl::AnimationControl(QWidget* parent)
 		if (model != nullptr && model->animate && model->animator.isPaused()) {
 			auto val = ui.horizontalSliderFrame->value();
 			model->animator.setFrame(val);
+			scene->requestRedraw();
 		}
 	});
 
@@ -91,6 +100,7 @@ void AnimationControl::toggleAnimationsActive()
 
 	if (model != nullptr) {
 		model->animate = active;
+		scene->requestRedraw();
 	}
 
 	ui.comboBoxAnimations->setDisabled(!active);
@@ -98,6 +108,7 @@ void AnimationControl::toggleAnimationsActive()
 	ui.horizontalSliderSpeed->setDisabled(!active);
 	ui.pushButtonPlay->setDisabled(!active);
 	ui.pushButtonStop->setDisabled(!active);
+	ui.checkBoxBaked->setDisabled(!active);
 
 	ui.labelFrame->setDisabled(!active);
 	ui.labelFrameInfo->setVisible(active);
@@ -134,10 +145,45 @@ void AnimationControl::selectAnimationFromIndex(int index)
 		if (model != nullptr && gameDB != nullptr) {
 			const auto& animation = model->model->getModelAnimationSequenceAdaptors().at(data.index);
 			model->animator.setAnimation(animation, data.index);
+			logBakedError();
+			scene->requestRedraw();
 		}
 	}
 }
 
+void AnimationControl::toggleBakedPlayback()
+{
+	if (model != nullptr && !isLoadingModel) {
+		const uint32_t rate = ui.checkBoxBaked->isChecked() ? std::max(Settings::get<int32_t>(config::rendering::animation_bake_rate), 1) : 0;
+		model->setBakeSampleRate(rate);
+		logBakedError();
+		scene->requestRedraw();
+	}
+}
+
+void AnimationControl::logBakedError()
+{
+	if (model == nullptr || !model->animator.getAnimationIndex().has_value()) {
+		return;
+	}
+
+	const auto* baked = model->getBakedAnimation(model->animator.getAnimationIndex().value());
+	if (baked == nullptr) {
+		return;
+	}
+
+	const auto error = baked->measureError(model->model->getBoneAdaptors());
+	Log::message(
+		QString("Baked animation %1 @ %2/s: %3 samples, %4 KB, max error %5, mean error %6")
+		.arg(baked->getAnimationIndex())
+		.arg(baked->getSampleRate())
+		.arg(baked->getSampleCount())
+		.arg(baked->getDataSize() / 1024.0, 0, 'f', 1)
+		.arg(error.maxError, 0, 'f', 4)
+		.arg(error.meanError, 0, 'f', 4)
+	);
+}
+
 void AnimationControl::onSceneSelectionChanged(const core::Scene::Selection& selection) {
 	if (selection.component && selection.component->getMetaType() == ComponentMeta::Type::ROOT) {
 		model = selection.root;
@@ -157,6 +203,8 @@ void AnimationControl::onSceneSelectionChanged(const core::Scene::Selection& sel
 
 	isLoadingModel = true;
 
+	ui.checkBoxBaked->setChecked(model != nullptr && model->getBakeSampleRate() > 0);
+
 	ui.comboBoxAnimations->clear();
 
 	if (model != nullptr && gameDB != nullptr) {
@@ -25,6 +25,8 @@ private:
 	Ui::AnimationControlClass ui;
 
 	void selectAnimationFromIndex(int index);
+	void toggleBakedPlayback();
+	void logBakedError();
 
 	core::Model* model;
 	bool isLoadingModel;
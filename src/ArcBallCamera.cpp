@@ -28,6 +28,8 @@ void ArcBallCamera::setup()
 	m_viewMatrix = glm::lookAt(m_eye, m_LookAt, m_upVector);
 	gluLookAt(m_eye.x, m_eye.y, m_eye.z, m_LookAt.x, m_LookAt.y, m_LookAt.z, m_upVector.x, m_upVector.y, m_upVector.z);
 
+	viewMatrix = lookAt(Vector3(m_eye.x, m_eye.y, m_eye.z), Vector3(m_LookAt.x, m_LookAt.y, m_LookAt.z), Vector3(m_upVector.x, m_upVector.y, m_upVector.z));
+
 }
 
 void ArcBallCamera::key(float change_x, float change_y, bool alternative, float factor)
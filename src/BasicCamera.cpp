@@ -31,6 +31,8 @@ void BasicCamera::setup()
 		viewPoint.x, viewPoint.y, viewPoint.z,				// Specifies the position of the reference point.
 		upVector.x, upVector.y, upVector.z);		// Specifies the direction of the up vector.
 
+	viewMatrix = lookAt(position, viewPoint, upVector);
+
 
 	//TODO should matrix mode be reset?
 }
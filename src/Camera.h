@@ -1,4 +1,7 @@
 #pragma once
+#include <cmath>
+#include "core/utility/Matrix.h"
+#include "core/utility/Vector3.h"
 
 class Camera {
 public:
@@ -20,4 +23,44 @@ public:
 	virtual void rightMouseStart() = 0;
 	virtual void rightMouse(float change_x, float change_y, float factor) = 0;
 	virtual void rightMouseEnd() = 0;
+
+	// view matrix loaded by the last setup, so the renderer doesnt need to read it back from GL.
+	const core::Matrix& getViewMatrix() const {
+		return viewMatrix;
+	}
+
+protected:
+
+	// equivalent of gluLookAt.
+	static core::Matrix lookAt(const core::Vector3& eye, const core::Vector3& center, const core::Vector3& up) {
+		const auto cross = [](const core::Vector3& a, const core::Vector3& b) {
+			return core::Vector3((a.y * b.z) - (a.z * b.y), (a.z * b.x) - (a.x * b.z), (a.x * b.y) - (a.y * b.x));
+		};
+		const auto dot = [](const core::Vector3& a, const core::Vector3& b) {
+			return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+		};
+
+		core::Vector3 forward = center - eye;
+		forward.normalize();
+		core::Vector3 side = cross(forward, up);
+		side.normalize();
+		const core::Vector3 upward = cross(side, forward);
+
+		core::Matrix result = core::Matrix::identity();
+		result.m[0][0] = side.x;
+		result.m[0][1] = side.y;
+		result.m[0][2] = side.z;
+		result.m[0][3] = -dot(side, eye);
+		result.m[1][0] = upward.x;
+		result.m[1][1] = upward.y;
+		result.m[1][2] = upward.z;
+		result.m[1][3] = -dot(upward, eye);
+		result.m[2][0] = -forward.x;
+		result.m[2][1] = -forward.y;
+		result.m[2][2] = -forward.z;
+		result.m[2][3] = dot(forward, eye);
+		return result;
+	}
+
+	core::Matrix viewMatrix = core::Matrix::identity();
 };
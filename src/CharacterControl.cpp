@@ -18,6 +18,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 	ui.setupUi(this);
 
 	model = nullptr;
+	bodyComponentTextureAdaptor = nullptr;
 
 	isLoadingModel = false;
 	isRandomising = false;
@@ -80,6 +81,8 @@ CharacterControl::CharacterControl(QWidget* parent)
 				updateEquipmentLabel(core::CharacterSlot::TABARD);
 			}
 
+			buildState.invalidate(CharacterBuildState::INPUT_TABARD);
+			buildState.invalidateSlot(core::CharacterSlot::TABARD);
 			updateModel();
 		});
 		customDialog->show();
@@ -97,6 +100,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 			isRandomising = false;
 
 			applyCustomizations();
+			buildState.invalidate(CharacterBuildState::INPUT_CUSTOMIZATION);
 			updateModel();
 		}
 	});
@@ -104,6 +108,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 	connect(ui.comboBoxEyeGlow, &QComboBox::currentIndexChanged, [&](int index) {
 		if (model != nullptr && !isLoadingModel) {
 			model->characterOptions.eyeGlow = static_cast<CharacterRenderOptions::EyeGlow>(index);
+			// only affects geosets.
 			updateModel();
 		}
 	});
@@ -111,6 +116,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 	connect(ui.comboBoxEars, &QComboBox::currentIndexChanged, [&](int index) {
 		if (model != nullptr && !isLoadingModel) {
 			model->characterOptions.earVisibilty = static_cast<CharacterRenderOptions::EarVisibility>(index);
+			// only affects geosets.
 			updateModel();
 		}
 	});
@@ -118,6 +124,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 	connect(ui.checkBoxUnderWear, &QCheckBox::stateChanged, [&]() {
 		if (model != nullptr && !isLoadingModel) {
 			model->characterOptions.showUnderWear = ui.checkBoxUnderWear->isChecked();
+			buildState.invalidate(CharacterBuildState::INPUT_RENDER_OPTIONS);
 			updateModel();
 		}
 	});
@@ -125,6 +132,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 	connect(ui.checkBoxFeet, &QCheckBox::stateChanged, [&]() {
 		if (model != nullptr && !isLoadingModel) {
 			model->characterOptions.showFeet = ui.checkBoxFeet->isChecked();
+			buildState.invalidate(CharacterBuildState::INPUT_RENDER_OPTIONS);
 			updateModel();
 		}
 	});
@@ -132,6 +140,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 	connect(ui.checkBoxHair, &QCheckBox::stateChanged, [&]() {
 		if (model != nullptr && !isLoadingModel) {
 			model->characterOptions.showHair = ui.checkBoxHair->isChecked();
+			// only affects geosets.
 			updateModel();
 		}
 	});
@@ -139,6 +148,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 	connect(ui.checkBoxFacialHair, &QCheckBox::stateChanged, [&]() {
 		if (model != nullptr && !isLoadingModel) {
 			model->characterOptions.showFacialHair = ui.checkBoxFacialHair->isChecked();
+			buildState.invalidate(CharacterBuildState::INPUT_RENDER_OPTIONS);
 			updateModel();
 		}
 	});
@@ -168,6 +178,7 @@ CharacterControl::CharacterControl(QWidget* parent)
 
 			handle_slot(CharacterSlot::HAND_LEFT);
 			handle_slot(CharacterSlot::HAND_RIGHT);
+			scene->requestRedraw();
 		}
 	});
 
@@ -224,6 +235,8 @@ void CharacterControl::onSceneSelectionChanged(const core::Scene::Selection& sel
 		model = nullptr;
 	}
 
+	resetBuildState();
+
 	availableCustomizations.clear();
 	if (model != nullptr) {
 		chosenCustomisations = model->characterCustomizationChoices;
@@ -352,6 +365,7 @@ void CharacterControl::toggleActive() {
 
 						if (!isRandomising) {
 							applyCustomizations();
+							buildState.invalidate(CharacterBuildState::INPUT_CUSTOMIZATION);
 							updateModel();
 						}
 					}
@@ -373,6 +387,7 @@ void CharacterControl::toggleActive() {
 		//TODO update effect label.
 
 		if (!model->characterInitialised) {
+			buildState.invalidateAll();
 			updateModel();
 			updateEquipment();
 			model->characterInitialised = true;
@@ -438,6 +453,10 @@ void CharacterControl::openChoiceDialog(CharacterSlot slot)
 				ModelHelper(scene, model).removeItem(slot);
 			}
 
+			if (slot == CharacterSlot::TABARD) {
+				buildState.invalidate(CharacterBuildState::INPUT_TABARD);
+			}
+			buildState.invalidateSlot(slot);
 			updateModel();
 		}
 		});
@@ -529,6 +548,8 @@ void CharacterControl::openEnchantDialog(CharacterSlot slot)
 			applyItemVisualToAttachment(*attachment, itemVisual, enchant->getName());
 
 		}
+
+		scene->requestRedraw();
 	});
 	dialog->show();
 }
@@ -546,21 +567,35 @@ void CharacterControl::updateModel()
 
 		Log::message("Updating character model...");
 
+		// geosets are cached by their modifiers, only changed modifiers get re-evaluated.
 		model->updateAllGeosets();
 
 		ModelTraits traits = ModelTraits(model);
 
-		std::shared_ptr<Texture> capetex = nullptr;
-
-		CharacterTextureBuilder builder;
-		characterCustomizationProvider->update(model, &builder, scene);
+		if (buildState.needs(CharacterBuildState::Output::CUSTOMIZATION)) {
+			customizationLayers = CharacterTextureBuilder();
+			characterCustomizationProvider->update(model, &customizationLayers, scene);
+		}
 
 		const auto slot_order = getSlotOrder(traits);
+		buildState.updateSlotOrder(slot_order);
+
 		for (auto i = 0; i < (uint32_t)CharacterSlot::MAX; i++) {
 
 			const CharacterSlot slot = slot_order[i];
 			auto layer_index = 10 + i; 
 
+			if (!buildState.needsSlot(slot)) {
+				continue;
+			}
+
+			CharacterTextureBuilder& builder = equipmentLayers[slot];
+			builder = CharacterTextureBuilder();
+
+			if (slot == CharacterSlot::CAPE) {
+				capeTexture = nullptr;
+			}
+
 			if (model->characterEquipment.contains(slot)) {
 				const auto& item_wrapper = model->characterEquipment[slot];
 				const auto* record = item_wrapper.display();
@@ -791,7 +826,7 @@ void CharacterControl::updateModel()
 							}
 						}, cape_skin);
 
-						capetex = scene->textureManager.add(cape_skin, gameFS);
+						capeTexture = scene->textureManager.add(cape_skin, gameFS);
 					}
 				}
 				break;
@@ -810,19 +845,45 @@ void CharacterControl::updateModel()
 			}			
 		}
 
-		model->replacableTextures[TextureType::BODY] = builder.build(componentTextureAdaptor, & scene->textureManager, gameFS);
+		CharacterTextureBuilder body_layers = customizationLayers;
+		for (const auto slot : slot_order) {
+			const auto found = equipmentLayers.find(slot);
+			if (found != equipmentLayers.end()) {
+				body_layers.addLayers(found->second);
+			}
+		}
+
+		// compositing is the costly step, skip it when the layers are the same as the last build.
+		if (body_layers != bodyLayers || componentTextureAdaptor != bodyComponentTextureAdaptor || !model->replacableTextures.contains(TextureType::BODY)) {
+			bodyLayers = body_layers;
+			bodyComponentTextureAdaptor = componentTextureAdaptor;
+			model->replacableTextures[TextureType::BODY] = body_layers.build(componentTextureAdaptor, & scene->textureManager, gameFS);
+		}
 
-		if (capetex != nullptr) {
-			model->replacableTextures[TextureType::CAPE] = capetex;
+		if (capeTexture != nullptr) {
+			model->replacableTextures[TextureType::CAPE] = capeTexture;
 		}
 		else {
 			model->replacableTextures.erase(TextureType::CAPE);
 		}
 
+		buildState.clear();
+
 		scene->componentUpdated(model);
 	}
 }
 
+void CharacterControl::resetBuildState()
+{
+	// cached outputs belong to the previously selected model.
+	buildState.invalidateAll();
+	customizationLayers = CharacterTextureBuilder();
+	equipmentLayers.clear();
+	capeTexture = nullptr;
+	bodyLayers = CharacterTextureBuilder();
+	bodyComponentTextureAdaptor = nullptr;
+}
+
 void CharacterControl::updateEquipment()
 {
 	for (const auto& equipment : model->characterEquipment) {
@@ -9,6 +9,7 @@
 #include "core/database/GameDatasetAdaptors.h"
 #include "core/modeling/CharacterCustomization.h"
 #include "core/modeling/AttachmentCustomization.h"
+#include "core/modeling/CharacterBuildState.h"
 
 
 class CharacterControl : public QWidget, public WidgetUsesScene, public WidgetUsesGameClient
@@ -40,6 +41,7 @@ private:
 	void updateModel();
 	void updateEquipment();
 	void updateItem(core::CharacterSlot slot, const core::CharacterItemWrapper& wrapper);
+	void resetBuildState();
 
 	core::GameFileUri searchSlotTexture(core::GameFileUri file, core::CharacterRegion region);
 
@@ -67,6 +69,14 @@ private:
 	std::unique_ptr<core::CharacterCustomizationProvider> characterCustomizationProvider;
 	std::unique_ptr<core::AttachmentCustomizationProvider> attachmentCustomizationProvider;
 
+	// outputs of the last build, reused by updateModel while their inputs are unchanged.
+	core::CharacterBuildState buildState;
+	core::CharacterTextureBuilder customizationLayers;
+	std::map<core::CharacterSlot, core::CharacterTextureBuilder> equipmentLayers;
+	std::shared_ptr<core::Texture> capeTexture;
+	core::CharacterTextureBuilder bodyLayers;
+	core::CharacterComponentTextureAdaptor* bodyComponentTextureAdaptor;
+
 	QComboBox* addCustomizationControl(const QString& name);
 	QComboBox* getCustomizationControl(const QString& name);
 
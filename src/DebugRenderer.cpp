@@ -0,0 +1,161 @@
+#include "stdafx.h"
+#include "DebugRenderer.h"
+
+using namespace core;
+
+DebugRenderer::DebugRenderer() :
+	gridBuffer(0),
+	gridVertexCount(0),
+	overlayBuffer(0)
+{
+}
+
+DebugRenderer::~DebugRenderer()
+{
+	if (gridBuffer != 0) {
+		glDeleteBuffers(1, &gridBuffer);
+	}
+
+	if (overlayBuffer != 0) {
+		glDeleteBuffers(1, &overlayBuffer);
+	}
+}
+
+void DebugRenderer::initialise()
+{
+	glGenBuffers(1, &gridBuffer);
+	glGenBuffers(1, &overlayBuffer);
+}
+
+void DebugRenderer::renderGrid(int32_t extent, float plane)
+{
+	const auto layout = std::make_pair(extent, plane);
+	if (gridLayout != layout) {
+		buildGrid(extent, plane);
+		gridLayout = layout;
+	}
+
+	glPushAttrib(GL_CURRENT_BIT);
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+	glBindBuffer(GL_ARRAY_BUFFER, gridBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(GridVertex), (void*)offsetof(GridVertex, position));
+	glNormalPointer(GL_FLOAT, sizeof(GridVertex), (void*)offsetof(GridVertex, normal));
+	glColorPointer(3, GL_FLOAT, sizeof(GridVertex), (void*)offsetof(GridVertex, color));
+
+	glDrawArrays(GL_QUADS, 0, gridVertexCount);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glPopClientAttrib();
+	glPopAttrib();
+}
+
+void DebugRenderer::addBounds(const M2Model* model, const Matrix& transform)
+{
+	const auto& bounds = model->getBounds();
+
+	for (const auto index : model->getBoundTriangles()) {
+		boundsVertices.push_back(transform * (index < bounds.size() ? bounds[index] : Vector3(0, 0, 0)));
+	}
+}
+
+void DebugRenderer::addBones(const M2Model* model, const Matrix& transform)
+{
+	const auto& bones = model->getBonePalette();
+
+	for (size_t i = 0; i < bones.size(); i++) {
+		const auto parent = bones.getParent(i);
+		if (parent != -1) {
+			boneVertices.push_back(transform * bones.getTranslationPivot(i));
+			boneVertices.push_back(transform * bones.getTranslationPivot(parent));
+		}
+	}
+}
+
+uint32_t DebugRenderer::render()
+{
+	if (boundsVertices.empty() && boneVertices.empty()) {
+		return 0;
+	}
+
+	uint32_t draws = 0;
+	const size_t bounds_size = boundsVertices.size() * sizeof(Vector3);
+	const size_t bones_size = boneVertices.size() * sizeof(Vector3);
+
+	// one upload for every model, orphaning the previous frame.
+	glBindBuffer(GL_ARRAY_BUFFER, overlayBuffer);
+	glBufferData(GL_ARRAY_BUFFER, bounds_size + bones_size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bounds_size, boundsVertices.data());
+	glBufferSubData(GL_ARRAY_BUFFER, bounds_size, bones_size, boneVertices.data());
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_POLYGON_BIT);
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+	// plain lines, whatever state the last pass left.
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+
+	if (!boundsVertices.empty()) {
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		glVertexPointer(3, GL_FLOAT, sizeof(Vector3), nullptr);
+		glDrawArrays(GL_TRIANGLES, 0, (GLsizei)boundsVertices.size());
+		draws++;
+	}
+
+	if (!boneVertices.empty()) {
+		// bones are drawn over the model.
+		glDisable(GL_DEPTH_TEST);
+		glVertexPointer(3, GL_FLOAT, sizeof(Vector3), (void*)bounds_size);
+		glDrawArrays(GL_LINES, 0, (GLsizei)boneVertices.size());
+		draws++;
+	}
+
+	glPopClientAttrib();
+	glPopAttrib();
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	boundsVertices.clear();
+	boneVertices.clear();
+
+	return draws;
+}
+
+void DebugRenderer::buildGrid(int32_t extent, float plane)
+{
+	std::vector<GridVertex> vertices;
+	const Vector3 up(0, 1, 0);
+	const std::array<float, 3> light = { 1.0f, 1.0f, 1.0f };
+	const std::array<float, 3> dark = { 0.2f, 0.2f, 0.2f };
+
+	size_t count = 0;
+	for (int32_t z = -extent; z <= extent; z++) {
+		for (int32_t x = -extent; x <= extent; x++) {
+			const auto& color = (count % 2) == 0 ? light : dark;
+			const float i = (float)z;
+			const float j = (float)x;
+
+			vertices.push_back({ Vector3(j, plane, i), up, color });
+			vertices.push_back({ Vector3(j, plane, i + 1), up, color });
+			vertices.push_back({ Vector3(j + 1, plane, i + 1), up, color });
+			vertices.push_back({ Vector3(j + 1, plane, i), up, color });
+			count++;
+		}
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, gridBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GridVertex), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	gridVertexCount = (GLsizei)vertices.size();
+}
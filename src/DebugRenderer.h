@@ -0,0 +1,56 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "core/modeling/M2.h"
+#include "core/utility/Matrix.h"
+#include "core/utility/Vector3.h"
+
+/// <summary>
+/// Grid, bounds and bone overlays, drawn from vertex buffers rather than rebuilt in immediate mode each frame.
+/// The grid is built once and only rebuilt when its layout changes, bounds and bones of every model are collected in world space
+/// and uploaded together, so each overlay is a single draw.
+/// </summary>
+class DebugRenderer
+{
+public:
+
+	DebugRenderer();
+	DebugRenderer(const DebugRenderer&) = delete;
+
+	// the context must be current.
+	~DebugRenderer();
+
+	void initialise();
+
+	// checkered quads covering [-extent, extent] on x and z, uses the current modelview.
+	void renderGrid(int32_t extent, float plane);
+
+	// transform is the model matrix, so the overlays of every model can share the view matrix.
+	void addBounds(const core::M2Model* model, const core::Matrix& transform);
+	void addBones(const core::M2Model* model, const core::Matrix& transform);
+
+	// draws everything added since the last call using the current modelview, returns the number of draws made.
+	uint32_t render();
+
+protected:
+
+	struct GridVertex {
+		core::Vector3 position;
+		core::Vector3 normal;
+		std::array<float, 3> color;
+	};
+
+	void buildGrid(int32_t extent, float plane);
+
+	GLuint gridBuffer;
+	GLsizei gridVertexCount;
+	// extent and plane the grid buffer was built with.
+	std::optional<std::pair<int32_t, float>> gridLayout;
+
+	GLuint overlayBuffer;
+	std::vector<core::Vector3> boundsVertices;
+	std::vector<core::Vector3> boneVertices;
+};
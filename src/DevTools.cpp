@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "DevTools.h"
+#include "FrameScheduler.h"
 #include <algorithm>
 #include <tuple>
 #include <vector>
@@ -12,13 +13,23 @@ public:
 	using GeosetModifier::GeosetModifier;
 	void operator()(GeosetState& state) override
 	{
-		state.each([&](auto& el) {
-			if (visibility.contains(el.first)) {
-				el.second = visibility[el.first];
+		state.each([&](uint32_t geoset_id, bool& visible) {
+			if (visibility.contains(geoset_id)) {
+				visible = visibility[geoset_id];
 			}
 		});
 	}
 
+	size_t signature() const override
+	{
+		size_t seed = 0;
+		for (const auto& [id, visible] : visibility) {
+			combine(seed, id);
+			combine(seed, visible);
+		}
+		return seed;
+	}
+
 	int32_t priority() const override {
 		return (int32_t)GeosetModiferPriority::ForcedOverride;
 	}
@@ -27,14 +38,15 @@ public:
 };
 
 
-DevTools::DevTools(QWidget *parent)
-	: QMainWindow(parent)
+DevTools::DevTools(RenderWidget* render_widget, QWidget *parent)
+	: QMainWindow(parent), renderWidget(render_widget)
 {
 	ui.setupUi(this);
 	model = nullptr;
 	updatingGeosets = false;
 
 	connect(ui.pushButtonRefreshGeosets, &QPushButton::pressed, this, &DevTools::updateModelData);
+	connect(ui.pushButtonCompareSkinning, &QPushButton::pressed, renderWidget, &RenderWidget::compareGpuSkinning);
 
 
 	observeTimer = new QTimer(this);
@@ -45,6 +57,22 @@ DevTools::DevTools(QWidget *parent)
 	});
 
 	ui.treeWidgetGeosets->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+	// profiler covers every model in the scene, not just the selection.
+	profilerTimer = new QTimer(this);
+	profilerTimer->setInterval(500);
+
+	connect(profilerTimer, &QTimer::timeout, [&]() {
+		if (isVisible() && ui.tabWidget->currentWidget() == ui.tabProfiler) {
+			updateProfiler();
+			updateRenderStats();
+		}
+	});
+
+	profilerTimer->start();
+
+	ui.treeWidgetProfiler->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+	ui.treeWidgetRenderStats->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
 }
 
 DevTools::~DevTools()
@@ -170,6 +198,93 @@ void DevTools::updateAttachments()
 	ui.treeAttachments->addTopLevelItem(root);
 }
 
+void DevTools::updateProfiler()
+{
+	const auto model_count = scene != nullptr ? scene->models.size() : 0;
+	constexpr auto phase_count = Model::UpdateProfiler::getPhaseCount();
+
+	// items are reused between refreshes, so expanded state survives.
+	while ((size_t)ui.treeWidgetProfiler->topLevelItemCount() > model_count) {
+		delete ui.treeWidgetProfiler->takeTopLevelItem(ui.treeWidgetProfiler->topLevelItemCount() - 1);
+	}
+
+	const auto format = [](double ms) {
+		return QString::number(ms, 'f', 3);
+	};
+
+	for (size_t i = 0; i < model_count; i++) {
+		const auto* profiled = scene->models[i].get();
+		const auto& profiler = profiled->getUpdateProfiler();
+
+		QTreeWidgetItem* root = ui.treeWidgetProfiler->topLevelItem((int)i);
+		if (root == nullptr) {
+			root = new QTreeWidgetItem(ui.treeWidgetProfiler);
+			for (size_t phase = 0; phase < phase_count; phase++) {
+				auto* child = new QTreeWidgetItem(root);
+				child->setText(0, Model::getUpdatePhaseName((Model::UpdatePhase)phase));
+			}
+			ui.treeWidgetProfiler->addTopLevelItem(root);
+		}
+
+		Model::UpdateProfiler::Stats total;
+
+		for (size_t phase = 0; phase < phase_count; phase++) {
+			const auto stats = profiler.getStats(phase);
+			auto* child = root->child((int)phase);
+			child->setText(1, format(stats.last));
+			child->setText(2, format(stats.average));
+			child->setText(3, format(stats.peak));
+
+			total.last += stats.last;
+			total.average += stats.average;
+			// sum of the phase peaks, an upper bound as the peaks may come from different frames.
+			total.peak += stats.peak;
+		}
+
+		root->setText(0, profiled->getMetaGameFileInfo().toString());
+		root->setText(1, format(total.last));
+		root->setText(2, format(total.average));
+		root->setText(3, format(total.peak));
+	}
+}
+
+void DevTools::updateRenderStats()
+{
+	const auto& stats = renderWidget->getRenderStats();
+
+	if (ui.treeWidgetRenderStats->topLevelItemCount() == 0) {
+		auto* draws = new QTreeWidgetItem(ui.treeWidgetRenderStats);
+		draws->setText(0, "Draws");
+		auto* instances = new QTreeWidgetItem(ui.treeWidgetRenderStats);
+		instances->setText(0, "Instances");
+		for (uint32_t type = 0; type < ShaderPassRenderer::STATE_TYPE_COUNT; type++) {
+			auto* item = new QTreeWidgetItem(ui.treeWidgetRenderStats);
+			item->setText(0, ShaderPassRenderer::getStateTypeName((ShaderPassRenderer::StateType)type));
+		}
+		auto* frame_time = new QTreeWidgetItem(ui.treeWidgetRenderStats);
+		frame_time->setText(0, "Frame Time (ms)");
+		auto* target_fps = new QTreeWidgetItem(ui.treeWidgetRenderStats);
+		target_fps->setText(0, "Target FPS");
+	}
+
+	ui.treeWidgetRenderStats->topLevelItem(0)->setText(1, QString::number(stats.draws));
+	ui.treeWidgetRenderStats->topLevelItem(1)->setText(1, QString::number(stats.instances));
+
+	for (uint32_t type = 0; type < ShaderPassRenderer::STATE_TYPE_COUNT; type++) {
+		auto* item = ui.treeWidgetRenderStats->topLevelItem((int)type + 2);
+		item->setText(1, QString::number(stats.changes[type]));
+		item->setText(2, QString::number(stats.avoided[type]));
+	}
+
+	const auto* scheduler = renderWidget->getFrameScheduler();
+	if (scheduler != nullptr) {
+		const int frame_row = ShaderPassRenderer::STATE_TYPE_COUNT + 2;
+		const QString frame_time = scheduler->isIdle() ? "Idle" : QString::number(scheduler->getFrameTimeMsecs(), 'f', 2);
+		ui.treeWidgetRenderStats->topLevelItem(frame_row)->setText(1, frame_time);
+		ui.treeWidgetRenderStats->topLevelItem(frame_row + 1)->setText(1, QString::number(scheduler->getTargetFrameRate()));
+	}
+}
+
 void DevTools::updateTextures() {
 	ui.listWidgetTextures->clear();
 
@@ -389,7 +504,7 @@ inline void DevTools::createAttachmentTreeItem(QTreeWidgetItem* item, const Mode
 	{
 		QStringList segmentCounts;
 		for (const auto& ribbon : model->getRibbonAdaptors()) {
-			segmentCounts.push_back(QString::number(ribbon->getSegments().size()));
+			segmentCounts.push_back(QString::number(ribbon->getSegmentCount()));
 		}
 		item->setText(3, segmentCounts.join(" / "));
 	}
@@ -476,6 +591,7 @@ void DevTools::geosetOverrideChange(QTreeWidgetItem* item, Qt::CheckState state)
 			//	}, model->getAttachments().at(relation_index)->modelData);
 		}
 
+		scene->requestRedraw();
 		updatingGeosets = false;
 	}
 }
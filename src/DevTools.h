@@ -4,6 +4,7 @@
 #include "ui_DevTools.h"
 #include "core/modeling/Model.h"
 #include "WidgetUsesScene.h"
+#include "RenderWidget.h"
 
 
 class DevTools : public QMainWindow, public WidgetUsesScene
@@ -11,7 +12,7 @@ class DevTools : public QMainWindow, public WidgetUsesScene
 	Q_OBJECT
 
 public:
-	DevTools(QWidget *parent = nullptr);
+	DevTools(RenderWidget* render_widget, QWidget *parent = nullptr);
 	~DevTools();
 
 	void onSceneLoaded(core::Scene* new_scene) override;
@@ -27,6 +28,8 @@ private:
 	void updateGeosets();
 	void updateAttachments();
 	void updateTextures();
+	void updateProfiler();
+	void updateRenderStats();
 
 	QTreeWidgetItem* createGeosetTreeNode(const core::ModelGeosetInfo* geoset_info, const core::M2Model* raw, QString name);
 	QTreeWidgetItem* createGeosetAttachmentTreeNode(const core::ModelGeosetInfo* geoset_info, const core::M2Model* raw, QString name, int relation_index);
@@ -35,10 +38,12 @@ private:
 	void geosetOverrideChange(QTreeWidgetItem* item, Qt::CheckState state);
 
 	core::Model* model;
+	RenderWidget* renderWidget;
 
 	bool updatingGeosets;
 
 	QTimer* observeTimer;
+	QTimer* profilerTimer;
 
 
 	std::multimap<uint16_t, QTreeWidgetItem*> checkboxes_by_geoset_id;
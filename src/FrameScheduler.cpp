@@ -0,0 +1,80 @@
+#include "stdafx.h"
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler(QObject* parent, int32_t target_fps)
+	: QObject(parent),
+	targetFrameRate(std::max(target_fps, 1)),
+	frameTimeMsecs(0.0),
+	active(false),
+	dirty(true),
+	pending(false),
+	idle(false)
+{
+	timer = new QTimer(this);
+	timer->setSingleShot(true);
+	timer->setTimerType(Qt::PreciseTimer);
+	connect(timer, &QTimer::timeout, [&]() {
+		dirty = false;
+		pending = true;
+		sinceRequest.start();
+		emit frameRequested();
+	});
+
+	schedule();
+}
+
+FrameScheduler::~FrameScheduler()
+{}
+
+void FrameScheduler::invalidate()
+{
+	dirty = true;
+	schedule();
+}
+
+void FrameScheduler::setActive(bool value)
+{
+	active = value;
+	schedule();
+}
+
+void FrameScheduler::framePresented()
+{
+	if (sincePresent.isValid()) {
+		const double elapsed = sincePresent.nsecsElapsed() / 1000000.0;
+		frameTimeMsecs = frameTimeMsecs > 0.0 ? (frameTimeMsecs * 0.9) + (elapsed * 0.1) : elapsed;
+	}
+	sincePresent.start();
+
+	pending = false;
+	schedule();
+}
+
+void FrameScheduler::setTargetFrameRate(int32_t fps)
+{
+	targetFrameRate = std::max(fps, 1);
+}
+
+void FrameScheduler::schedule()
+{
+	if (pending || timer->isActive()) {
+		return;
+	}
+
+	if (!active && !dirty) {
+		idle = true;
+		return;
+	}
+
+	if (idle) {
+		idle = false;
+		// time spent idle isnt a frame time.
+		sincePresent.invalidate();
+		emit resumed();
+	}
+
+	// presenting already waited on vsync, only wait out whatever remains of the target frame time.
+	const int64_t interval = 1000 / targetFrameRate;
+	const int64_t elapsed = sinceRequest.isValid() ? sinceRequest.elapsed() : interval;
+	timer->start(dirty && !active ? 0 : (int)std::max<int64_t>(interval - elapsed, 0));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <cstdint>
+
+class QTimer;
+
+/// <summary>
+/// Decides when the render widget produces a frame, so nothing is drawn while the scene is still.
+/// Frames are requested continuously while active (e.g models animating), one at a time when invalidated, and not at all otherwise.
+/// The next frame is only requested once the last has been presented, so with vsync enabled the display paces drawing, capped at the target frame rate.
+/// </summary>
+class FrameScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	FrameScheduler(QObject* parent, int32_t target_fps);
+	~FrameScheduler();
+
+	// something changed that needs one more frame drawing.
+	void invalidate();
+
+	// whether frames are needed continuously, re-evaluated after each frame.
+	void setActive(bool value);
+
+	// called each time the widget presents a frame, including those Qt requested itself.
+	void framePresented();
+
+	bool isIdle() const {
+		return idle;
+	}
+
+	int32_t getTargetFrameRate() const {
+		return targetFrameRate;
+	}
+
+	void setTargetFrameRate(int32_t fps);
+
+	// smoothed time between presented frames, 0 until frames have been presented.
+	double getFrameTimeMsecs() const {
+		return frameTimeMsecs;
+	}
+
+signals:
+	void frameRequested();
+	// first frame requested after being idle, time spent idle shouldnt be simulated.
+	void resumed();
+
+private:
+	void schedule();
+
+	QTimer* timer;
+	QElapsedTimer sinceRequest;
+	QElapsedTimer sincePresent;
+
+	int32_t targetFrameRate;
+	double frameTimeMsecs;
+	bool active;
+	bool dirty;
+	// requested but not yet presented.
+	bool pending;
+	bool idle;
+};
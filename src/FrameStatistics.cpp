@@ -0,0 +1,283 @@
+#include "stdafx.h"
+#include "FrameStatistics.h"
+#include "core/utility/Logger.h"
+
+using namespace core;
+
+FrameStatistics::FrameStatistics() :
+	enabled(false),
+	timerQueries(false),
+	primitiveQueries(false),
+	active(nullptr),
+	frameIndex(0)
+{
+}
+
+FrameStatistics::~FrameStatistics()
+{
+	stopRecording();
+
+	for (auto& slot : slots) {
+		if (!slot.queries.empty()) {
+			glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+		}
+
+		if (slot.primitivesQuery != 0) {
+			glDeleteQueries(1, &slot.primitivesQuery);
+		}
+	}
+}
+
+void FrameStatistics::initialise()
+{
+	timerQueries = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+	primitiveQueries = GLEW_VERSION_3_0;
+
+	if (!timerQueries) {
+		Log::message("GPU frame timings unavailable, requires GL_ARB_timer_query.");
+	}
+
+	if (primitiveQueries) {
+		for (auto& slot : slots) {
+			glGenQueries(1, &slot.primitivesQuery);
+		}
+	}
+}
+
+const char* FrameStatistics::getPhaseName(Phase phase)
+{
+	switch (phase) {
+	case PHASE_GRID:
+		return "Grid";
+	case PHASE_MODELS:
+		return "Models";
+	case PHASE_ATTACHMENTS:
+		return "Attachments";
+	case PHASE_BOUNDS:
+		return "Bounds";
+	case PHASE_RENDER_QUEUE:
+		return "Render Queue";
+	case PHASE_PARTICLES:
+		return "Particles";
+	default:
+		assert(false);
+		return "";
+	}
+}
+
+void FrameStatistics::setEnabled(bool value)
+{
+	if (enabled == value) {
+		return;
+	}
+
+	enabled = value;
+
+	if (!enabled) {
+		// results of frames in flight would be stale by the time collection is enabled again.
+		for (auto& slot : slots) {
+			slot.pending = false;
+		}
+		latest = Frame();
+	}
+}
+
+void FrameStatistics::beginFrame()
+{
+	if (!enabled) {
+		return;
+	}
+
+	auto& slot = slots[frameIndex % RING_SIZE];
+
+	if (slot.pending && !resolve(slot)) {
+		// the gpu is more than a ring behind, drop the frame rather than waiting on it.
+		slot.pending = false;
+	}
+
+	slot.used = 0;
+	slot.phases.clear();
+	active = &slot;
+	phaseStack.clear();
+
+	current = Frame();
+	current.index = frameIndex;
+
+	if (primitiveQueries) {
+		glBeginQuery(GL_PRIMITIVES_GENERATED, slot.primitivesQuery);
+	}
+}
+
+void FrameStatistics::endFrame(double cpu_msecs)
+{
+	if (!enabled || active == nullptr) {
+		return;
+	}
+
+	while (!phaseStack.empty()) {
+		endPhase();
+	}
+
+	if (primitiveQueries) {
+		glEndQuery(GL_PRIMITIVES_GENERATED);
+	}
+
+	current.cpuMsecs = cpu_msecs;
+	active->frame = current;
+	active->pending = true;
+	active = nullptr;
+	frameIndex++;
+
+	// read whatever has completed since, oldest first.
+	for (size_t i = 0; i < RING_SIZE; i++) {
+		auto& slot = slots[(frameIndex + i) % RING_SIZE];
+		if (slot.pending && !resolve(slot)) {
+			break;
+		}
+	}
+}
+
+void FrameStatistics::beginPhase(Phase phase)
+{
+	if (!enabled || active == nullptr) {
+		return;
+	}
+
+	// only one elapsed time query can be active, so the outer phase pauses.
+	if (!phaseStack.empty()) {
+		stopQuery();
+	}
+
+	phaseStack.push_back(phase);
+	startQuery(phase);
+}
+
+void FrameStatistics::endPhase()
+{
+	if (!enabled || active == nullptr || phaseStack.empty()) {
+		return;
+	}
+
+	stopQuery();
+	phaseStack.pop_back();
+
+	if (!phaseStack.empty()) {
+		startQuery(phaseStack.back());
+	}
+}
+
+bool FrameStatistics::startRecording(const QString& path)
+{
+	stopRecording();
+
+	auto file = std::make_unique<QFile>(path);
+	if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		Log::message(QString("Unable to record frame statistics to %1").arg(path));
+		return false;
+	}
+
+	recording = std::move(file);
+	recordingStream.setDevice(recording.get());
+
+	recordingStream << "frame,cpu_ms,gpu_ms";
+	for (uint32_t phase = 0; phase < PHASE_COUNT; phase++) {
+		recordingStream << "," << QString(getPhaseName((Phase)phase)).toLower().replace(' ', '_') << "_ms";
+	}
+	recordingStream << ",primitives,draws,texture_binds,state_changes\n";
+
+	return true;
+}
+
+void FrameStatistics::stopRecording()
+{
+	if (recording == nullptr) {
+		return;
+	}
+
+	recordingStream.flush();
+	recordingStream.setDevice(nullptr);
+	recording->close();
+	recording.reset();
+}
+
+void FrameStatistics::startQuery(Phase phase)
+{
+	if (!timerQueries) {
+		return;
+	}
+
+	auto& slot = *active;
+	if (slot.used == slot.queries.size()) {
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		slot.queries.push_back(query);
+	}
+
+	slot.phases.push_back(phase);
+	glBeginQuery(GL_TIME_ELAPSED, slot.queries[slot.used++]);
+}
+
+void FrameStatistics::stopQuery()
+{
+	if (!timerQueries) {
+		return;
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+}
+
+bool FrameStatistics::resolve(Slot& slot)
+{
+	const auto is_available = [](GLuint query) {
+		GLuint available = GL_TRUE;
+		if (query != 0) {
+			glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		}
+		return available == GL_TRUE;
+	};
+
+	// timer queries complete in order, so the last of the frame being available means all are.
+	// the primitives query ends after them and is checked too, reading a result that isnt available would wait on it.
+	if (slot.used > 0 && !is_available(slot.queries[slot.used - 1])) {
+		return false;
+	}
+
+	if (primitiveQueries && !is_available(slot.primitivesQuery)) {
+		return false;
+	}
+
+	Frame frame = slot.frame;
+
+	for (size_t i = 0; i < slot.used; i++) {
+		GLuint64 nsecs = 0;
+		glGetQueryObjectui64v(slot.queries[i], GL_QUERY_RESULT, &nsecs);
+		const double msecs = nsecs / 1000000.0;
+		frame.gpuMsecs[slot.phases[i]] += msecs;
+		frame.gpuTotalMsecs += msecs;
+	}
+
+	if (primitiveQueries) {
+		GLuint primitives = 0;
+		glGetQueryObjectuiv(slot.primitivesQuery, GL_QUERY_RESULT, &primitives);
+		frame.primitives = primitives;
+	}
+
+	slot.pending = false;
+	latest = frame;
+	record(frame);
+
+	return true;
+}
+
+void FrameStatistics::record(const Frame& frame)
+{
+	if (recording == nullptr) {
+		return;
+	}
+
+	recordingStream << frame.index << "," << frame.cpuMsecs << "," << frame.gpuTotalMsecs;
+	for (const auto msecs : frame.gpuMsecs) {
+		recordingStream << "," << msecs;
+	}
+	recordingStream << "," << frame.primitives << "," << frame.draws << "," << frame.textureBinds << "," << frame.stateChanges << "\n";
+}
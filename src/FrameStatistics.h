@@ -0,0 +1,153 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <QFile>
+#include <QTextStream>
+
+/// <summary>
+/// Per frame gpu timings and submission counts for the render widget.
+/// Phases are timed with GL_TIME_ELAPSED queries, primitives with a GL_PRIMITIVES_GENERATED query over the whole frame.
+/// Queries are kept in a ring of frames and only read once their results are available, so collecting never stalls the pipeline,
+/// results are reported a few frames after they were drawn.
+/// Draws, texture binds and state changes are counted by the callers.
+/// </summary>
+class FrameStatistics
+{
+public:
+
+	enum Phase : uint32_t {
+		PHASE_GRID,
+		PHASE_MODELS,
+		PHASE_ATTACHMENTS,
+		PHASE_BOUNDS,
+		PHASE_RENDER_QUEUE,
+		PHASE_PARTICLES,
+		PHASE_COUNT
+	};
+
+	static const char* getPhaseName(Phase phase);
+
+	struct Frame {
+		uint64_t index = 0;
+		// time spent in paintGL.
+		double cpuMsecs = 0.0;
+		// zero when timer queries arent supported.
+		std::array<double, PHASE_COUNT> gpuMsecs = {};
+		double gpuTotalMsecs = 0.0;
+		uint64_t primitives = 0;
+		uint32_t draws = 0;
+		uint32_t textureBinds = 0;
+		uint32_t stateChanges = 0;
+	};
+
+	class ScopedPhase {
+	public:
+		ScopedPhase(FrameStatistics& _statistics, Phase phase) :
+			statistics(_statistics) {
+			statistics.beginPhase(phase);
+		}
+		ScopedPhase(const ScopedPhase&) = delete;
+
+		~ScopedPhase() {
+			statistics.endPhase();
+		}
+
+	protected:
+		FrameStatistics& statistics;
+	};
+
+	FrameStatistics();
+	FrameStatistics(const FrameStatistics&) = delete;
+
+	// the context must be current.
+	~FrameStatistics();
+
+	// detect query support, counts are still collected without it.
+	void initialise();
+
+	// nothing is collected while disabled.
+	void setEnabled(bool value);
+
+	bool isEnabled() const {
+		return enabled;
+	}
+
+	bool hasGpuTimes() const {
+		return timerQueries;
+	}
+
+	void beginFrame();
+	void endFrame(double cpu_msecs);
+
+	// phases may nest, the inner phase is timed instead of the outer until it ends.
+	void beginPhase(Phase phase);
+	void endPhase();
+
+	void countDraws(uint32_t count = 1) {
+		if (enabled) {
+			current.draws += count;
+		}
+	}
+
+	void countTextureBinds(uint32_t count = 1) {
+		if (enabled) {
+			current.textureBinds += count;
+		}
+	}
+
+	void countStateChanges(uint32_t count) {
+		if (enabled) {
+			current.stateChanges += count;
+		}
+	}
+
+	// most recent frame with results available.
+	const Frame& getLatest() const {
+		return latest;
+	}
+
+	// appends a line for each frame as its results become available, until stopped.
+	bool startRecording(const QString& path);
+	void stopRecording();
+
+	bool isRecording() const {
+		return recording != nullptr;
+	}
+
+protected:
+
+	// frames in flight before their queries are read.
+	static constexpr size_t RING_SIZE = 4;
+
+	struct Slot {
+		std::vector<GLuint> queries;
+		std::vector<Phase> phases;
+		size_t used = 0;
+		GLuint primitivesQuery = 0;
+		bool pending = false;
+		Frame frame;
+	};
+
+	void startQuery(Phase phase);
+	void stopQuery();
+	// false when the results of the slot arent available yet.
+	bool resolve(Slot& slot);
+	void record(const Frame& frame);
+
+	bool enabled;
+	bool timerQueries;
+	bool primitiveQueries;
+
+	std::array<Slot, RING_SIZE> slots;
+	Slot* active;
+	std::vector<Phase> phaseStack;
+	uint64_t frameIndex;
+
+	Frame current;
+	Frame latest;
+
+	std::unique_ptr<QFile> recording;
+	QTextStream recordingStream;
+};
@@ -0,0 +1,462 @@
+#include "stdafx.h"
+#include "GpuSkinning.h"
+#include "core/utility/Logger.h"
+
+using namespace core;
+
+const char* GpuSkinning::SKINNING_SHADER = R"(
+uniform samplerBuffer palette;
+
+mat4 fetchMatrix(int index) {
+	// rows are stored, so the column constructed matrix needs transposing.
+	return transpose(mat4(
+		texelFetch(palette, index),
+		texelFetch(palette, index + 1),
+		texelFetch(palette, index + 2),
+		texelFetch(palette, index + 3)
+	));
+}
+
+// mirrors ModelAnimationInfo::updateAnimation.
+void skin(vec3 position, vec3 normal, vec4 bones, vec4 weights, int palette_offset, out vec3 skinned_position, out vec3 skinned_normal) {
+	skinned_position = vec3(0.0);
+	skinned_normal = vec3(0.0);
+
+	for (int i = 0; i < 4; i++) {
+		if (weights[i] > 0.0) {
+			int index = palette_offset + (int(bones[i]) * PALETTE_STRIDE);
+			skinned_position += (fetchMatrix(index) * vec4(position, 1.0)).xyz * weights[i];
+			skinned_normal += (fetchMatrix(index + 4) * vec4(normal, 0.0)).xyz * weights[i];
+		}
+	}
+}
+)";
+
+namespace {
+
+	// captures the skinned vertices rather than drawing them.
+	const char* COMPARE_SHADER = R"(
+in vec3 position;
+in vec3 normal;
+in vec4 bones;
+in vec4 weights;
+
+uniform int paletteOffset;
+
+out vec3 skinnedPosition;
+out vec3 skinnedNormal;
+
+void main() {
+	skin(position, normal, bones, weights, paletteOffset, skinnedPosition, skinnedNormal);
+}
+)";
+
+}
+
+GpuSkinning::GpuSkinning() :
+	paletteBuffer(0),
+	paletteTexture(0),
+	paletteCapacity(0),
+	paletteFull(false),
+	compareProgram(0),
+	compareVertexArray(0),
+	comparePaletteOffset(-1)
+{
+}
+
+GpuSkinning::~GpuSkinning()
+{
+	for (auto& [id, mesh] : meshes) {
+		release(mesh);
+	}
+
+	for (auto& [id, mesh] : skinnedMeshes) {
+		release(mesh);
+	}
+
+	if (paletteTexture != 0) {
+		glDeleteTextures(1, &paletteTexture);
+	}
+
+	if (paletteBuffer != 0) {
+		glDeleteBuffers(1, &paletteBuffer);
+	}
+
+	if (compareVertexArray != 0) {
+		glDeleteVertexArrays(1, &compareVertexArray);
+	}
+
+	if (compareProgram != 0) {
+		glDeleteProgram(compareProgram);
+	}
+}
+
+bool GpuSkinning::initialise()
+{
+	if (!GLEW_VERSION_3_2 || !GLEW_ARB_texture_buffer_object) {
+		Log::message("GPU skinning unavailable, requires OpenGL 3.2.");
+		return false;
+	}
+
+	GLint max_texels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+	paletteCapacity = (size_t)std::max(max_texels, 0);
+
+	glGenBuffers(1, &paletteBuffer);
+	glGenTextures(1, &paletteTexture);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, paletteBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, PALETTE_STRIDE * 4 * sizeof(float), nullptr, GL_STREAM_DRAW);
+	glBindTexture(GL_TEXTURE_BUFFER, paletteTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, paletteBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	return true;
+}
+
+std::optional<GpuSkinning::Binding> GpuSkinning::prepare(const ModelAnimationInfo* component, const M2Model* model)
+{
+	assert(paletteTexture != 0);
+	paletteFull = false;
+
+	if (model->getBonePalette().size() == 0) {
+		return std::nullopt;
+	}
+
+	const auto* mesh = findMesh(component, model);
+	if (mesh == nullptr) {
+		return std::nullopt;
+	}
+
+	component->getSkinningPalette(mat, mrot);
+	assert(mat.size() == mrot.size());
+
+	const auto offset = allocatePalette(mat.size());
+	if (!offset.has_value()) {
+		return std::nullopt;
+	}
+
+	for (size_t i = 0; i < mat.size(); i++) {
+		float* dest = &palette[(offset.value() + (i * PALETTE_STRIDE)) * 4];
+		std::memcpy(dest, &mat[i].m[0][0], sizeof(float) * 16);
+		std::memcpy(dest + 16, &mrot[i].m[0][0], sizeof(float) * 16);
+	}
+
+	Binding binding;
+	binding.mesh = mesh;
+	binding.paletteOffset = (GLint)offset.value();
+	return binding;
+}
+
+std::optional<GpuSkinning::Binding> GpuSkinning::prepareSkinned(const ModelAnimationInfo* component, const M2Model* model)
+{
+	assert(paletteTexture != 0);
+	paletteFull = false;
+
+	const auto& positions = component->animatedVertices;
+	const auto& normals = component->animatedNormals;
+	if (positions.empty() || positions.size() != normals.size()) {
+		return std::nullopt;
+	}
+
+	auto* mesh = findSkinnedMesh(component, model);
+	if (mesh == nullptr) {
+		return std::nullopt;
+	}
+
+	if (!identityOffset.has_value()) {
+		const auto offset = allocatePalette(1);
+		if (!offset.has_value()) {
+			return std::nullopt;
+		}
+
+		const Matrix identity = Matrix::identity();
+		float* dest = &palette[offset.value() * 4];
+		std::memcpy(dest, &identity.m[0][0], sizeof(float) * 16);
+		std::memcpy(dest + 16, &identity.m[0][0], sizeof(float) * 16);
+		identityOffset = (GLint)offset.value();
+	}
+
+	// orphan the previous contents rather than waiting on draws still using them.
+	const size_t size = positions.size() * sizeof(Vector3);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh->streamBuffer);
+	glBufferData(GL_ARRAY_BUFFER, size * 2, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, size, positions.data());
+	glBufferSubData(GL_ARRAY_BUFFER, size, size, normals.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	mesh->streamNormalOffset = size;
+
+	Binding binding;
+	binding.mesh = mesh;
+	binding.paletteOffset = identityOffset.value();
+	return binding;
+}
+
+std::optional<size_t> GpuSkinning::allocatePalette(size_t entries)
+{
+	const size_t offset = palette.size() / 4;
+	if (offset + (entries * PALETTE_STRIDE) > paletteCapacity) {
+		paletteFull = !palette.empty();
+		return std::nullopt;
+	}
+
+	palette.resize(palette.size() + (entries * PALETTE_STRIDE * 4));
+	return offset;
+}
+
+void GpuSkinning::begin()
+{
+	// orphan the previous contents rather than waiting on draws still using them.
+	glBindBuffer(GL_TEXTURE_BUFFER, paletteBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, palette.size() * sizeof(float), palette.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE0 + PALETTE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, paletteTexture);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void GpuSkinning::bind(const Mesh& mesh)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+
+	constexpr GLsizei stride = sizeof(SkinningVertex);
+	glVertexAttribPointer(ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinningVertex, position));
+	glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinningVertex, normal));
+	glVertexAttribPointer(ATTRIBUTE_TEXTURE_COORDS, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinningVertex, textureCoords));
+	glVertexAttribPointer(ATTRIBUTE_BONES, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinningVertex, bones));
+	glVertexAttribPointer(ATTRIBUTE_WEIGHTS, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(SkinningVertex, weights));
+
+	if (mesh.streamBuffer != 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, mesh.streamBuffer);
+		glVertexAttribPointer(ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+		glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, (void*)mesh.streamNormalOffset);
+	}
+}
+
+void GpuSkinning::end()
+{
+	// the rest of the renderer uses client side arrays.
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE0 + PALETTE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	palette.clear();
+	identityOffset.reset();
+	paletteFull = false;
+}
+
+void GpuSkinning::collect()
+{
+	const auto collect_unused = [this](auto& entry) -> bool {
+		if (!entry.second.used) {
+			release(entry.second);
+			return true;
+		}
+
+		entry.second.used = false;
+		return false;
+	};
+
+	std::erase_if(meshes, collect_unused);
+	std::erase_if(skinnedMeshes, collect_unused);
+}
+
+std::optional<float> GpuSkinning::compare(ModelAnimationInfo* component, const M2Model* model)
+{
+	assert(palette.empty());
+
+	if (compareProgram == 0) {
+		const std::string source = "#version 150\n#define PALETTE_STRIDE " + std::to_string(PALETTE_STRIDE) + "\n" + SKINNING_SHADER + COMPARE_SHADER;
+		const char* source_ptr = source.c_str();
+
+		GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(shader, 1, &source_ptr, nullptr);
+		glCompileShader(shader);
+
+		compareProgram = glCreateProgram();
+		glAttachShader(compareProgram, shader);
+		glBindAttribLocation(compareProgram, ATTRIBUTE_POSITION, "position");
+		glBindAttribLocation(compareProgram, ATTRIBUTE_NORMAL, "normal");
+		glBindAttribLocation(compareProgram, ATTRIBUTE_BONES, "bones");
+		glBindAttribLocation(compareProgram, ATTRIBUTE_WEIGHTS, "weights");
+
+		const char* varyings[] = { "skinnedPosition", "skinnedNormal" };
+		glTransformFeedbackVaryings(compareProgram, 2, varyings, GL_INTERLEAVED_ATTRIBS);
+		glLinkProgram(compareProgram);
+		glDeleteShader(shader);
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(compareProgram, GL_LINK_STATUS, &status);
+		if (status != GL_TRUE) {
+			GLchar info[1024] = {};
+			glGetProgramInfoLog(compareProgram, sizeof(info), nullptr, info);
+			Log::message(QString("Skinning comparison shader failed to link: %1").arg(info));
+			return std::nullopt;
+		}
+
+		glUseProgram(compareProgram);
+		glUniform1i(glGetUniformLocation(compareProgram, "palette"), PALETTE_UNIT);
+		comparePaletteOffset = glGetUniformLocation(compareProgram, "paletteOffset");
+		glUseProgram(0);
+
+		glGenVertexArrays(1, &compareVertexArray);
+		glBindVertexArray(compareVertexArray);
+		glEnableVertexAttribArray(ATTRIBUTE_POSITION);
+		glEnableVertexAttribArray(ATTRIBUTE_NORMAL);
+		glEnableVertexAttribArray(ATTRIBUTE_BONES);
+		glEnableVertexAttribArray(ATTRIBUTE_WEIGHTS);
+		glBindVertexArray(0);
+	}
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(compareProgram, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		return std::nullopt;
+	}
+
+	const auto binding = prepare(component, model);
+	if (!binding.has_value()) {
+		end();
+		return std::nullopt;
+	}
+
+	component->getSkinningInput(vertices);
+	const size_t count = vertices.size();
+
+	GLuint output = 0;
+	glGenBuffers(1, &output);
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, output);
+	glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, count * sizeof(Vector3) * 2, nullptr, GL_STREAM_READ);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, output);
+
+	begin();
+	glUseProgram(compareProgram);
+	glUniform1i(comparePaletteOffset, binding->paletteOffset);
+	glBindVertexArray(compareVertexArray);
+	bind(*binding->mesh);
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, (GLsizei)count);
+	glEndTransformFeedback();
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+	end();
+
+	std::vector<Vector3> skinned(count * 2);
+	glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, skinned.size() * sizeof(Vector3), skinned.data());
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+	glDeleteBuffers(1, &output);
+
+	const bool cpu_skinning = component->cpuSkinning;
+	component->cpuSkinning = true;
+	component->updateAnimation();
+	component->cpuSkinning = cpu_skinning;
+
+	if (component->animatedVertices.size() != count) {
+		return std::nullopt;
+	}
+
+	float difference = 0;
+	for (size_t i = 0; i < count; i++) {
+		difference = std::max(difference, (skinned[i * 2] - component->animatedVertices[i]).length());
+		difference = std::max(difference, (skinned[(i * 2) + 1] - component->animatedNormals[i]).length());
+	}
+
+	return difference;
+}
+
+GpuSkinning::Mesh* GpuSkinning::findMesh(const ModelAnimationInfo* component, const M2Model* model)
+{
+	const auto id = component->getSkinningInputId();
+	auto found = meshes.find(id);
+
+	if (found == meshes.end()) {
+		Mesh mesh;
+		if (!create(mesh, component, model, false)) {
+			return nullptr;
+		}
+
+		found = meshes.emplace(id, mesh).first;
+	}
+
+	found->second.used = true;
+	return &found->second;
+}
+
+GpuSkinning::Mesh* GpuSkinning::findSkinnedMesh(const ModelAnimationInfo* component, const M2Model* model)
+{
+	// ids are unique to each component, so every cpu skinned component streams into its own buffer.
+	const auto id = component->getSkinningInputId();
+	auto found = skinnedMeshes.find(id);
+
+	if (found == skinnedMeshes.end()) {
+		Mesh mesh;
+		if (!create(mesh, component, model, true)) {
+			return nullptr;
+		}
+
+		glGenBuffers(1, &mesh.streamBuffer);
+		found = skinnedMeshes.emplace(id, mesh).first;
+	}
+
+	found->second.used = true;
+	return &found->second;
+}
+
+bool GpuSkinning::create(Mesh& mesh, const ModelAnimationInfo* component, const M2Model* model, bool identity_weights)
+{
+	component->getSkinningInput(vertices);
+	const auto& indices = model->getIndices();
+
+	if (vertices.empty() || indices.empty()) {
+		return false;
+	}
+
+	if (identity_weights) {
+		for (auto& vertex : vertices) {
+			std::fill(std::begin(vertex.bones), std::end(vertex.bones), 0.0f);
+			std::fill(std::begin(vertex.weights), std::end(vertex.weights), 0.0f);
+			vertex.weights[0] = 1.0f;
+		}
+	}
+
+	glGenBuffers(1, &mesh.vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(SkinningVertex), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenBuffers(1, &mesh.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	return true;
+}
+
+void GpuSkinning::release(Mesh& mesh)
+{
+	if (mesh.vertexBuffer != 0) {
+		glDeleteBuffers(1, &mesh.vertexBuffer);
+		mesh.vertexBuffer = 0;
+	}
+
+	if (mesh.indexBuffer != 0) {
+		glDeleteBuffers(1, &mesh.indexBuffer);
+		mesh.indexBuffer = 0;
+	}
+
+	if (mesh.streamBuffer != 0) {
+		glDeleteBuffers(1, &mesh.streamBuffer);
+		mesh.streamBuffer = 0;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <map>
+#include <optional>
+#include <vector>
+#include "core/modeling/ModelSupport.h"
+#include "core/modeling/M2.h"
+
+/// <summary>
+/// Gpu side data for vertex shader skinning, used by the render widget in place of ModelAnimationInfo::updateAnimation.
+/// Bind pose vertices, bone indices and weights are uploaded once per component, only the bone palettes are uploaded each frame.
+/// The palettes of every component drawn in a frame share one texture buffer, so draws from different components can be submitted in any order.
+/// Components skinned on the cpu are drawn by the same shaders, their skinned vertices are streamed each frame
+/// and weighted fully to an identity palette entry.
+/// The shaders consuming the data are owned by ShaderPassRenderer.
+/// </summary>
+class GpuSkinning
+{
+public:
+
+	// vertex attribute locations shaders must bind their inputs to.
+	enum Attribute : GLuint {
+		ATTRIBUTE_POSITION,
+		ATTRIBUTE_NORMAL,
+		ATTRIBUTE_TEXTURE_COORDS,
+		ATTRIBUTE_BONES,
+		ATTRIBUTE_WEIGHTS
+	};
+
+	// texture unit the palette is bound to, unit 0 is left for the pass textures.
+	static constexpr GLint PALETTE_UNIT = 1;
+
+	// texels per palette entry, the rows of the bone matrix followed by the rows of its rotation matrix.
+	static constexpr GLint PALETTE_STRIDE = 8;
+
+	// glsl declaring the 'palette' sampler and skin(), shared by every shader skinning vertices, expects PALETTE_STRIDE to be defined.
+	static const char* SKINNING_SHADER;
+
+	struct Mesh {
+		GLuint vertexBuffer = 0;
+		GLuint indexBuffer = 0;
+		// positions then normals of cpu skinned components, replacing those of the vertex buffer.
+		GLuint streamBuffer = 0;
+		size_t streamNormalOffset = 0;
+		bool used = false;
+	};
+
+	// what a draw of the component needs bound.
+	struct Binding {
+		const Mesh* mesh = nullptr;
+		// first texel of the component palette.
+		GLint paletteOffset = 0;
+	};
+
+	GpuSkinning();
+	GpuSkinning(const GpuSkinning&) = delete;
+
+	// the context must be current.
+	~GpuSkinning();
+
+	// create the palette buffer, false when the context lacks the features needed.
+	bool initialise();
+
+	// append the current palette of the component to the pending palettes, returns nothing when it cannot be drawn.
+	// passes are drawn with glDrawElements, using offsets into the model indices.
+	std::optional<Binding> prepare(const core::ModelAnimationInfo* component, const core::M2Model* model);
+
+	// as prepare, for a component skinned by ModelAnimationInfo::updateAnimation, its animated vertices are uploaded immediately.
+	std::optional<Binding> prepareSkinned(const core::ModelAnimationInfo* component, const core::M2Model* model);
+
+	// true when prepare failed because the pending palettes would exceed the texture buffer size, draw and clear them before retrying.
+	bool isPaletteFull() const {
+		return paletteFull;
+	}
+
+	// upload and bind the pending palettes, meshes can then be bound.
+	void begin();
+
+	// points the attributes of the bound vertex array at the mesh, see ShaderPassRenderer.
+	static void bind(const Mesh& mesh);
+
+	// unbind and clear the pending palettes.
+	void end();
+
+	// release the buffers of components that havent been drawn since the last collect.
+	void collect();
+
+	// skin the component with SKINNING_SHADER through transform feedback, and again with ModelAnimationInfo::updateAnimation.
+	// returns the largest difference between the two, or nothing when the component cannot be gpu skinned.
+	// the component must skin with its own bones, merged models skin with those of their owner.
+	// called outside of begin and end, the cpu skinned vertices of the component are left updated.
+	std::optional<float> compare(core::ModelAnimationInfo* component, const core::M2Model* model);
+
+protected:
+
+	Mesh* findMesh(const core::ModelAnimationInfo* component, const core::M2Model* model);
+	Mesh* findSkinnedMesh(const core::ModelAnimationInfo* component, const core::M2Model* model);
+	// vertex and index buffers from the skinning input, with weights overridden by 'identity_weights' when set.
+	bool create(Mesh& mesh, const core::ModelAnimationInfo* component, const core::M2Model* model, bool identity_weights);
+	void release(Mesh& mesh);
+
+	// reserve space in the pending palettes, returns the texel offset or nothing when full.
+	std::optional<size_t> allocatePalette(size_t entries);
+
+	GLuint paletteBuffer;
+	GLuint paletteTexture;
+	// in texels, from GL_MAX_TEXTURE_BUFFER_SIZE.
+	size_t paletteCapacity;
+	bool paletteFull;
+
+	// keyed by ModelAnimationInfo::getSkinningInputId.
+	std::map<uint64_t, Mesh> meshes;
+	std::map<uint64_t, Mesh> skinnedMeshes;
+
+	// created by the first compare.
+	GLuint compareProgram;
+	GLuint compareVertexArray;
+	GLint comparePaletteOffset;
+
+	// pending palettes, uploaded together by begin.
+	std::vector<float> palette;
+	// shared by the cpu skinned components of the pending palettes, added with the first of them.
+	std::optional<GLint> identityOffset;
+
+	// scratch space, reused between components.
+	std::vector<core::SkinningVertex> vertices;
+	std::vector<core::Matrix> mat;
+	std::vector<core::Matrix> mrot;
+};
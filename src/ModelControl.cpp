@@ -31,6 +31,7 @@ ModelControl::ModelControl(QWidget* parent)
 			ui.doubleSpinBoxScaleX->setValue(model->modelOptions.scale.x);
 			ui.doubleSpinBoxScaleY->setValue(model->modelOptions.scale.y);
 			ui.doubleSpinBoxScaleZ->setValue(model->modelOptions.scale.z);
+			scene->requestRedraw();
 		}
 	});
 
@@ -39,6 +40,7 @@ ModelControl::ModelControl(QWidget* parent)
 		if (model != nullptr && lock.owns_lock()) {
 			model->modelOptions.scale.x = (float)val;
 			ui.horizontalSliderScale->setValue(model->modelOptions.scale.max() * 10.f);
+			scene->requestRedraw();
 		}
 	});
 
@@ -47,6 +49,7 @@ ModelControl::ModelControl(QWidget* parent)
 		if (model != nullptr && lock.owns_lock()) {
 			model->modelOptions.scale.y = (float)val;
 			ui.horizontalSliderScale->setValue(model->modelOptions.scale.max() * 10.f);
+			scene->requestRedraw();
 		}
 	});
 
@@ -55,42 +58,49 @@ ModelControl::ModelControl(QWidget* parent)
 		if (model != nullptr && lock.owns_lock()) {
 			model->modelOptions.scale.z = (float)val;
 			ui.horizontalSliderScale->setValue(model->modelOptions.scale.max() * 10.f);
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.doubleSpinBoxPositionX, &QDoubleSpinBox::valueChanged, [&](double val) {
 		if (model != nullptr) {
 			model->modelOptions.position.x = (float)val;
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.doubleSpinBoxPositionY, &QDoubleSpinBox::valueChanged, [&](double val) {
 		if (model != nullptr) {
 			model->modelOptions.position.y = (float)val;
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.doubleSpinBoxPositionZ, &QDoubleSpinBox::valueChanged, [&](double val) {
 		if (model != nullptr) {
 			model->modelOptions.position.z = (float)val;
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.doubleSpinBoxYaw, &QDoubleSpinBox::valueChanged, [&](double val) {
 		if (model != nullptr) {
 			model->modelOptions.rotation.z = (float)val;
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.doubleSpinBoxPitch, &QDoubleSpinBox::valueChanged, [&](double val) {
 		if (model != nullptr) {
 			model->modelOptions.rotation.y = (float)val;
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.doubleSpinBoxRoll, &QDoubleSpinBox::valueChanged, [&](double val) {
 		if (model != nullptr) {
 			model->modelOptions.rotation.x = (float)val;
+			scene->requestRedraw();
 		}
 	});
 
@@ -126,6 +136,8 @@ ModelControl::ModelControl(QWidget* parent)
 					break;
 				}
 			}
+
+			scene->requestRedraw();
 		}
 	});
 
@@ -5,30 +5,24 @@
 using namespace core;
 
 
-bool ModelRenderPassRenderer::start(const RenderOptions& renderOptions, 
-	const ModelTextureInfo* textureInfo, 
-	const M2Model* model,
-	std::optional<size_t> animation_index,
-	const ModelRenderPass& pass,
-	const core::AnimationTickArgs& tick)
+std::optional<ModelRenderPassRenderer::PassColor> ModelRenderPassRenderer::calculateColor(const RenderOptions& renderOptions,
+	const MaterialAnimationState& materials,
+	const ModelRenderPass& pass)
 {
 	// COLOUR
 	// Get the colour and transparency and check that we should even render
 	auto ocol = Vector4(1.0f, 1.0f, 1.0f, renderOptions.opacity);
 	auto ecol = Vector4(0.0f, 0.0f, 0.0f, 0.0f);
+	bool has_emission = false;
 
 	//TODO check colour and opacity logic
 	if (pass.color != -1) {
-		const auto& colors = model->getColorAdaptors();
-		if (colors.size() > pass.color && colors[pass.color]->colorUses(0)) {
-			Vector3 c;
-
-			c = colors[pass.color]->colorValue(0, tick);
+		const auto* color = materials.getColor(pass.color);
+		if (color != nullptr) {
+			const Vector3& c = color->color;
 
-			if (animation_index.has_value()) {
-				if (colors[pass.color]->opacityUses(animation_index.value())) {
-					ocol.w = colors[pass.color]->opacityValue(animation_index.value(), tick);
-				}
+			if (color->opacityAnimated) {
+				ocol.w = color->opacity;
 			}
 			
 			// old WMV had this check, not sure why, seems to cause some models to appear back
@@ -43,22 +37,48 @@ bool ModelRenderPassRenderer::start(const RenderOptions& renderOptions,
 			ocol.x = c.x; ocol.y = c.y; ocol.z = c.z;
 
 			ecol = Vector4(c, ocol.w);
-			glMaterialfv(GL_FRONT, GL_EMISSION, ecol);
+			has_emission = true;
 		}
 	}
 
 	if (pass.opacity != -1) {
-		const auto& transparencies = model->getTransparencyAdaptors();
-		if (transparencies.size() > pass.opacity && transparencies[pass.opacity]->transparencyUses(0)) {
-			ocol.w *= transparencies[pass.opacity]->transparencyValue(0, tick);
+		const auto* transparency = materials.getTransparency(pass.opacity);
+		if (transparency != nullptr) {
+			ocol.w *= *transparency;
 		}
 	}
 
-	// exit and return false before affecting the opengl render state
 	if (!((ocol.w > 0) && (pass.color == -1 || ecol.w > 0))) {
+		return std::nullopt;
+	}
+
+	PassColor result;
+	result.color = ocol;
+	if (has_emission) {
+		result.emission = ecol;
+	}
+
+	return result;
+}
+
+bool ModelRenderPassRenderer::start(const RenderOptions& renderOptions, 
+	const ModelTextureInfo* textureInfo, 
+	const MaterialAnimationState& materials,
+	const ModelRenderPass& pass)
+{
+	// exit and return false before affecting the opengl render state
+	const auto pass_color = calculateColor(renderOptions, materials, pass);
+	if (!pass_color.has_value()) {
 		return false;
 	}
 
+	auto ocol = pass_color->color;
+
+	if (pass_color->emission.has_value()) {
+		auto ecol = pass_color->emission.value();
+		glMaterialfv(GL_FRONT, GL_EMISSION, ecol);
+	}
+
 
 	GLuint bindtex = Texture::INVALID_ID;
 	if (renderOptions.showTexture) {
@@ -143,27 +163,25 @@ bool ModelRenderPassRenderer::start(const RenderOptions& renderOptions,
 		glMatrixMode(GL_TEXTURE);
 		glPushMatrix();
 
-		if (animation_index.has_value()) {
-			if (model->getTextureAnimationAdaptors().size() > pass.texanim) {
-				const auto* texAnim = model->getTextureAnimationAdaptors().at(pass.texanim);
-				glLoadIdentity();
-
-				if (texAnim->translationUses(animation_index.value())) {
-					const auto transVal = texAnim->translationValue(animation_index.value(), tick);
-					glTranslatef(transVal.x, transVal.y, transVal.z);
-				}
-
-				if (texAnim->rotationUses(animation_index.value())) {
-					const auto rotVal = texAnim->rotationValue(animation_index.value(), tick);
-					//TODO check logic
-					//glRotatef(rval.x, 0, 0, 1); // this is wrong, I have no idea what I'm doing here ;)
-					glRotatef(rotVal.x, 0, 0, 1);
-				}
-
-				if (texAnim->scaleUses(animation_index.value())) {
-					const auto scaleVal = texAnim->scaleValue(animation_index.value(), tick);
-					glScalef(scaleVal.x, scaleVal.y, scaleVal.z);
-				}
+		const auto* texAnim = materials.getTextureAnimation(pass.texanim);
+		if (texAnim != nullptr) {
+			glLoadIdentity();
+
+			if (texAnim->translated) {
+				const auto& transVal = texAnim->translation;
+				glTranslatef(transVal.x, transVal.y, transVal.z);
+			}
+
+			if (texAnim->rotated) {
+				const auto& rotVal = texAnim->rotation;
+				//TODO check logic
+				//glRotatef(rval.x, 0, 0, 1); // this is wrong, I have no idea what I'm doing here ;)
+				glRotatef(rotVal.x, 0, 0, 1);
+			}
+
+			if (texAnim->scaled) {
+				const auto& scaleVal = texAnim->scale;
+				glScalef(scaleVal.x, scaleVal.y, scaleVal.z);
 			}
 		}
 
@@ -2,17 +2,29 @@
 #include <optional>
 #include "core/modeling/Model.h"
 #include "core/modeling/Animation.h"
+#include "core/modeling/MaterialAnimation.h"
 
 
 class ModelRenderPassRenderer
 {
 public:
+	struct PassColor {
+		// vertex color, including opacity.
+		core::Vector4 color;
+		// only set when the pass has a color track.
+		std::optional<core::Vector4> emission;
+	};
+
+	// color of the pass for the current frame, nullopt when the pass is invisible and shouldnt be rendered.
+	static std::optional<PassColor> calculateColor(const core::RenderOptions& renderOptions,
+		const core::MaterialAnimationState& materials,
+		const core::ModelRenderPass& pass);
+
+	// materials must have been calculated for the current frame, see M2Model::calculateMaterials.
 	static bool start(const core::RenderOptions& renderOptions,
 		const core::ModelTextureInfo* textureInfo, 
-		const core::M2Model* model,
-		std::optional<size_t> animation_index,
-		const core::ModelRenderPass& pass,
-		const core::AnimationTickArgs& tick);
+		const core::MaterialAnimationState& materials,
+		const core::ModelRenderPass& pass);
 	static void finish(const core::ModelRenderPass& pass);
 };
 
@@ -0,0 +1,305 @@
+#include "stdafx.h"
+#include "ParticleRenderer.h"
+#include "core/utility/Logger.h"
+
+using namespace core;
+
+namespace {
+
+	// quads and tiles are built as RenderWidget::renderParticles and M2Model did for the immediate mode path.
+	const char* VERTEX_SHADER = R"(
+#version 330
+
+in float corner;
+in vec3 position;
+in float size;
+in vec4 color;
+in vec3 origin;
+in float tile;
+in vec3 right;
+in vec3 up;
+
+uniform mat4 modelView;
+uniform mat4 projection;
+uniform bool billboard;
+uniform bool originQuad;
+uniform vec3 cameraRight;
+uniform vec3 cameraUp;
+// columns, rows.
+uniform ivec2 tileGrid;
+uniform int cornerShift;
+
+out vec4 vertexColor;
+out vec2 texCoord;
+
+const vec2 CORNERS[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main() {
+	int index = int(corner);
+	vec3 vertex;
+
+	if (originQuad) {
+		vec3 base = index < 2 ? position : origin;
+		vec3 offset = (index == 0 || index == 3) ? vec3(-1.0, 1.0, 0.0) : vec3(1.0, 1.0, 0.0);
+		vertex = base + (offset * size);
+	}
+	else {
+		vec3 quad_right = billboard ? cameraRight : right;
+		vec3 quad_up = billboard ? cameraUp : up;
+		vertex = position + (((quad_right * CORNERS[index].x) + (quad_up * CORNERS[index].y)) * size);
+	}
+
+	gl_Position = projection * (modelView * vec4(vertex, 1.0));
+
+	int tile_index = int(tile);
+	vec2 cell = vec2(tile_index % tileGrid.x, tile_index / tileGrid.x);
+	vec2 a = cell / vec2(tileGrid);
+	vec2 b = (cell + vec2(1.0)) / vec2(tileGrid);
+	vec2 tile_coords[4] = vec2[4](a, vec2(b.x, a.y), b, vec2(a.x, b.y));
+
+	texCoord = tile_coords[(index + cornerShift) & 3];
+	vertexColor = color;
+}
+)";
+
+	const char* FRAGMENT_SHADER = R"(
+#version 330
+
+in vec4 vertexColor;
+in vec2 texCoord;
+
+uniform sampler2D texture0;
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+uniform int textureCount;
+uniform bool alphaTest;
+
+out vec4 fragColor;
+
+void main() {
+	vec4 result = vertexColor * texture(texture0, texCoord);
+
+	if (textureCount > 1) {
+		// combiner scale of the first unit, clamped as the fixed function output is.
+		result = min(result * 4.0, vec4(1.0)) * texture(texture1, texCoord);
+	}
+
+	if (textureCount > 2) {
+		result *= texture(texture2, texCoord);
+	}
+
+	if (alphaTest && result.a < 0.7) {
+		discard;
+	}
+
+	fragColor = result;
+}
+)";
+
+	GLuint compileShader(GLenum type, const char* source) {
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		GLint status = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status != GL_TRUE) {
+			GLchar info[1024] = {};
+			glGetShaderInfoLog(shader, sizeof(info), nullptr, info);
+			Log::message(QString("Particle shader failed to compile: %1").arg(info));
+			glDeleteShader(shader);
+			return 0;
+		}
+
+		return shader;
+	}
+
+	void instanceAttribute(GLuint location, GLint components, size_t offset) {
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, sizeof(ParticleRenderer::Instance), (void*)offset);
+		glVertexAttribDivisor(location, 1);
+	}
+}
+
+ParticleRenderer::ParticleRenderer() :
+	program(0),
+	cornerBuffer(0),
+	instanceBuffer(0)
+{
+}
+
+ParticleRenderer::~ParticleRenderer()
+{
+	if (program != 0) {
+		glDeleteProgram(program);
+	}
+
+	if (cornerBuffer != 0) {
+		glDeleteBuffers(1, &cornerBuffer);
+	}
+
+	if (instanceBuffer != 0) {
+		glDeleteBuffers(1, &instanceBuffer);
+	}
+}
+
+bool ParticleRenderer::initialise()
+{
+	if (!GLEW_VERSION_3_3) {
+		Log::message("Instanced particles unavailable, requires OpenGL 3.3.");
+		return false;
+	}
+
+	GLuint vertex_shader = compileShader(GL_VERTEX_SHADER, VERTEX_SHADER);
+	GLuint fragment_shader = compileShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+
+	if (vertex_shader == 0 || fragment_shader == 0) {
+		glDeleteShader(vertex_shader);
+		glDeleteShader(fragment_shader);
+		return false;
+	}
+
+	program = glCreateProgram();
+	glAttachShader(program, vertex_shader);
+	glAttachShader(program, fragment_shader);
+	glBindAttribLocation(program, ATTRIBUTE_CORNER, "corner");
+	glBindAttribLocation(program, ATTRIBUTE_POSITION, "position");
+	glBindAttribLocation(program, ATTRIBUTE_SIZE, "size");
+	glBindAttribLocation(program, ATTRIBUTE_COLOR, "color");
+	glBindAttribLocation(program, ATTRIBUTE_ORIGIN, "origin");
+	glBindAttribLocation(program, ATTRIBUTE_TILE, "tile");
+	glBindAttribLocation(program, ATTRIBUTE_RIGHT, "right");
+	glBindAttribLocation(program, ATTRIBUTE_UP, "up");
+	glBindFragDataLocation(program, 0, "fragColor");
+	glLinkProgram(program);
+	glDeleteShader(vertex_shader);
+	glDeleteShader(fragment_shader);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		GLchar info[1024] = {};
+		glGetProgramInfoLog(program, sizeof(info), nullptr, info);
+		Log::message(QString("Particle shader failed to link: %1").arg(info));
+		glDeleteProgram(program);
+		program = 0;
+		return false;
+	}
+
+	uniforms.modelView = glGetUniformLocation(program, "modelView");
+	uniforms.projection = glGetUniformLocation(program, "projection");
+	uniforms.billboard = glGetUniformLocation(program, "billboard");
+	uniforms.originQuad = glGetUniformLocation(program, "originQuad");
+	uniforms.cameraRight = glGetUniformLocation(program, "cameraRight");
+	uniforms.cameraUp = glGetUniformLocation(program, "cameraUp");
+	uniforms.tileGrid = glGetUniformLocation(program, "tileGrid");
+	uniforms.cornerShift = glGetUniformLocation(program, "cornerShift");
+	uniforms.textureCount = glGetUniformLocation(program, "textureCount");
+	uniforms.alphaTest = glGetUniformLocation(program, "alphaTest");
+
+	// samplers never change unit.
+	GLint previous = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "texture0"), 0);
+	glUniform1i(glGetUniformLocation(program, "texture1"), 1);
+	glUniform1i(glGetUniformLocation(program, "texture2"), 2);
+	glUseProgram(previous);
+
+	const float corners[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+	glGenBuffers(1, &cornerBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, cornerBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return true;
+}
+
+void ParticleRenderer::render(const ModelParticleEmitterAdaptor* emitter,
+	const std::array<GLuint, 3>& textures,
+	uint32_t texture_count,
+	const Matrix& model_view,
+	const Matrix& projection)
+{
+	const auto& particles = emitter->getParticles();
+	const auto tile_count = emitter->getTiles().size();
+	const bool origin_quad = emitter->getParticleType() == 1;
+
+	instances.clear();
+	for (const auto& particle : particles) {
+		if (particle.tile >= tile_count) {
+			continue;
+		}
+
+		auto& instance = instances.emplace_back();
+		instance.position = particle.position;
+		instance.size = particle.size;
+		instance.color = particle.color;
+		instance.origin = particle.origin;
+		instance.tile = (float)particle.tile;
+		// corners are +-x +-z of the emitter rotation, so the quad can be rebuilt from two of them.
+		instance.right = (particle.corners[1] - particle.corners[0]) * 0.5f;
+		instance.up = (particle.corners[0] + particle.corners[1]) * -0.5f;
+	}
+
+	if (instances.empty()) {
+		return;
+	}
+
+	glUseProgram(program);
+
+	// gl matrices are column major.
+	Matrix transposed = model_view;
+	transposed.transpose();
+	glUniformMatrix4fv(uniforms.modelView, 1, GL_FALSE, transposed);
+	transposed = projection;
+	transposed.transpose();
+	glUniformMatrix4fv(uniforms.projection, 1, GL_FALSE, transposed);
+
+	// rows of the modelview are the camera axes in model space.
+	glUniform3f(uniforms.cameraRight, model_view.m[0][0], model_view.m[0][1], model_view.m[0][2]);
+	glUniform3f(uniforms.cameraUp, model_view.m[1][0], model_view.m[1][1], model_view.m[1][2]);
+	glUniform1i(uniforms.billboard, emitter->isBillboard() ? 1 : 0);
+	glUniform1i(uniforms.originQuad, origin_quad ? 1 : 0);
+
+	const auto dimensions = emitter->getTextureDimension();
+	glUniform2i(uniforms.tileGrid, std::max<GLint>(1, dimensions[1]), std::max<GLint>(1, dimensions[0]));
+	glUniform1i(uniforms.cornerShift, emitter->getParticleType() > 0 ? 3 : 0);
+	glUniform1i(uniforms.textureCount, (GLint)texture_count);
+	glUniform1i(uniforms.alphaTest, emitter->getBlendType() == BlendMode::BM_TRANSPARENT ? 1 : 0);
+
+	for (uint32_t i = 0; i < texture_count; i++) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, cornerBuffer);
+	glEnableVertexAttribArray(ATTRIBUTE_CORNER);
+	glVertexAttribPointer(ATTRIBUTE_CORNER, 1, GL_FLOAT, GL_FALSE, sizeof(float), nullptr);
+
+	// orphan the previous contents rather than waiting on draws still using them.
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STREAM_DRAW);
+
+	instanceAttribute(ATTRIBUTE_POSITION, 3, offsetof(Instance, position));
+	instanceAttribute(ATTRIBUTE_SIZE, 1, offsetof(Instance, size));
+	instanceAttribute(ATTRIBUTE_COLOR, 4, offsetof(Instance, color));
+	instanceAttribute(ATTRIBUTE_ORIGIN, 3, offsetof(Instance, origin));
+	instanceAttribute(ATTRIBUTE_TILE, 1, offsetof(Instance, tile));
+	instanceAttribute(ATTRIBUTE_RIGHT, 3, offsetof(Instance, right));
+	instanceAttribute(ATTRIBUTE_UP, 3, offsetof(Instance, up));
+
+	glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, (GLsizei)instances.size());
+
+	for (GLuint location = ATTRIBUTE_CORNER; location <= ATTRIBUTE_UP; location++) {
+		glVertexAttribDivisor(location, 0);
+		glDisableVertexAttribArray(location);
+	}
+
+	// the rest of the renderer uses client side arrays.
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(0);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <vector>
+#include "core/modeling/ModelAdaptors.h"
+#include "core/utility/Matrix.h"
+#include "core/utility/Vector3.h"
+#include "core/utility/Vector4.h"
+
+/// <summary>
+/// Draws particle emitters with one instanced draw each, replacing the per particle immediate mode quads.
+/// Live particles are streamed into an instance buffer, the vertex shader expands each into a quad,
+/// billboards facing the camera using the basis of the view matrix passed in (so nothing is read back from GL).
+/// Blending and depth state are left to the caller, as with the immediate mode path.
+/// </summary>
+class ParticleRenderer
+{
+public:
+
+	struct Instance {
+		core::Vector3 position;
+		float size;
+		core::Vector4 color;
+		// far edge of type 1 particles, quads stretched from the spawn origin to the particle.
+		core::Vector3 origin;
+		float tile;
+		// quad axes of particles that arent billboarded.
+		core::Vector3 right;
+		core::Vector3 up;
+	};
+
+	ParticleRenderer();
+	ParticleRenderer(const ParticleRenderer&) = delete;
+
+	// the context must be current.
+	~ParticleRenderer();
+
+	// false when the context lacks instancing.
+	bool initialise();
+
+	// textures are combined as the fixed function path does, the first scaled by 4 when there are more.
+	void render(const core::ModelParticleEmitterAdaptor* emitter,
+		const std::array<GLuint, 3>& textures,
+		uint32_t texture_count,
+		const core::Matrix& model_view,
+		const core::Matrix& projection);
+
+protected:
+
+	enum Attribute : GLuint {
+		ATTRIBUTE_CORNER,
+		ATTRIBUTE_POSITION,
+		ATTRIBUTE_SIZE,
+		ATTRIBUTE_COLOR,
+		ATTRIBUTE_ORIGIN,
+		ATTRIBUTE_TILE,
+		ATTRIBUTE_RIGHT,
+		ATTRIBUTE_UP
+	};
+
+	GLuint program;
+	// corner index of each quad vertex, drawing needs attribute 0 enabled on compatibility contexts.
+	GLuint cornerBuffer;
+	GLuint instanceBuffer;
+
+	struct Uniforms {
+		GLint modelView = -1;
+		GLint projection = -1;
+		GLint billboard = -1;
+		GLint originQuad = -1;
+		GLint cameraRight = -1;
+		GLint cameraUp = -1;
+		GLint tileGrid = -1;
+		GLint cornerShift = -1;
+		GLint textureCount = -1;
+		GLint alphaTest = -1;
+	} uniforms;
+
+	// scratch space, reused between emitters.
+	std::vector<Instance> instances;
+};
@@ -15,42 +15,49 @@ RenderControl::RenderControl(QWidget *parent)
 	connect(ui.horizontalSliderAlpha, &QSlider::valueChanged, [&](int val) {
 		if (meta != nullptr) {
 			meta->renderOptions.opacity = float(val) / 100.0f;
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.checkBoxWireFrame, &QCheckBox::stateChanged, [&]() {
 		if (meta != nullptr) {
 			meta->renderOptions.showWireFrame = ui.checkBoxWireFrame->isChecked();
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.checkBoxBounds, &QCheckBox::stateChanged, [&]() {
 		if (meta != nullptr) {
 			meta->renderOptions.showBounds = ui.checkBoxBounds->isChecked();
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.checkBoxBones, &QCheckBox::stateChanged, [&]() {
 		if (meta != nullptr) {
 			meta->renderOptions.showBones = ui.checkBoxBones->isChecked();
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.checkBoxTexture, &QCheckBox::stateChanged, [&]() {
 		if (meta != nullptr) {
 			meta->renderOptions.showTexture = ui.checkBoxTexture->isChecked();
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.checkBoxRender, &QCheckBox::stateChanged, [&]() {
 		if (meta != nullptr) {
 			meta->renderOptions.showRender = ui.checkBoxRender->isChecked();
+			scene->requestRedraw();
 		}
 	});
 
 	connect(ui.checkBoxParticles, &QCheckBox::stateChanged, [&]() {
 		if (meta != nullptr) {
 			meta->renderOptions.showParticles = ui.checkBoxParticles->isChecked();
+			scene->requestRedraw();
 		}
 	});
 }
@@ -0,0 +1,142 @@
+#include "stdafx.h"
+#include "RenderQueue.h"
+#include <algorithm>
+#include <bit>
+
+using namespace core;
+
+namespace {
+	// key layout, most significant first.
+	// opaque:		layer (1) | pass (8) | permutation (4) | blend mode (4) | texture (15) | depth (32)
+	// transparent:	layer (1) | inverted depth (31) | order (32)
+	constexpr uint64_t LAYER_TRANSPARENT = uint64_t(1) << 63;
+	constexpr uint32_t PASS_SHIFT = 55;
+	constexpr uint64_t PASS_MASK = 0xFF;
+	constexpr uint32_t PERMUTATION_SHIFT = 51;
+	constexpr uint64_t PERMUTATION_MASK = 0xF;
+	constexpr uint32_t BLEND_SHIFT = 47;
+	constexpr uint64_t BLEND_MASK = 0xF;
+	constexpr uint32_t TEXTURE_SHIFT = 32;
+	constexpr uint64_t TEXTURE_MASK = 0x7FFF;
+	constexpr uint32_t DEPTH_SHIFT = 32;
+	constexpr uint64_t DEPTH_MASK = 0x7FFFFFFF;
+
+	// eye space distance in front of the camera, as bits that sort in the same order as the value.
+	uint32_t depthBits(float depth) {
+		// positive floats order the same as their bit patterns, the sign bit is always clear.
+		return std::bit_cast<uint32_t>(std::max(depth, 0.0f));
+	}
+}
+
+void RenderQueue::addGeometry(const GpuSkinning::Binding& binding, const Matrix& model_view, bool wireframe)
+{
+	auto& geometry = geometries.emplace_back();
+	// instance attributes are column major.
+	Matrix transposed = model_view;
+	transposed.transpose();
+	std::copy_n(&transposed.m[0][0], geometry.instance.modelView.size(), geometry.instance.modelView.begin());
+	geometry.instance.paletteOffset = binding.paletteOffset;
+	geometry.mesh = binding.mesh;
+	geometry.wireframe = wireframe;
+	// camera looks down -z, the translation of the modelview is the component origin in eye space.
+	geometry.depth = -model_view.m[2][3];
+}
+
+void RenderQueue::add(const ShaderPassRenderer::Draw& draw, uint32_t pass)
+{
+	assert(!geometries.empty());
+	const uint32_t geometry_index = (uint32_t)geometries.size() - 1;
+	const auto& geometry = geometries.back();
+
+	// blended draws depend on what is already drawn, so each is kept apart to be drawn in depth order.
+	if (!draw.blend) {
+		const uint64_t lookup = lookupKey(geometry.mesh, draw);
+		const auto [first, last] = openBatches.equal_range(lookup);
+
+		for (auto it = first; it != last; ++it) {
+			auto& batch = batches[it->second];
+			// a component repeating a pass still draws it twice, in order.
+			const bool same_geometry = batch.geometries.back() == geometry_index;
+
+			if (!same_geometry &&
+				batch.pass == pass &&
+				batch.mesh == geometry.mesh &&
+				batch.wireframe == geometry.wireframe &&
+				ShaderPassRenderer::isSameState(batch.draw, draw)) {
+				batch.geometries.push_back(geometry_index);
+				batch.depth = std::min(batch.depth, geometry.depth);
+				return;
+			}
+		}
+
+		openBatches.emplace(lookup, (uint32_t)batches.size());
+	}
+
+	batches.push_back({ draw, pass, geometry.mesh, geometry.wireframe, { geometry_index }, geometry.depth, 0 });
+}
+
+void RenderQueue::sort()
+{
+	items.clear();
+	for (uint32_t i = 0; i < batches.size(); i++) {
+		items.push_back({ makeKey(batches[i].draw, batches[i].depth, batches[i].pass, i), i });
+	}
+
+	// stable, so equal keys keep the order they were added in.
+	std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+		return a.key < b.key;
+	});
+
+	// instances are laid out in draw order, so consecutive batches read consecutive ranges.
+	instances.clear();
+	for (const auto& item : items) {
+		auto& batch = batches[item.batch];
+		batch.firstInstance = (uint32_t)instances.size();
+		for (const auto geometry_index : batch.geometries) {
+			instances.push_back(geometries[geometry_index].instance);
+		}
+	}
+}
+
+void RenderQueue::submit(ShaderPassRenderer& renderer, const Matrix& projection) const
+{
+	renderer.begin(instances, projection);
+
+	for (const auto& item : items) {
+		const auto& batch = batches[item.batch];
+		renderer.render(*batch.mesh, batch.wireframe, batch.draw, batch.firstInstance, (uint32_t)batch.geometries.size());
+	}
+
+	renderer.end();
+}
+
+void RenderQueue::clear()
+{
+	items.clear();
+	batches.clear();
+	openBatches.clear();
+	geometries.clear();
+	instances.clear();
+}
+
+uint64_t RenderQueue::makeKey(const ShaderPassRenderer::Draw& draw, float depth, uint32_t pass, uint32_t order)
+{
+	if (draw.blend) {
+		// blending depends on what is already drawn, so the order between components is by depth only.
+		const uint64_t inverted_depth = DEPTH_MASK - (depthBits(depth) & DEPTH_MASK);
+		return LAYER_TRANSPARENT | (inverted_depth << DEPTH_SHIFT) | order;
+	}
+
+	// passes of a component can overlap at the same depth, so they are kept in pass order ahead of any state.
+	// passes beyond the last the key can hold share its position.
+	return ((std::min<uint64_t>(pass, PASS_MASK)) << PASS_SHIFT) |
+		(((uint64_t)draw.permutation & PERMUTATION_MASK) << PERMUTATION_SHIFT) |
+		((uint64_t)(draw.blendMode & BLEND_MASK) << BLEND_SHIFT) |
+		(((uint64_t)draw.texture & TEXTURE_MASK) << TEXTURE_SHIFT) |
+		depthBits(depth);
+}
+
+uint64_t RenderQueue::lookupKey(const GpuSkinning::Mesh* mesh, const ShaderPassRenderer::Draw& draw)
+{
+	return (uint64_t)(uintptr_t)mesh ^ ((uint64_t)draw.indexStart << 32) ^ ((uint64_t)draw.texture << 16) ^ draw.indexCount;
+}
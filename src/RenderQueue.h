@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "ShaderPassRenderer.h"
+
+/// <summary>
+/// Collects the draws of every model in the scene, so they can be submitted in state order rather than scene order.
+/// Opaque passes of the same mesh with identical state are merged into one instanced draw, so repeated models cost one draw per pass.
+/// Each draw is given a 64 bit sort key, opaque draws are ordered by their pass index within the component,
+/// then grouped by shader, blending and texture (then front to back).
+/// Transparent draws are drawn after them back to front, keeping the pass order of each component.
+/// </summary>
+class RenderQueue
+{
+public:
+
+	// passes added afterwards are drawn with the modelview matrix given.
+	void addGeometry(const GpuSkinning::Binding& binding, const core::Matrix& model_view, bool wireframe);
+
+	// pass is the index of the pass in the component, passes of a component are drawn in that order.
+	void add(const ShaderPassRenderer::Draw& draw, uint32_t pass);
+
+	// orders the draws and lays out their instances.
+	void sort();
+
+	// GpuSkinning::begin must already have been called, the renderer batch is begun and ended here.
+	void submit(ShaderPassRenderer& renderer, const core::Matrix& projection) const;
+
+	void clear();
+
+	bool empty() const {
+		return batches.empty();
+	}
+
+	// order is when the draw was added, for transparent draws at the same depth.
+	static uint64_t makeKey(const ShaderPassRenderer::Draw& draw, float depth, uint32_t pass, uint32_t order);
+
+protected:
+
+	struct Geometry {
+		ShaderPassRenderer::Instance instance;
+		const GpuSkinning::Mesh* mesh;
+		bool wireframe;
+		// eye space distance of the component origin.
+		float depth;
+	};
+
+	// a pass drawn for one or more geometries.
+	struct Batch {
+		ShaderPassRenderer::Draw draw;
+		uint32_t pass;
+		const GpuSkinning::Mesh* mesh;
+		bool wireframe;
+		std::vector<uint32_t> geometries;
+		// of the nearest geometry.
+		float depth;
+		// set by sort.
+		uint32_t firstInstance;
+	};
+
+	struct Item {
+		uint64_t key;
+		uint32_t batch;
+	};
+
+	static uint64_t lookupKey(const GpuSkinning::Mesh* mesh, const ShaderPassRenderer::Draw& draw);
+
+	std::vector<Geometry> geometries;
+	std::vector<Batch> batches;
+	// opaque batches that can still be added to, by mesh and pass range.
+	std::unordered_multimap<uint64_t, uint32_t> openBatches;
+	std::vector<Item> items;
+	std::vector<ShaderPassRenderer::Instance> instances;
+};
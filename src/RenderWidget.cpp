@@ -1,11 +1,67 @@
 #include "stdafx.h"
 #include "RenderWidget.h"
 #include "ModelRenderPassRenderer.h"
+#include "GpuSkinning.h"
+#include "ShaderPassRenderer.h"
+#include "RenderQueue.h"
+#include "FrameScheduler.h"
+#include "FrameStatistics.h"
 #include "WMVxVideoCapabilities.h"
 #include "BasicCamera.h"
 #include "ArcBallCamera.h"
 #include "WMVxSettings.h"
 #include "core/utility/Logger.h"
+#include "core/utility/JobGraph.h"
+
+namespace {
+	using namespace core;
+
+	// equivalent of gluPerspective.
+	core::Matrix perspective(float fovy, float aspect, float near_plane, float far_plane) {
+		const float f = 1.0f / std::tan((fovy * (float)(PI / 180.0)) / 2.0f);
+
+		core::Matrix result;
+		result.zero();
+		result.m[0][0] = f / aspect;
+		result.m[1][1] = f;
+		result.m[2][2] = (far_plane + near_plane) / (near_plane - far_plane);
+		result.m[2][3] = (2.0f * far_plane * near_plane) / (near_plane - far_plane);
+		result.m[3][2] = -1.0f;
+		return result;
+	}
+
+	// equivalent of glRotatef about a single axis.
+	core::Matrix rotation(float degrees, size_t axis) {
+		const float radians = degrees * (float)(PI / 180.0);
+		const float c = std::cos(radians);
+		const float s = std::sin(radians);
+		const size_t a = (axis + 1) % 3;
+		const size_t b = (axis + 2) % 3;
+
+		core::Matrix result = core::Matrix::identity();
+		result.m[a][a] = c;
+		result.m[a][b] = -s;
+		result.m[b][a] = s;
+		result.m[b][b] = c;
+		return result;
+	}
+
+	// placement of a root model in the scene.
+	core::Matrix modelMatrixOf(const core::ModelRenderOptions& options) {
+		return core::Matrix::newTranslation(core::Vector3(options.position.x, options.position.y, -options.position.z)) *
+			rotation(options.rotation.x, 0) *
+			rotation(options.rotation.y, 1) *
+			rotation(options.rotation.z, 2) *
+			core::Matrix::newScale(options.scale);
+	}
+
+	void loadModelView(const core::Matrix& model_view) {
+		// gl matrices are column major.
+		core::Matrix transposed = model_view;
+		transposed.transpose();
+		glLoadMatrixf(transposed);
+	}
+}
 
 RenderWidget::RenderWidget(QWidget* parent)
 	: QOpenGLWidget(parent), 
@@ -26,6 +82,11 @@ RenderWidget::RenderWidget(QWidget* parent)
 
 	assert(camera);
 
+	updatePool = new QThreadPool(this);
+	frameScheduler = nullptr;
+	showStatistics = false;
+	gpuSkinningActive = false;
+
 	{
 		auto color = Settings::get<QColor>(config::app::background_color);
 		background = core::ColorRGBA<float>(color.redF(), color.greenF(), color.blueF(), color.alphaF());
@@ -39,15 +100,34 @@ RenderWidget::RenderWidget(QWidget* parent)
 	format.setSamples(32);
 	format.setAlphaBufferSize(16);
 	format.setRenderableType(QSurfaceFormat::OpenGL);
+	// frames are paced by presenting, see FrameScheduler.
+	format.setSwapInterval(1);
 	setFormat(format);
 }
 
 RenderWidget::~RenderWidget()
-{}
+{
+	// gpu resources need the context current to be released.
+	makeCurrent();
+	gpuSkinning.reset();
+	shaderPassRenderer.reset();
+	particleRenderer.reset();
+	debugRenderer.reset();
+	frameStatistics.reset();
+	doneCurrent();
+}
 
 void RenderWidget::resetCamera()
 {
 	camera->reset();
+	invalidateFrame();
+}
+
+void RenderWidget::invalidateFrame()
+{
+	if (frameScheduler != nullptr) {
+		frameScheduler->invalidate();
+	}
 }
 
 void RenderWidget::initializeGL()
@@ -70,27 +150,107 @@ void RenderWidget::initializeGL()
 
 	//TODO log ogl support
 
+	// every queued component is drawn by the shader pass renderer from buffers owned by gpu skinning, so both are needed.
+	gpuSkinning = std::make_unique<GpuSkinning>();
+	shaderPassRenderer = std::make_unique<ShaderPassRenderer>();
+	if (!gpuSkinning->initialise() || !shaderPassRenderer->initialise()) {
+		gpuSkinning.reset();
+		shaderPassRenderer.reset();
+	}
+
+	particleRenderer = std::make_unique<ParticleRenderer>();
+	if (!particleRenderer->initialise()) {
+		particleRenderer.reset();
+	}
+
+	debugRenderer = std::make_unique<DebugRenderer>();
+	debugRenderer->initialise();
+
+	frameStatistics = std::make_unique<FrameStatistics>();
+	frameStatistics->initialise();
+	frameStatistics->setEnabled(showStatistics);
+
 	glClearColor(background.red, background.green, background.blue, background.alpha);
 
-	// ideally we'd be using the delta time between 'timeout' calls for smoother animation, 
-	// unfortunatly I've not found any easy/reliable to achieve this with Qt.
-	// for simple scene rendering in the app, the ability to change target fps should be enough flexiblity.
-	const int updateTick = 1000 / Settings::get<int32_t>(config::rendering::target_fps);
-	QTimer* timer = new QTimer(this);
-	connect(timer, &QTimer::timeout, this, [&, updateTick]() {
-		update();
+	// the simulation advances in fixed steps of the target frame time, using the measured time between frames.
+	// frame jitter only changes how far the display is blended between steps, so playback is the same regardless of frame rate.
+	const int32_t target_fps = Settings::get<int32_t>(config::rendering::target_fps);
+	const int updateTick = 1000 / target_fps;
+	simulationClock = std::make_unique<core::FixedStepClock>(updateTick, maxCatchUpSteps);
+	frameTimer.start();
+
+	frameScheduler = new FrameScheduler(this, target_fps);
+	connect(this, &QOpenGLWidget::frameSwapped, frameScheduler, &FrameScheduler::framePresented);
+	connect(frameScheduler, &FrameScheduler::resumed, this, [&]() {
+		// nothing was animating while idle, so there is nothing to catch up on.
+		frameTimer.restart();
+	});
+	connect(Settings::instance(), &WMVxSettings::changed, this, [&](const QString& key) {
+		if (key == config::rendering::target_fps) {
+			setTargetFrameRate(Settings::get<int32_t>(config::rendering::target_fps));
+		}
+	});
+	connect(frameScheduler, &FrameScheduler::frameRequested, this, [&]() {
+		const auto frame = simulationClock->advance(frameTimer.nsecsElapsed() / 1000000.0);
+		frameTimer.restart();
+
+		gpuSkinningActive = gpuSkinning != nullptr && Settings::get<bool>(config::rendering::gpu_skinning);
+
 		if (scene != nullptr) {
+			// models are independent of each other, attachments and merges wait on their owner.
+			// all jobs complete before returning, so nothing is updating during paintGL.
+			core::JobGraph jobs(updatePool);
 			for (auto& model : scene->models) {
-				model->update(updateTick);
+				model->setCpuSkinning(!gpuSkinningActive);
+				model->update(frame, jobs);
 			}
+			jobs.run();
 		}
+
+		frameScheduler->setActive(isAnimating());
+		update();
+	});
+}
+
+void RenderWidget::setTargetFrameRate(int32_t fps)
+{
+	// the simulation steps once per target frame, so both change together.
+	frameScheduler->setTargetFrameRate(fps);
+	simulationClock = std::make_unique<core::FixedStepClock>(1000 / frameScheduler->getTargetFrameRate(), maxCatchUpSteps);
+	invalidateFrame();
+}
+
+bool RenderWidget::isAnimating() const
+{
+	// particles and ribbons only move while their model animates, so they dont need checking separately.
+	if (scene == nullptr) {
+		return false;
+	}
+
+	return std::any_of(scene->models.begin(), scene->models.end(), [](const auto& model) {
+		return model->animate && model->animator.getAnimationId().has_value();
 	});
-	timer->setInterval(updateTick);
-	timer->start();
+}
+
+void RenderWidget::onSceneLoaded(core::Scene* new_scene)
+{
+	WidgetUsesScene::onSceneLoaded(new_scene);
+
+	// controls signal their own changes through the scene, see Scene::requestRedraw.
+	connect(scene, &core::Scene::componentAdded, this, &RenderWidget::invalidateFrame);
+	connect(scene, &core::Scene::componentRemoved, this, &RenderWidget::invalidateFrame);
+	connect(scene, &core::Scene::modelSelectionChanged, this, &RenderWidget::invalidateFrame);
+	connect(scene, &core::Scene::sceneChanged, this, &RenderWidget::invalidateFrame);
+	connect(scene, &core::Scene::redrawRequested, this, &RenderWidget::invalidateFrame);
 }
 
 void RenderWidget::paintGL()
 {
+	QElapsedTimer paint_timer;
+	paint_timer.start();
+
+	frameStatistics->beginFrame();
+
 	glClearColor(background.red, background.green, background.blue, background.alpha);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -98,15 +258,24 @@ void RenderWidget::paintGL()
 	glDepthFunc(GL_LEQUAL);
 
 	camera->setup();
+
+	// component matrices are built here rather than on the GL stack, so they can be used without reading them back.
+	const core::Matrix& view = camera->getViewMatrix();
+
+	if (shaderPassRenderer != nullptr) {
+		shaderPassRenderer->resetStats();
+	}
+
 	if (scene != nullptr) {
 
 		if (scene->showGrid) {
-			renderGrid();
+			FrameStatistics::ScopedPhase phase(*frameStatistics, FrameStatistics::PHASE_GRID);
+			debugRenderer->renderGrid(gridExtent, 0.0f);
+			frameStatistics->countDraws();
 		}
 
 		for (const auto &model : scene->models) {
 			const core::AnimationTickArgs& tick = model->animator.getLastTick();
-			glPushMatrix();
 
 			glVertexPointer(3, GL_FLOAT, 0, model->model->getVertices().data());
 			glNormalPointer(GL_FLOAT, 0, model->model->getNormals().data());
@@ -116,95 +285,81 @@ void RenderWidget::paintGL()
 				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 			}
 
-			glTranslatef(model->modelOptions.position.x, model->modelOptions.position.y, -model->modelOptions.position.z);
-			glRotatef(model->modelOptions.rotation.x, 1.0f, 0.0f, 0.0f);
-			glRotatef(model->modelOptions.rotation.y, 0.0f, 1.0f, 0.0f);
-			glRotatef(model->modelOptions.rotation.z, 0.0f, 0.0f, 1.0f);
+			const core::Matrix model_matrix = modelMatrixOf(model->modelOptions);
+			const core::Matrix model_view = view * model_matrix;
+			loadModelView(model_view);
 
-			glScalef(model->modelOptions.scale.x, model->modelOptions.scale.y, model->modelOptions.scale.z);
-			
+			const auto model_frustum = updateViewFrustum(model.get(), model_view);
+
+			frameStatistics->beginPhase(FrameStatistics::PHASE_MODELS);
 			if (model->renderOptions.showRender) {
 				glEnable(GL_NORMALIZE);
-				for (auto& pass : model->model->getRenderPasses()) {
-
-					// May aswell check that we're going to render the geoset before doing all this crap.
-					if (!model->getGeosetState().indexVisible(pass.geosetIndex)) {
-						continue;
-					}
-
-					if (ModelRenderPassRenderer::start(model->renderOptions, model.get(), model->model.get(), model->animator.getAnimationIndex(), pass, tick)) {
-						
-						glBegin(GL_TRIANGLES);
-						for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
-							uint16_t a = model->model->getIndices()[b];
-							glNormal3fv((GLfloat*)&model->animatedNormals[a]);
-							glTexCoord2fv((GLfloat*)&model->model->getRawVertices()[a].textureCoords);
-							glVertex3fv((GLfloat*)&model->animatedVertices[a]);
-						}
-						glEnd();
-
-						ModelRenderPassRenderer::finish(pass);
+				if (isVisible(model_frustum, model->bounds)) {
+					model->ensureSkinned();
+					model->model->calculateMaterials(model->animator.getAnimationIndex(), tick);
+					const auto& materials = model->model->getMaterialAnimation();
+					const auto& passes = model->model->getRenderPasses();
+					const bool queued = queueGeometry(model.get(), model->model.get(), model_view, model->renderOptions.showWireFrame);
+					for (const auto pass_index : model->getVisiblePasses()) {
+						const auto& pass = passes[pass_index];
+
+						renderPass(queued, model_frustum, model->renderOptions, model.get(), model.get(), model->model.get(), materials, pass, pass_index);
 					}
 				}
 
 				if (model->renderOptions.showParticles) {
-					renderParticles(model.get(), model->model.get());
+					deferParticles(model.get(), model->model.get(), model_view);
 				}
 
 				glDisable(GL_NORMALIZE);
 			}
+			frameStatistics->endPhase();
 			
+			// drawn together once every model has been visited.
 			if (model->renderOptions.showBounds) {
-				renderBounds(model.get());
+				debugRenderer->addBounds(model->model.get(), model_matrix);
 			}
 
 			if (model->renderOptions.showBones) {
-				renderBones(model.get());
+				debugRenderer->addBones(model->model.get(), model_matrix);
 			}
 
+			frameStatistics->beginPhase(FrameStatistics::PHASE_ATTACHMENTS);
 			if (!model->getAttachments().empty()) {
 				glEnable(GL_NORMALIZE);
-				for (const auto* attachment : model->getAttachments()) {
+				for (auto* attachment : model->getAttachments()) {
 					
-					attachment->visit<core::Attachment::AttachOwnedModel>([&](const core::Attachment::AttachOwnedModel* owned) {
-						glPushMatrix();
+					attachment->visit<core::Attachment::AttachOwnedModel>([&](core::Attachment::AttachOwnedModel* owned) {
 
 						glVertexPointer(3, GL_FLOAT, 0, owned->model->getVertices().data());
 						glNormalPointer(GL_FLOAT, 0, owned->model->getNormals().data());
 						glTexCoordPointer(2, GL_FLOAT, 0, owned->model->getTextureCoords().data());
 
-						{
-							core::Matrix m = model->model->getBoneAdaptors()[owned->bone]->getMat();
-							m.transpose();
-							glMultMatrixf(m);
-							glTranslatef(owned->position.x, owned->position.y, owned->position.z);
-						}
+						// effects share the attachment position.
+						const core::Matrix attachment_view = model_view *
+							model->model->getBonePalette().getMat(owned->bone) *
+							core::Matrix::newTranslation(owned->position);
+						loadModelView(attachment_view);
 
-						if (attachment->renderOptions.showRender) {
+						const auto owned_frustum = updateViewFrustum(owned, attachment_view);
 
-							for (auto& pass : owned->model->getRenderPasses()) {
-
-								if (!owned->getGeosetState().indexVisible(pass.geosetIndex)) {
-									continue;
-								}
-
-								if (ModelRenderPassRenderer::start(attachment->renderOptions, owned, owned->model.get(), std::nullopt, pass, tick)) {
+						if (attachment->renderOptions.showRender) {
 
-									glBegin(GL_TRIANGLES);
-									for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
-										uint16_t a = owned->model->getIndices()[b];
-										glNormal3fv((GLfloat*)&owned->animatedNormals[a]);
-										glTexCoord2fv((GLfloat*)&owned->model->getRawVertices()[a].textureCoords);
-										glVertex3fv((GLfloat*)&owned->animatedVertices[a]);
-									}
-									glEnd();
+							if (isVisible(owned_frustum, owned->bounds)) {
+								owned->ensureSkinned();
+								owned->model->calculateMaterials(std::nullopt, tick);
+								const auto& materials = owned->model->getMaterialAnimation();
+								const auto& passes = owned->model->getRenderPasses();
+								const bool queued = queueGeometry(owned, owned->model.get(), attachment_view, model->renderOptions.showWireFrame);
+								for (const auto pass_index : owned->getVisiblePasses()) {
+									const auto& pass = passes[pass_index];
 
-									ModelRenderPassRenderer::finish(pass);
+									renderPass(queued, owned_frustum, attachment->renderOptions, owned, owned, owned->model.get(), materials, pass, pass_index);
 								}
 							}
 
 							if (attachment->renderOptions.showParticles) {
-								renderParticles(owned, owned->model.get());
+								deferParticles(owned, owned->model.get(), attachment_view);
 							}
 						}
 
@@ -214,88 +369,72 @@ void RenderWidget::paintGL()
 								glNormalPointer(GL_FLOAT, 0, effect->model->getNormals().data());
 								glTexCoordPointer(2, GL_FLOAT, 0, effect->model->getTextureCoords().data());
 
-								{
-									core::Matrix m = model->model->getBoneAdaptors()[owned->bone]->getMat();
-									m.transpose();
-									glMultMatrixf(m);
-									glTranslatef(owned->position.x, owned->position.y, owned->position.z);
-								}
+								const auto effect_frustum = updateViewFrustum(effect.get(), attachment_view);
 
 								if (effect->renderOptions.showRender) {
-									for (auto& pass : effect->model->getRenderPasses()) {
+									if (isVisible(effect_frustum, effect->bounds)) {
+										effect->ensureSkinned();
 										//TODO not sure what animation index should be used.
-
-										if (ModelRenderPassRenderer::start(effect->renderOptions, effect.get(), effect->model.get(), std::nullopt, pass, tick)) {
-
-											glBegin(GL_TRIANGLES);
-											for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
-												uint16_t a = effect->model->getIndices()[b];
-												glNormal3fv((GLfloat*)&effect->animatedNormals[a]);
-												glTexCoord2fv((GLfloat*)&effect->model->getRawVertices()[a].textureCoords);
-												glVertex3fv((GLfloat*)&effect->animatedVertices[a]);
-											}
-											glEnd();
-
-											ModelRenderPassRenderer::finish(pass);
+										effect->model->calculateMaterials(std::nullopt, tick);
+										const auto& materials = effect->model->getMaterialAnimation();
+
+										const bool queued = queueGeometry(effect.get(), effect->model.get(), attachment_view, model->renderOptions.showWireFrame);
+										const auto& passes = effect->model->getRenderPasses();
+										for (uint32_t pass_index = 0; pass_index < passes.size(); pass_index++) {
+											const auto& pass = passes[pass_index];
+											renderPass(queued, effect_frustum, effect->renderOptions, effect.get(), effect.get(), effect->model.get(), materials, pass, pass_index);
 										}
 									}
 
 									if (effect->renderOptions.showParticles) {
-										renderParticles(effect.get(), effect->model.get());
+										deferParticles(effect.get(), effect->model.get(), attachment_view);
 									}
 								}
 							}
 						}
-
-						glPopMatrix();
 					});
 				}
 
+				loadModelView(model_view);
 				glDisable(GL_NORMALIZE);
 			}
+			frameStatistics->endPhase();
 
+			frameStatistics->beginPhase(FrameStatistics::PHASE_MODELS);
 			if (!model->getMerged().empty()) {
 				glEnable(GL_NORMALIZE);
-				for (const auto* rel : model->getMerged()) {
-					glPushMatrix();
+				for (auto* rel : model->getMerged()) {
 
 					glVertexPointer(3, GL_FLOAT, 0, rel->model->getVertices().data());
 					glNormalPointer(GL_FLOAT, 0, rel->model->getNormals().data());
 					glTexCoordPointer(2, GL_FLOAT, 0, rel->model->getTextureCoords().data());
-				
-					if (rel->renderOptions.showRender) {
-
-						for (auto& pass : rel->model->getRenderPasses()) {
 
-							if (!rel->getGeosetState().indexVisible(pass.geosetIndex)) {
-								continue;
-							}
+					// merged models share the owner skeleton, and so its space.
+					const auto merged_frustum = updateViewFrustum(rel, model_view);
 
-							if (ModelRenderPassRenderer::start(rel->renderOptions, rel, rel->model.get(), std::nullopt, pass, tick)) {
+					if (rel->renderOptions.showRender) {
 
-								glBegin(GL_TRIANGLES);
-								for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
-									uint16_t a = rel->model->getIndices()[b];
-									glNormal3fv((GLfloat*)&rel->animatedNormals[a]);
-									glTexCoord2fv((GLfloat*)&rel->model->getRawVertices()[a].textureCoords);
-									glVertex3fv((GLfloat*)&rel->animatedVertices[a]);
-								}
-								glEnd();
+						if (isVisible(merged_frustum, rel->bounds)) {
+							rel->ensureSkinned();
+							rel->model->calculateMaterials(std::nullopt, tick);
+							const auto& materials = rel->model->getMaterialAnimation();
+							const auto& passes = rel->model->getRenderPasses();
+							const bool queued = queueGeometry(rel, rel->model.get(), model_view, model->renderOptions.showWireFrame);
+							for (const auto pass_index : rel->getVisiblePasses()) {
+								const auto& pass = passes[pass_index];
 
-								ModelRenderPassRenderer::finish(pass);
+								renderPass(queued, merged_frustum, rel->renderOptions, rel, rel, rel->model.get(), materials, pass, pass_index);
 							}
 						}
 
 						if (rel->renderOptions.showParticles) {
-							renderParticles(rel, rel->model.get());
+							deferParticles(rel, rel->model.get(), model_view);
 						}
 					}
-
-
-					glPopMatrix();
 				}
 				glDisable(GL_NORMALIZE);
 			}
+			frameStatistics->endPhase();
 
 			if (model->renderOptions.showWireFrame) {
 				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -303,10 +442,146 @@ void RenderWidget::paintGL()
 
 			GLenum err = glGetError();
 			assert(err == GL_NO_ERROR);
+		}
 
-			glPopMatrix();
+		loadModelView(view);
+	}
+
+	flushRenderQueue();
+
+	if (!deferredParticles.empty()) {
+		FrameStatistics::ScopedPhase phase(*frameStatistics, FrameStatistics::PHASE_PARTICLES);
+		for (const auto& deferred : deferredParticles) {
+			renderParticles(deferred.textureInfo, deferred.model, deferred.modelView);
+		}
+		loadModelView(view);
+		deferredParticles.clear();
+	}
+
+	{
+		FrameStatistics::ScopedPhase phase(*frameStatistics, FrameStatistics::PHASE_BOUNDS);
+		frameStatistics->countDraws(debugRenderer->render());
+	}
+
+	if (gpuSkinning != nullptr) {
+		gpuSkinning->collect();
+	}
+
+	renderStats = shaderPassRenderer != nullptr ? shaderPassRenderer->getStats() : ShaderPassRenderer::Stats();
+
+	frameStatistics->countDraws(renderStats.draws);
+	frameStatistics->countTextureBinds(renderStats.changes[ShaderPassRenderer::STATE_TEXTURE]);
+	// texture binds are counted on their own, state changes are everything else.
+	for (uint32_t type = 0; type < ShaderPassRenderer::STATE_TYPE_COUNT; type++) {
+		if (type != ShaderPassRenderer::STATE_TEXTURE) {
+			frameStatistics->countStateChanges(renderStats.changes[type]);
 		}
 	}
+	frameStatistics->endFrame(paint_timer.nsecsElapsed() / 1000000.0);
+
+	if (showStatistics) {
+		renderStatisticsOverlay();
+	}
+}
+bool RenderWidget::queueGeometry(const core::ModelAnimationInfo* animation_info, const core::M2Model* raw_model, const core::Matrix& model_view, bool wireframe)
+{
+	if (gpuSkinning == nullptr) {
+		return false;
+	}
+
+	const auto prepare = [&]() -> std::optional<GpuSkinning::Binding> {
+		if (gpuSkinningActive) {
+			auto binding = gpuSkinning->prepare(animation_info, raw_model);
+			// models without bones have nothing to skin, their cpu side vertices are already in place.
+			if (binding.has_value() || gpuSkinning->isPaletteFull()) {
+				return binding;
+			}
+		}
+
+		return gpuSkinning->prepareSkinned(animation_info, raw_model);
+	};
+
+	auto binding = prepare();
+	if (!binding.has_value() && gpuSkinning->isPaletteFull()) {
+		// draw what has been queued so far to make room, only the sorting between the two halves is lost.
+		flushRenderQueue();
+		binding = prepare();
+	}
+
+	if (!binding.has_value()) {
+		return false;
+	}
+
+	renderQueue.addGeometry(binding.value(), model_view, wireframe);
+	return true;
+}
+
+void RenderWidget::flushRenderQueue()
+{
+	if (gpuSkinning == nullptr) {
+		return;
+	}
+
+	if (!renderQueue.empty()) {
+		FrameStatistics::ScopedPhase phase(*frameStatistics, FrameStatistics::PHASE_RENDER_QUEUE);
+		renderQueue.sort();
+
+		gpuSkinning->begin();
+		renderQueue.submit(*shaderPassRenderer, projectionMatrix);
+	}
+
+	// also discards palettes of components that had nothing visible.
+	gpuSkinning->end();
+	renderQueue.clear();
+}
+
+core::Frustum RenderWidget::updateViewFrustum(core::ModelAnimationInfo* component, const core::Matrix& model_view)
+{
+	const auto frustum = core::Frustum::fromMatrix(projectionMatrix * model_view);
+	component->viewFrustum = frustum;
+	return frustum;
+}
+
+void RenderWidget::renderPass(bool queued,
+	const core::Frustum& frustum,
+	const core::RenderOptions& render_options,
+	const core::ModelTextureInfo* texture_info,
+	const core::ModelAnimationInfo* animation_info,
+	const core::M2Model* raw_model,
+	const core::MaterialAnimationState& materials,
+	const core::ModelRenderPass& pass,
+	uint32_t pass_index)
+{
+	const auto& geoset_bounds = animation_info->geosetBounds;
+	if (pass.geosetIndex >= 0 && (size_t)pass.geosetIndex < geoset_bounds.size() && !isVisible(frustum, geoset_bounds[pass.geosetIndex])) {
+		return;
+	}
+
+	if (queued) {
+		const auto draw = ShaderPassRenderer::prepare(render_options, texture_info, materials, pass);
+		if (draw.has_value()) {
+			renderQueue.add(draw.value(), pass_index);
+		}
+		return;
+	}
+
+	if (!ModelRenderPassRenderer::start(render_options, texture_info, materials, pass)) {
+		return;
+	}
+
+	frameStatistics->countDraws();
+	frameStatistics->countTextureBinds();
+
+	glBegin(GL_TRIANGLES);
+	for (size_t k = 0, b = pass.indexStart; k < pass.indexCount; k++, b++) {
+		uint16_t a = raw_model->getIndices()[b];
+		glNormal3fv((GLfloat*)&animation_info->animatedNormals[a]);
+		glTexCoord2fv((GLfloat*)&raw_model->getRawVertices()[a].textureCoords);
+		glVertex3fv((GLfloat*)&animation_info->animatedVertices[a]);
+	}
+	glEnd();
+
+	ModelRenderPassRenderer::finish(pass);
 }
 
 void RenderWidget::resizeGL(int width, int height)
@@ -321,6 +596,7 @@ void RenderWidget::resizeGL(int width, int height)
 
 	// Calculate The Aspect Ratio Of The Window
 	gluPerspective(45.0f, (float)width / (float)height, 0.1f, 128.0f * 5);
+	projectionMatrix = perspective(45.0f, (float)width / (float)height, 0.1f, 128.0f * 5);
 
 	glMatrixMode(GL_MODELVIEW);							// Select The Modelview Matrix
 	glLoadIdentity();									// Reset The Modelview Matrix
@@ -344,6 +620,8 @@ void RenderWidget::keyPressEvent(QKeyEvent* event)
 			camera->key(1.f, 0.f, alt, inputScaleFactor());
 			break;
 		}
+
+		invalidateFrame();
 	}
 
 	QOpenGLWidget::keyPressEvent(event);
@@ -360,6 +638,7 @@ void RenderWidget::wheelEvent(QWheelEvent* event)
 	auto value = delta / 120.f;
 
 	camera->scroll(0.f - value, inputScaleFactor());
+	invalidateFrame();
 }
 
 void RenderWidget::mouseMoveEvent(QMouseEvent* event)
@@ -370,6 +649,7 @@ void RenderWidget::mouseMoveEvent(QMouseEvent* event)
 			lastMousePosition = event->position();
 
 			camera->leftMouse(diff.x(), diff.y(), inputScaleFactor());
+			invalidateFrame();
 		}
 	}
 	
@@ -379,6 +659,7 @@ void RenderWidget::mouseMoveEvent(QMouseEvent* event)
 			lastMousePosition = event->position();
 
 			camera->rightMouse(diff.x(), diff.y(), inputScaleFactor());
+			invalidateFrame();
 		}
 	}
 }
@@ -415,81 +696,133 @@ void RenderWidget::mouseReleaseEvent(QMouseEvent* event)
 	}
 }
 
-void RenderWidget::setBackground(core::ColorRGBA<float> color) {
-	background = color;
+void RenderWidget::setStatisticsOverlay(bool show)
+{
+	showStatistics = show;
+	if (frameStatistics != nullptr) {
+		frameStatistics->setEnabled(showStatistics || frameStatistics->isRecording());
+	}
+	invalidateFrame();
 }
 
-void RenderWidget::renderGrid() {
-	int count = 0;
-	const float plane = 0;
-
-	const GLfloat white[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	const GLfloat black[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+bool RenderWidget::recordStatistics(const QString& path)
+{
+	if (frameStatistics == nullptr || !frameStatistics->startRecording(path)) {
+		return false;
+	}
 
-	glBegin(GL_QUADS);
+	frameStatistics->setEnabled(true);
+	return true;
+}
 
-	for (float i = -20.0f; i <= 20.0f; i += 1.0f) {
-		for (float j = -20.0f; j <= 20.0f; j += 1.0f) {
-			if ((count % 2) == 0) {
-				//glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, black);
-				glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, white);
-				glColor3f(1.0f, 1.0f, 1.0f);
-			}
-			else {
-				//glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, black);	
-				glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, black);
-				glColor3f(0.2f, 0.2f, 0.2f);
-			}
+void RenderWidget::stopRecordingStatistics()
+{
+	if (frameStatistics != nullptr) {
+		frameStatistics->stopRecording();
+		frameStatistics->setEnabled(showStatistics);
+	}
+}
 
-			glNormal3f(0, 1, 0);
+void RenderWidget::compareGpuSkinning()
+{
+	if (gpuSkinning == nullptr) {
+		core::Log::message("GPU skinning comparison unavailable, requires OpenGL 3.3.");
+		return;
+	}
 
-			glVertex3f(j, plane, i);
-			glVertex3f(j, plane, i + 1);
-			glVertex3f(j + 1, plane, i + 1);
-			glVertex3f(j + 1, plane, i);
-			count++;
-		}
+	if (scene == nullptr) {
+		return;
 	}
 
-	glEnd();
-}
+	makeCurrent();
 
-void RenderWidget::renderBounds(const core::Model* model) {
-	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glBegin(GL_TRIANGLES);
-	for (size_t i = 0; i < model->model->getBoundTriangles().size(); i++) {
-		size_t v = model->model->getBoundTriangles()[i];
-		if (v < model->model->getBounds().size()) {
-			glVertex3fv((GLfloat*)&model->model->getBounds()[v]);
+	for (auto& model : scene->models) {
+		const auto difference = gpuSkinning->compare(model.get(), model->model.get());
+		if (difference.has_value()) {
+			core::Log::message(QString("GPU skinning of %1 differs from cpu skinning by up to %2.")
+				.arg(model->getMetaGameFileInfo().toString())
+				.arg(difference.value()));
 		}
 		else {
-			glVertex3f(0, 0, 0);
+			core::Log::message(QString("GPU skinning of %1 could not be compared.").arg(model->getMetaGameFileInfo().toString()));
 		}
 	}
-	glEnd();
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	doneCurrent();
+	invalidateFrame();
 }
 
-void RenderWidget::renderBones(const core::Model* model) {
-	glDisable(GL_DEPTH_TEST);
-	glBegin(GL_LINES);
+void RenderWidget::renderStatisticsOverlay()
+{
+	// results lag a few frames behind, see FrameStatistics.
+	const auto& frame = frameStatistics->getLatest();
+
+	QStringList lines;
+	lines << QString("Frame %1, CPU %2 ms").arg(frame.index).arg(frame.cpuMsecs, 0, 'f', 2);
+
+	if (frameStatistics->hasGpuTimes()) {
+		lines << QString("GPU %1 ms").arg(frame.gpuTotalMsecs, 0, 'f', 2);
+		for (uint32_t phase = 0; phase < FrameStatistics::PHASE_COUNT; phase++) {
+			lines << QString("  %1 %2 ms")
+				.arg(FrameStatistics::getPhaseName((FrameStatistics::Phase)phase))
+				.arg(frame.gpuMsecs[phase], 0, 'f', 2);
+		}
+	}
+
+	lines << QString("Primitives %1").arg(frame.primitives);
+	lines << QString("Draws %1, Texture Binds %2, State Changes %3").arg(frame.draws).arg(frame.textureBinds).arg(frame.stateChanges);
+
+	if (frameScheduler != nullptr) {
+		lines << QString("Frame Time %1 ms, Target %2 FPS").arg(frameScheduler->getFrameTimeMsecs(), 0, 'f', 2).arg(frameScheduler->getTargetFrameRate());
+	}
+
+	// QPainter has its own GL state, the fixed function state is restored afterwards.
+	glPushAttrib(GL_ALL_ATTRIB_BITS);
+	glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+
+	{
+		QPainter painter(this);
+		painter.setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+		const QFontMetrics metrics(painter.font());
+		const int margin = 8;
+		int text_width = 0;
+		for (const auto& line : lines) {
+			text_width = std::max(text_width, metrics.horizontalAdvance(line));
+		}
+
+		painter.fillRect(QRect(margin, margin, text_width + (margin * 2), (metrics.height() * (int)lines.size()) + (margin * 2)), QColor(0, 0, 0, 160));
+		painter.setPen(Qt::white);
 
-	for (const auto& bone : model->model->getBoneAdaptors()) {
-		if (bone->getParentBoneId() != -1) {
-			const auto& point1 = bone->getTranslationPivot();
-			const auto& point2 = model->model->getBoneAdaptors()[bone->getParentBoneId()]->getTranslationPivot();
-			glVertex3fv((GLfloat*)&point1);
-			glVertex3fv((GLfloat*)&point2);
+		for (int i = 0; i < lines.size(); i++) {
+			painter.drawText(margin * 2, (margin * 2) + metrics.ascent() + (metrics.height() * i), lines[i]);
 		}
 	}
 
-	glEnd();
-	glEnable(GL_DEPTH_TEST);
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopClientAttrib();
+	glPopAttrib();
+}
+
+void RenderWidget::setBackground(core::ColorRGBA<float> color) {
+	background = color;
+	invalidateFrame();
+}
+
+void RenderWidget::deferParticles(const core::ModelTextureInfo* model_texture, const core::M2Model* raw_model, const core::Matrix& model_view) {
+	deferredParticles.push_back({ model_view, model_texture, raw_model });
 }
 
-void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture, const core::M2Model* raw_model) {
+void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture, const core::M2Model* raw_model, const core::Matrix& model_view) {
 
-	glPushMatrix();
+	loadModelView(model_view);
 
 	glPushAttrib(GL_ALL_ATTRIB_BITS);
 	glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
@@ -555,41 +888,44 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 			GL_TEXTURE2_ARB
 		};
 
-		std::array<GLint, 3> textures = {
-			core::Texture::INVALID_ID,
-			core::Texture::INVALID_ID,
-			core::Texture::INVALID_ID
-		};
-		
-		auto tex_match_index = 0;
-		for (auto src_tex : particle_textures) {
-			if (model_texture->textures.contains(src_tex)) {
-				auto tmp_tex_id = model_texture->textures.at(src_tex)->id;
-				textures[tex_match_index] = tmp_tex_id;
-
-				glActiveTextureARB(texture_bindings[tex_match_index]);
-				glEnable(GL_TEXTURE_2D);
-				glBindTexture(GL_TEXTURE_2D, tmp_tex_id);
-				glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
-				glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_MODULATE);
-				glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_MODULATE);
-
-				if (tex_match_index == 0 && particle_textures.size() > 1) {
-					glTexEnvf(GL_TEXTURE_ENV, GL_RGB_SCALE, 4.0);
-					glTexEnvf(GL_TEXTURE_ENV, GL_ALPHA_SCALE, 4.0);
-				}
+		std::array<GLuint, 3> textures = {};
+		uint32_t texture_count = 0;
 
-				tex_match_index++;
+		for (auto src_tex : particle_textures) {
+			if (model_texture->textures.contains(src_tex) && texture_count < textures.size()) {
+				textures[texture_count++] = model_texture->textures.at(src_tex)->id;
 			}
 		}
 
-		assert(textures[0] != core::Texture::INVALID_ID);
+		assert(texture_count > 0);
+
+		if (texture_count == 0) {
+			continue;
+		}
+
+		frameStatistics->countDraws();
+		frameStatistics->countTextureBinds(texture_count);
 
-		if (textures[0] == core::Texture::INVALID_ID) {
-			return;
+		if (particleRenderer) {
+			particleRenderer->render(particle, textures, texture_count, model_view, projectionMatrix);
+			continue;
 		}
 
-		if (tex_match_index > 1) {
+		for (uint32_t i = 0; i < texture_count; i++) {
+			glActiveTextureARB(texture_bindings[i]);
+			glEnable(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, textures[i]);
+			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_MODULATE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_MODULATE);
+
+			if (i == 0 && texture_count > 1) {
+				glTexEnvf(GL_TEXTURE_ENV, GL_RGB_SCALE, 4.0);
+				glTexEnvf(GL_TEXTURE_ENV, GL_ALPHA_SCALE, 4.0);
+			}
+		}
+
+		if (texture_count > 1) {
 			glActiveTextureARB(GL_TEXTURE0_ARB);
 		}
 
@@ -610,11 +946,8 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 
 		if (billboard) {
 			//TODO CHECK BILLBOARD LOGIC!
-			float modelview[16];
-			glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
-
-			vRight = core::Vector3(modelview[0], modelview[4], modelview[8]);
-			vUp = core::Vector3(modelview[1], modelview[5], modelview[9]); // Spherical billboarding
+			vRight = core::Vector3(model_view.m[0][0], model_view.m[0][1], model_view.m[0][2]);
+			vUp = core::Vector3(model_view.m[1][0], model_view.m[1][1], model_view.m[1][2]); // Spherical billboarding
 			//vUp = Vec3D(0,1,0); // Cylindrical billboarding
 		}
 
@@ -669,30 +1002,30 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 
 
 			glMultiTexCoord2fvARB(GL_TEXTURE0_ARB, (GLfloat*)&tiles[it->tile].texCoord[0]);
-			if (tex_match_index > 1)
+			if (texture_count > 1)
 				glMultiTexCoord2fvARB(GL_TEXTURE1_ARB, (GLfloat*)&tiles[it->tile].texCoord[0]);
-			if (tex_match_index > 2)
+			if (texture_count > 2)
 				glMultiTexCoord2fvARB(GL_TEXTURE2_ARB, (GLfloat*)&tiles[it->tile].texCoord[0]);
 			glVertex3fv(vert1);
 
 			glMultiTexCoord2fvARB(GL_TEXTURE0_ARB, (GLfloat*)&tiles[it->tile].texCoord[1]);
-			if (tex_match_index > 1)
+			if (texture_count > 1)
 				glMultiTexCoord2fvARB(GL_TEXTURE1_ARB, (GLfloat*)&tiles[it->tile].texCoord[1]);
-			if (tex_match_index > 2)
+			if (texture_count > 2)
 				glMultiTexCoord2fvARB(GL_TEXTURE2_ARB, (GLfloat*)&tiles[it->tile].texCoord[1]);
 			glVertex3fv(vert2);
 
 			glMultiTexCoord2fvARB(GL_TEXTURE0_ARB, (GLfloat*)&tiles[it->tile].texCoord[2]);
-			if (tex_match_index > 1)
+			if (texture_count > 1)
 				glMultiTexCoord2fvARB(GL_TEXTURE1_ARB, (GLfloat*)&tiles[it->tile].texCoord[2]);
-			if (tex_match_index > 2)
+			if (texture_count > 2)
 				glMultiTexCoord2fvARB(GL_TEXTURE2_ARB, (GLfloat*)&tiles[it->tile].texCoord[2]);
 			glVertex3fv(vert3);
 
 			glMultiTexCoord2fvARB(GL_TEXTURE0_ARB, (GLfloat*)&tiles[it->tile].texCoord[3]);
-			if (tex_match_index > 1)
+			if (texture_count > 1)
 				glMultiTexCoord2fvARB(GL_TEXTURE1_ARB, (GLfloat*)&tiles[it->tile].texCoord[3]);
-			if (tex_match_index > 2)
+			if (texture_count > 2)
 				glMultiTexCoord2fvARB(GL_TEXTURE2_ARB, (GLfloat*)&tiles[it->tile].texCoord[3]);
 			glVertex3fv(vert4);
 
@@ -700,7 +1033,7 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 		glEnd();
 
 
-		for (auto exit_index = 0; exit_index < tex_match_index; exit_index++) {
+		for (uint32_t exit_index = 0; exit_index < texture_count; exit_index++) {
 
 			glActiveTextureARB(texture_bindings[exit_index]);
 			if (exit_index == 0) {
@@ -710,7 +1043,7 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 			glDisable(GL_TEXTURE_2D);
 		}
 
-		if (tex_match_index > 1) {
+		if (texture_count > 1) {
 			glActiveTextureARB(GL_TEXTURE0_ARB);
 		}
 
@@ -734,6 +1067,7 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 		if (texture != core::Texture::INVALID_ID) {
 			glEnable(GL_TEXTURE_2D);
 			glBindTexture(GL_TEXTURE_2D, texture);	
+			frameStatistics->countTextureBinds();
 		}
 
 		glEnable(GL_BLEND);
@@ -744,29 +1078,17 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 		glColor4fv((GLfloat*)&tcolor);
 
-		glBegin(GL_QUAD_STRIP);
-		auto it = ribbon->getSegments().begin();
-		float l = 0;
-		for (; it != ribbon->getSegments().end(); ++it) {
-			float u = l / ribbon->getLength();
-
-			glTexCoord2f(u, 0);
-			glVertex3fv(it->position + ribbon->getTAbove() * it->up);
-			glTexCoord2f(u, 1);
-			glVertex3fv(it->position - ribbon->getTBelow() * it->up);
-
-			l += it->len;
-		}
-
-		if (ribbon->getSegments().size() > 1) {
-			// last segment...?
-			--it;
-			glTexCoord2f(1, 0);
-			glVertex3fv(it->position + ribbon->getTAbove() * it->up + (it->len / it->len0) * it->back);
-			glTexCoord2f(1, 1);
-			glVertex3fv(it->position - ribbon->getTBelow() * it->up + (it->len / it->len0) * it->back);
+		const auto& strip = ribbon->getStrip();
+		if (strip.size() >= 4) {
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glVertexPointer(3, GL_FLOAT, sizeof(core::ModelRibbonEmitterAdaptor::RibbonVertex), &strip[0].position);
+			glTexCoordPointer(2, GL_FLOAT, sizeof(core::ModelRibbonEmitterAdaptor::RibbonVertex), &strip[0].texCoords);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)strip.size());
+			frameStatistics->countDraws();
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
 		}
-		glEnd();
 
 		glColor4f(1, 1, 1, 1);
 		glEnable(GL_LIGHTING);
@@ -780,8 +1102,6 @@ void RenderWidget::renderParticles(const core::ModelTextureInfo* model_texture,
 
 	glPopAttrib();
 	glPopClientAttrib();
-
-	glPopMatrix();
 }
 
 inline float RenderWidget::inputScaleFactor()
@@ -3,12 +3,22 @@
 #include <QWidget>
 #include <QtOpenGLWidgets/QOpenGLWidget>
 #include <QOpenGLExtraFunctions>
+#include <QElapsedTimer>
 #include "core/modeling/Model.h"
 #include "core/utility/Color.h"
+#include "core/utility/FixedStepClock.h"
 #include "Camera.h"
+#include "GpuSkinning.h"
+#include "ShaderPassRenderer.h"
+#include "RenderQueue.h"
+#include "ParticleRenderer.h"
+#include "DebugRenderer.h"
+#include "FrameStatistics.h"
 #include "WidgetUsesScene.h"
 #include <memory>
 
+class FrameScheduler;
+
 class RenderWidget : public QOpenGLWidget, protected QOpenGLExtraFunctions, public WidgetUsesScene
 {
 	Q_OBJECT
@@ -19,9 +29,30 @@ public:
 	RenderWidget(QWidget *parent = nullptr);
 	~RenderWidget();
 
+	void onSceneLoaded(core::Scene* new_scene) override;
+
+	// state changes made and avoided by the render queue in the last frame.
+	const ShaderPassRenderer::Stats& getRenderStats() const {
+		return renderStats;
+	}
+
+	// target frame rate and measured frame time.
+	const FrameScheduler* getFrameScheduler() const {
+		return frameScheduler;
+	}
+
 public slots:
 	void setBackground(core::ColorRGBA<float> color);
 	void resetCamera();
+	// request a frame when nothing is animating, camera input and scene signals already do.
+	void invalidateFrame();
+	void setStatisticsOverlay(bool show);
+	// frame statistics are written to the csv file until stopped, false when it cannot be opened.
+	bool recordStatistics(const QString& path);
+	void stopRecordingStatistics();
+	// skin each scene model with the shaders and on the cpu, logging the largest difference.
+	// only runs when the context supports gpu skinning.
+	void compareGpuSkinning();
 
 protected:
 	void initializeGL() override;
@@ -43,10 +74,83 @@ private:
 	std::optional<QPointF> lastMousePosition;
 	std::unique_ptr<Camera> camera;
 
-	void renderGrid();
-	void renderBounds(const core::Model* model);
-	void renderBones(const core::Model* model);
-	void renderParticles(const core::ModelTextureInfo* model_texture, const core::M2Model* raw_model);
+	// workers used to update scene models in parallel, kept separate from the global pool used for loading.
+	QThreadPool* updatePool;
+
+	// null until initializeGL.
+	FrameScheduler* frameScheduler;
+
+	// whether frames are needed continuously.
+	bool isAnimating() const;
+	// applies a change of config::rendering::target_fps, after initializeGL.
+	void setTargetFrameRate(int32_t fps);
+
+	// steps simulated per frame before the backlog is dropped, stops a stall turning into a burst of catch-up work.
+	static constexpr uint32_t maxCatchUpSteps = 4;
+	std::unique_ptr<core::FixedStepClock> simulationClock;
+	QElapsedTimer frameTimer;
+
+	// both null when the context doesnt support them.
+	std::unique_ptr<GpuSkinning> gpuSkinning;
+	std::unique_ptr<ShaderPassRenderer> shaderPassRenderer;
+	// null when the context doesnt support instancing, particles are then drawn in immediate mode.
+	std::unique_ptr<ParticleRenderer> particleRenderer;
+
+	// grid, bounds and bones overlays.
+	std::unique_ptr<DebugRenderer> debugRenderer;
+	// half the width of the grid, in world units.
+	static constexpr int32_t gridExtent = 20;
+
+	// only collects while the overlay is shown or statistics are being recorded.
+	std::unique_ptr<FrameStatistics> frameStatistics;
+	bool showStatistics;
+	void renderStatisticsOverlay();
+	// decided once per update, so skipping cpu skinning and rendering agree.
+	bool gpuSkinningActive;
+
+	// set by resizeGL, for building the view frustum of each component.
+	core::Matrix projectionMatrix;
+
+	// frustum in the space of the component, also kept by the component to cull its next update.
+	core::Frustum updateViewFrustum(core::ModelAnimationInfo* component, const core::Matrix& model_view);
+
+	// bounds are empty until the component has been updated, they arent culled until then.
+	static bool isVisible(const core::Frustum& frustum, const core::BoundingSphere& bounds) {
+		return bounds.isEmpty() || frustum.intersects(bounds);
+	}
+
+	// passes are collected here during paintGL, then drawn together once all models have been visited.
+	RenderQueue renderQueue;
+	ShaderPassRenderer::Stats renderStats;
+
+	// particles dont write depth, so are drawn after the queued passes rather than being drawn over.
+	struct DeferredParticles {
+		core::Matrix modelView;
+		const core::ModelTextureInfo* textureInfo;
+		const core::M2Model* model;
+	};
+
+	std::vector<DeferredParticles> deferredParticles;
+
+	// binds the component for the render queue, gpu skinned when enabled, otherwise streaming its cpu skinned vertices.
+	// returns false only without the shader pass renderer, or for components without geometry, their passes are then drawn through the fixed function path.
+	bool queueGeometry(const core::ModelAnimationInfo* animation_info, const core::M2Model* raw_model, const core::Matrix& model_view, bool wireframe);
+	void flushRenderQueue();
+	// queued passes are added to the render queue, the rest are drawn immediately through ModelRenderPassRenderer.
+	// passes of geosets outside the frustum are skipped.
+	void renderPass(bool queued,
+		const core::Frustum& frustum,
+		const core::RenderOptions& render_options,
+		const core::ModelTextureInfo* texture_info,
+		const core::ModelAnimationInfo* animation_info,
+		const core::M2Model* raw_model,
+		const core::MaterialAnimationState& materials,
+		const core::ModelRenderPass& pass,
+		uint32_t pass_index);
+
+	void deferParticles(const core::ModelTextureInfo* model_texture, const core::M2Model* raw_model, const core::Matrix& model_view);
+
+	void renderParticles(const core::ModelTextureInfo* model_texture, const core::M2Model* raw_model, const core::Matrix& model_view);
 
 	inline float inputScaleFactor();
 
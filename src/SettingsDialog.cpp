@@ -70,6 +70,14 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 
 	//TODO connect saving active item
 
+	{
+		const auto support = VideoCapabilities::support();
+		ui.checkBoxGpuSkinning->setEnabled(support.glsl && support.textureBufferObject);
+		ui.checkBoxGpuSkinning->setChecked(Settings::get<bool>(config::rendering::gpu_skinning));
+	}
+
+	ui.spinBoxTargetFps->setValue(Settings::get<int32_t>(config::rendering::target_fps));
+
 	const auto cam_type = Settings::get(config::rendering::camera_type);
 	ui.radioButtonArcball->setChecked(cam_type == ArcBallCamera::identifier);
 	ui.radioButtonBasic->setChecked(cam_type == BasicCamera::identifier);
@@ -92,6 +100,8 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 		}
 
 		Settings::instance()->set(config::rendering::camera_hide_mouse, ui.checkBoxHideCursor->isChecked());
+		Settings::instance()->set(config::rendering::gpu_skinning, ui.checkBoxGpuSkinning->isChecked());
+		Settings::instance()->set(config::rendering::target_fps, (int32_t)ui.spinBoxTargetFps->value());
 
 		Settings::instance()->save();
 
@@ -0,0 +1,521 @@
+#include "stdafx.h"
+#include "ShaderPassRenderer.h"
+#include "ModelRenderPassRenderer.h"
+#include "core/utility/Logger.h"
+
+using namespace core;
+
+namespace {
+
+	// follows GpuSkinning::SKINNING_SHADER.
+	const char* VERTEX_SHADER = R"(
+in vec3 position;
+in vec3 normal;
+in vec2 textureCoords;
+in vec4 bones;
+in vec4 weights;
+in mat4 modelView;
+in int paletteOffset;
+
+uniform mat4 projection;
+uniform mat4 textureMatrix;
+
+out vec2 texCoord;
+
+void main() {
+	vec3 skinned_position;
+	vec3 skinned_normal;
+	skin(position, normal, bones, weights, paletteOffset, skinned_position, skinned_normal);
+
+	vec4 eye_position = modelView * vec4(skinned_position, 1.0);
+	gl_Position = projection * eye_position;
+
+	vec4 coords = vec4(textureCoords, 0.0, 1.0);
+
+#ifdef ENV_MAP
+	// equivalent of GL_SPHERE_MAP texture generation.
+	vec3 eye_normal = normalize(transpose(inverse(mat3(modelView))) * skinned_normal);
+	vec3 r = reflect(normalize(eye_position.xyz), eye_normal);
+	float m = 2.0 * sqrt(r.x * r.x + r.y * r.y + (r.z + 1.0) * (r.z + 1.0));
+	coords.xy = (r.xy / m) + 0.5;
+#endif
+
+	texCoord = (textureMatrix * coords).xy;
+}
+)";
+
+	const char* FRAGMENT_SHADER = R"(
+in vec2 texCoord;
+
+uniform sampler2D diffuse;
+uniform bool textured;
+uniform vec4 color;
+uniform vec3 emission;
+// scene lighting, lit colors ignore the vertex color as they do with fixed function lighting.
+uniform vec3 sceneAmbient;
+uniform float materialAlpha;
+
+out vec4 fragColor;
+
+void main() {
+#ifdef UNLIT
+	vec4 result = color;
+#else
+	vec4 result = vec4(min(emission + sceneAmbient, vec3(1.0)), materialAlpha);
+#endif
+
+	if (textured) {
+		result *= texture(diffuse, texCoord);
+	}
+
+#ifdef ALPHA_TEST
+	if (result.a < 0.7) {
+		discard;
+	}
+#endif
+
+	fragColor = result;
+}
+)";
+
+	GLuint compileShader(GLenum type, const std::string& source) {
+		const char* source_ptr = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source_ptr, nullptr);
+		glCompileShader(shader);
+
+		GLint status = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (status != GL_TRUE) {
+			GLchar info[1024] = {};
+			glGetShaderInfoLog(shader, sizeof(info), nullptr, info);
+			Log::message(QString("Pass shader failed to compile: %1").arg(info));
+			glDeleteShader(shader);
+			return 0;
+		}
+
+		return shader;
+	}
+
+	// equivalent of the texture matrix ModelRenderPassRenderer builds.
+	Matrix textureMatrixOf(const MaterialAnimationState& materials, const ModelRenderPass& pass) {
+		Matrix result = Matrix::identity();
+
+		if (pass.texanim == -1) {
+			return result;
+		}
+
+		const auto* texAnim = materials.getTextureAnimation(pass.texanim);
+		if (texAnim == nullptr) {
+			return result;
+		}
+
+		if (texAnim->translated) {
+			result *= Matrix::newTranslation(texAnim->translation);
+		}
+
+		if (texAnim->rotated) {
+			const float radians = texAnim->rotation.x * (float)(PI / 180.0);
+			Matrix rotation = Matrix::identity();
+			rotation.m[0][0] = std::cos(radians);
+			rotation.m[0][1] = -std::sin(radians);
+			rotation.m[1][0] = std::sin(radians);
+			rotation.m[1][1] = std::cos(radians);
+			result *= rotation;
+		}
+
+		if (texAnim->scaled) {
+			result *= Matrix::newScale(texAnim->scale);
+		}
+
+		return result;
+	}
+
+	std::pair<GLenum, GLenum> blendFuncOf(BlendMode mode) {
+		switch (mode) {
+		case BlendMode::BM_ADDITIVE:
+			return { GL_SRC_COLOR, GL_ONE };
+		case BlendMode::BM_ADDITIVE_ALPHA:
+			return { GL_SRC_ALPHA, GL_ONE };
+		case BlendMode::BM_MODULATE:
+		case BlendMode::BM_MODULATEX2:
+			return { GL_DST_COLOR, GL_SRC_COLOR };
+		case BlendMode::BM_BLEND_ADD:
+			return { GL_ONE, GL_ONE_MINUS_SRC_ALPHA };
+		case BlendMode::BM_OPAQUE:
+		case BlendMode::BM_TRANSPARENT:
+		case BlendMode::BM_ALPHA_BLEND:
+			return { GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA };
+		default:
+			assert(false);
+			return { GL_DST_COLOR, GL_SRC_COLOR };
+		}
+	}
+}
+
+ShaderPassRenderer::ShaderPassRenderer() :
+	projection(Matrix::identity()),
+	batch(0),
+	vertexArray(0),
+	instanceBuffer(0)
+{
+	samplers.fill(0);
+}
+
+ShaderPassRenderer::~ShaderPassRenderer()
+{
+	for (auto& program : programs) {
+		if (program.id != 0) {
+			glDeleteProgram(program.id);
+		}
+	}
+
+	if (instanceBuffer != 0) {
+		glDeleteBuffers(1, &instanceBuffer);
+	}
+
+	if (vertexArray != 0) {
+		glDeleteVertexArrays(1, &vertexArray);
+	}
+
+	if (samplers[0] != 0) {
+		glDeleteSamplers((GLsizei)samplers.size(), samplers.data());
+	}
+}
+
+bool ShaderPassRenderer::initialise()
+{
+	if (!GLEW_VERSION_3_3) {
+		Log::message("Shader pass renderer unavailable, requires OpenGL 3.3.");
+		return false;
+	}
+
+	if (!compile(PERMUTATION_NONE, programs[PERMUTATION_NONE])) {
+		return false;
+	}
+
+	glGenBuffers(1, &instanceBuffer);
+
+	// arrays are enabled once, binding meshes and instances only changes where they point.
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+	for (GLuint attribute = GpuSkinning::ATTRIBUTE_POSITION; attribute <= GpuSkinning::ATTRIBUTE_WEIGHTS; attribute++) {
+		glEnableVertexAttribArray(attribute);
+	}
+	for (GLuint column = 0; column < 4; column++) {
+		glEnableVertexAttribArray(ATTRIBUTE_MODEL_VIEW + column);
+		glVertexAttribDivisor(ATTRIBUTE_MODEL_VIEW + column, 1);
+	}
+	glEnableVertexAttribArray(ATTRIBUTE_PALETTE_OFFSET);
+	glVertexAttribDivisor(ATTRIBUTE_PALETTE_OFFSET, 1);
+	glBindVertexArray(0);
+
+	// filtering matches what textures are created with, see TextureManager.
+	glGenSamplers((GLsizei)samplers.size(), samplers.data());
+	for (uint32_t i = 0; i < samplers.size(); i++) {
+		glSamplerParameteri(samplers[i], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glSamplerParameteri(samplers[i], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glSamplerParameteri(samplers[i], GL_TEXTURE_WRAP_S, (i & SAMPLER_WRAP_S) ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+		glSamplerParameteri(samplers[i], GL_TEXTURE_WRAP_T, (i & SAMPLER_WRAP_T) ? GL_REPEAT : GL_CLAMP_TO_EDGE);
+	}
+
+	return true;
+}
+
+const char* ShaderPassRenderer::getStateTypeName(StateType type)
+{
+	switch (type) {
+	case STATE_PROGRAM:
+		return "Program";
+	case STATE_MESH:
+		return "Mesh";
+	case STATE_TRANSFORM:
+		return "Transform";
+	case STATE_TEXTURE:
+		return "Texture";
+	case STATE_SAMPLER:
+		return "Sampler";
+	case STATE_BLEND:
+		return "Blend";
+	case STATE_CULL:
+		return "Cull";
+	case STATE_DEPTH_WRITE:
+		return "Depth Write";
+	case STATE_POLYGON_MODE:
+		return "Polygon Mode";
+	default:
+		assert(false);
+		return "";
+	}
+}
+
+std::optional<ShaderPassRenderer::Draw> ShaderPassRenderer::prepare(const RenderOptions& renderOptions,
+	const ModelTextureInfo* textureInfo,
+	const MaterialAnimationState& materials,
+	const ModelRenderPass& pass)
+{
+	const auto pass_color = ModelRenderPassRenderer::calculateColor(renderOptions, materials, pass);
+	if (!pass_color.has_value()) {
+		return std::nullopt;
+	}
+
+	Draw draw;
+
+	if (pass.blendmode == BlendMode::BM_TRANSPARENT) {
+		draw.permutation |= PERMUTATION_ALPHA_TEST;
+	}
+	if (pass.unlit) {
+		draw.permutation |= PERMUTATION_UNLIT;
+	}
+	if (pass.useEnvMap) {
+		draw.permutation |= PERMUTATION_ENV_MAP;
+	}
+
+	draw.texture = renderOptions.showTexture ? textureInfo->getTextureId(pass.tex) : Texture::INVALID_ID;
+	draw.textured = draw.texture != Texture::INVALID_ID;
+	draw.swrap = pass.swrap;
+	draw.twrap = pass.twrap;
+
+	draw.color = pass_color->color;
+	draw.emission = pass_color->emission;
+	draw.textureMatrix = textureMatrixOf(materials, pass);
+
+	// opaque passes are still blended when faded out.
+	draw.blendMode = (BlendMode)pass.blendmode;
+	draw.blend = (pass.blendmode > BlendMode::BM_TRANSPARENT) || draw.color.w < 1.0f;
+	draw.cull = pass.cull;
+	draw.depthWrite = !pass.noZWrite;
+
+	draw.indexStart = pass.indexStart;
+	draw.indexCount = pass.indexCount;
+
+	return draw;
+}
+
+bool ShaderPassRenderer::isSameState(const Draw& a, const Draw& b)
+{
+	const auto same_vector = [](const Vector4& x, const Vector4& y) {
+		return x.x == y.x && x.y == y.y && x.z == y.z && x.w == y.w;
+	};
+
+	return a.permutation == b.permutation &&
+		a.texture == b.texture &&
+		a.textured == b.textured &&
+		a.swrap == b.swrap &&
+		a.twrap == b.twrap &&
+		a.blend == b.blend &&
+		a.blendMode == b.blendMode &&
+		a.cull == b.cull &&
+		a.depthWrite == b.depthWrite &&
+		same_vector(a.color, b.color) &&
+		a.emission.has_value() == b.emission.has_value() &&
+		(!a.emission.has_value() || same_vector(*a.emission, *b.emission)) &&
+		std::equal(&a.textureMatrix.m[0][0], &a.textureMatrix.m[0][0] + 16, &b.textureMatrix.m[0][0]) &&
+		a.indexStart == b.indexStart &&
+		a.indexCount == b.indexCount;
+}
+
+void ShaderPassRenderer::begin(const std::vector<Instance>& instances, const Matrix& _projection)
+{
+	batch++;
+	state = State();
+
+	projection = _projection;
+	projection.transpose();
+
+	glBindVertexArray(vertexArray);
+
+	// orphan the previous contents rather than waiting on draws still using them.
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STREAM_DRAW);
+}
+
+void ShaderPassRenderer::render(const GpuSkinning::Mesh& mesh, bool wireframe, const Draw& draw, uint32_t first_instance, uint32_t instance_count)
+{
+	auto* program = useProgram(draw.permutation);
+	if (program == nullptr) {
+		return;
+	}
+
+	change(STATE_TRANSFORM, state.firstInstance, first_instance, [this](uint32_t value) {
+		bindInstances(value);
+	});
+
+	change(STATE_MESH, state.mesh, &mesh, [](const GpuSkinning::Mesh* value) {
+		GpuSkinning::bind(*value);
+	});
+
+	change(STATE_POLYGON_MODE, state.wireframe, wireframe, [](bool value) {
+		glPolygonMode(GL_FRONT_AND_BACK, value ? GL_LINE : GL_FILL);
+	});
+
+	glUniform4f(program->color, draw.color.x, draw.color.y, draw.color.z, draw.color.w);
+	if (draw.emission.has_value()) {
+		glUniform3f(program->emission, draw.emission->x, draw.emission->y, draw.emission->z);
+	}
+	else {
+		glUniform3f(program->emission, lighting.emission.x, lighting.emission.y, lighting.emission.z);
+	}
+	glUniformMatrix4fv(program->textureMatrix, 1, GL_TRUE, &draw.textureMatrix.m[0][0]);
+	glUniform1i(program->textured, draw.textured ? 1 : 0);
+
+	change(STATE_TEXTURE, state.texture, draw.texture, [](GLuint value) {
+		glBindTexture(GL_TEXTURE_2D, value);
+	});
+
+	if (draw.textured) {
+		change(STATE_SAMPLER, state.sampler, samplerOf(draw.swrap, draw.twrap), [](GLuint value) {
+			glBindSampler(0, value);
+		});
+	}
+
+	change(STATE_BLEND, state.blend, draw.blend, [](bool value) {
+		value ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	});
+
+	if (draw.blend) {
+		change(STATE_BLEND, state.blendFunc, blendFuncOf(draw.blendMode), [](const std::pair<GLenum, GLenum>& value) {
+			glBlendFunc(value.first, value.second);
+		});
+	}
+
+	change(STATE_CULL, state.cull, draw.cull, [](bool value) {
+		value ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+	});
+
+	change(STATE_DEPTH_WRITE, state.depthWrite, draw.depthWrite, [](bool value) {
+		glDepthMask(value ? GL_TRUE : GL_FALSE);
+	});
+
+	glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)draw.indexCount, GL_UNSIGNED_SHORT, (void*)(draw.indexStart * sizeof(uint16_t)), (GLsizei)instance_count);
+	stats.draws++;
+	stats.instances += instance_count;
+}
+
+void ShaderPassRenderer::end()
+{
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(0);
+	glBindSampler(0, 0);
+	glDisable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_CULL_FACE);
+	glDepthMask(GL_TRUE);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	state = State();
+}
+
+ShaderPassRenderer::Program* ShaderPassRenderer::useProgram(uint32_t permutation)
+{
+	assert(permutation < PERMUTATION_COUNT);
+	auto& program = programs[permutation];
+
+	if (program.id == 0 && !compile(permutation, program)) {
+		return nullptr;
+	}
+
+	change(STATE_PROGRAM, state.program, program.id, [](GLuint value) {
+		glUseProgram(value);
+	});
+
+	if (program.batch != batch) {
+		glUniformMatrix4fv(program.projection, 1, GL_FALSE, projection);
+		glUniform3f(program.sceneAmbient, lighting.sceneAmbient.x, lighting.sceneAmbient.y, lighting.sceneAmbient.z);
+		glUniform1f(program.materialAlpha, lighting.alpha);
+		program.batch = batch;
+	}
+
+	return &program;
+}
+
+bool ShaderPassRenderer::compile(uint32_t permutation, Program& program)
+{
+	if (program.failed) {
+		return false;
+	}
+
+	std::string defines = "#version 150\n";
+	defines += "#define PALETTE_STRIDE " + std::to_string(GpuSkinning::PALETTE_STRIDE) + "\n";
+
+	if (permutation & PERMUTATION_ALPHA_TEST) {
+		defines += "#define ALPHA_TEST\n";
+	}
+	if (permutation & PERMUTATION_UNLIT) {
+		defines += "#define UNLIT\n";
+	}
+	if (permutation & PERMUTATION_ENV_MAP) {
+		defines += "#define ENV_MAP\n";
+	}
+
+	GLuint vertex_shader = compileShader(GL_VERTEX_SHADER, defines + GpuSkinning::SKINNING_SHADER + VERTEX_SHADER);
+	GLuint fragment_shader = compileShader(GL_FRAGMENT_SHADER, defines + FRAGMENT_SHADER);
+
+	if (vertex_shader == 0 || fragment_shader == 0) {
+		glDeleteShader(vertex_shader);
+		glDeleteShader(fragment_shader);
+		program.failed = true;
+		return false;
+	}
+
+	GLuint id = glCreateProgram();
+	glAttachShader(id, vertex_shader);
+	glAttachShader(id, fragment_shader);
+	glBindAttribLocation(id, GpuSkinning::ATTRIBUTE_POSITION, "position");
+	glBindAttribLocation(id, GpuSkinning::ATTRIBUTE_NORMAL, "normal");
+	glBindAttribLocation(id, GpuSkinning::ATTRIBUTE_TEXTURE_COORDS, "textureCoords");
+	glBindAttribLocation(id, GpuSkinning::ATTRIBUTE_BONES, "bones");
+	glBindAttribLocation(id, GpuSkinning::ATTRIBUTE_WEIGHTS, "weights");
+	glBindAttribLocation(id, ATTRIBUTE_MODEL_VIEW, "modelView");
+	glBindAttribLocation(id, ATTRIBUTE_PALETTE_OFFSET, "paletteOffset");
+	glBindFragDataLocation(id, 0, "fragColor");
+	glLinkProgram(id);
+	glDeleteShader(vertex_shader);
+	glDeleteShader(fragment_shader);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(id, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		GLchar info[1024] = {};
+		glGetProgramInfoLog(id, sizeof(info), nullptr, info);
+		Log::message(QString("Pass shader failed to link: %1").arg(info));
+		glDeleteProgram(id);
+		program.failed = true;
+		return false;
+	}
+
+	program.id = id;
+	program.projection = glGetUniformLocation(id, "projection");
+	program.textureMatrix = glGetUniformLocation(id, "textureMatrix");
+	program.color = glGetUniformLocation(id, "color");
+	program.textured = glGetUniformLocation(id, "textured");
+	program.emission = glGetUniformLocation(id, "emission");
+	program.sceneAmbient = glGetUniformLocation(id, "sceneAmbient");
+	program.materialAlpha = glGetUniformLocation(id, "materialAlpha");
+
+	// samplers never change unit.
+	GLint previous = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+	glUseProgram(id);
+	glUniform1i(glGetUniformLocation(id, "diffuse"), 0);
+	glUniform1i(glGetUniformLocation(id, "palette"), GpuSkinning::PALETTE_UNIT);
+	glUseProgram(previous);
+
+	return true;
+}
+
+void ShaderPassRenderer::bindInstances(uint32_t first_instance)
+{
+	// attribute pointers keep the buffer bound when they are set, so meshes can be bound afterwards.
+	const size_t offset = first_instance * sizeof(Instance);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+	for (GLuint column = 0; column < 4; column++) {
+		glVertexAttribPointer(ATTRIBUTE_MODEL_VIEW + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+			(void*)(offset + offsetof(Instance, modelView) + (column * 4 * sizeof(float))));
+	}
+
+	glVertexAttribIPointer(ATTRIBUTE_PALETTE_OFFSET, 1, GL_INT, sizeof(Instance), (void*)(offset + offsetof(Instance, paletteOffset)));
+}
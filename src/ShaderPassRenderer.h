@@ -0,0 +1,209 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <utility>
+#include <vector>
+#include "core/modeling/Model.h"
+#include "core/modeling/MaterialAnimation.h"
+#include "GpuSkinning.h"
+
+/// <summary>
+/// Programmable replacement for ModelRenderPassRenderer, drawing the vertex data bound by GpuSkinning.
+/// Alpha test, lighting and environment mapping are shader permutations. Colors, texture animation, the projection
+/// and the scene lighting are uniforms owned by the renderer, nothing is read back from GL and no matrix, material,
+/// lighting or texture environment state is used. Vertex input goes through the renderer's own vertex array object.
+/// The remaining GL state (blending, culling, depth writes, polygon mode, bindings, samplers) is cached, only changes are sent to GL.
+/// Every draw is instanced, the modelview and palette offset of each component are per instance attributes,
+/// so copies of a model drawn with the same state are submitted together.
+/// </summary>
+class ShaderPassRenderer
+{
+public:
+
+	enum Permutation : uint32_t {
+		PERMUTATION_NONE = 0,
+		PERMUTATION_ALPHA_TEST = 1 << 0,
+		PERMUTATION_UNLIT = 1 << 1,
+		PERMUTATION_ENV_MAP = 1 << 2,
+		PERMUTATION_COUNT = 1 << 3
+	};
+
+	// everything needed to draw a pass, resolved from the pass and its material animation.
+	struct Draw {
+		uint32_t permutation = PERMUTATION_NONE;
+		GLuint texture = 0;
+		bool textured = false;
+		bool swrap = false;
+		bool twrap = false;
+		bool blend = false;
+		core::BlendMode blendMode = core::BlendMode::BM_OPAQUE;
+		bool cull = false;
+		bool depthWrite = true;
+		core::Vector4 color;
+		// material emission of lit passes, empty uses the emission of the scene lighting.
+		std::optional<core::Vector4> emission;
+		core::Matrix textureMatrix;
+		uint32_t indexStart = 0;
+		uint32_t indexCount = 0;
+	};
+
+	// component the pass belongs to, streamed to the instance buffer once per batch.
+	struct Instance {
+		// column major.
+		std::array<float, 16> modelView;
+		GLint paletteOffset;
+	};
+
+	// follow the GpuSkinning attributes, the matrix takes four locations.
+	enum InstanceAttribute : GLuint {
+		ATTRIBUTE_MODEL_VIEW = GpuSkinning::ATTRIBUTE_WEIGHTS + 1,
+		ATTRIBUTE_PALETTE_OFFSET = ATTRIBUTE_MODEL_VIEW + 4
+	};
+
+	enum StateType : uint32_t {
+		STATE_PROGRAM,
+		STATE_MESH,
+		STATE_TRANSFORM,
+		STATE_TEXTURE,
+		STATE_SAMPLER,
+		STATE_BLEND,
+		STATE_CULL,
+		STATE_DEPTH_WRITE,
+		STATE_POLYGON_MODE,
+		STATE_TYPE_COUNT
+	};
+
+	static const char* getStateTypeName(StateType type);
+
+	struct Stats {
+		uint32_t draws = 0;
+		uint32_t instances = 0;
+		// changes sent to GL, and changes skipped because the state was already set.
+		std::array<uint32_t, STATE_TYPE_COUNT> changes = {};
+		std::array<uint32_t, STATE_TYPE_COUNT> avoided = {};
+	};
+
+	ShaderPassRenderer();
+	ShaderPassRenderer(const ShaderPassRenderer&) = delete;
+
+	// the context must be current.
+	~ShaderPassRenderer();
+
+	// compile the default permutation, false when the context lacks support.
+	bool initialise();
+
+	// returns nothing when the pass is invisible.
+	// materials must have been calculated for the current frame, see M2Model::calculateMaterials.
+	static std::optional<Draw> prepare(const core::RenderOptions& renderOptions,
+		const core::ModelTextureInfo* textureInfo,
+		const core::MaterialAnimationState& materials,
+		const core::ModelRenderPass& pass);
+
+	// true when both draws can be made by one instanced draw of the same mesh.
+	static bool isSameState(const Draw& a, const Draw& b);
+
+	// start a batch of draws, with GpuSkinning::begin already called.
+	// the instances are uploaded for the draws of the batch to refer to.
+	// GL state is unknown at the start of a batch, by the end it is restored to what the fixed function renderer expects.
+	void begin(const std::vector<Instance>& instances, const core::Matrix& projection);
+
+	// draws the pass once for each of a range of the batch instances.
+	void render(const GpuSkinning::Mesh& mesh, bool wireframe, const Draw& draw, uint32_t first_instance, uint32_t instance_count);
+
+	void end();
+
+	const Stats& getStats() const {
+		return stats;
+	}
+
+	void resetStats() {
+		stats = Stats();
+	}
+
+protected:
+
+	struct Program {
+		GLuint id = 0;
+		GLint projection = -1;
+		GLint textureMatrix = -1;
+		GLint color = -1;
+		GLint textured = -1;
+		GLint emission = -1;
+		GLint sceneAmbient = -1;
+		GLint materialAlpha = -1;
+		// projection and lighting are uploaded once per batch.
+		uint32_t batch = 0;
+		bool failed = false;
+	};
+
+	// compiled on first use.
+	Program* useProgram(uint32_t permutation);
+
+	bool compile(uint32_t permutation, Program& program);
+
+	// point the instance attributes at the range starting at first_instance.
+	void bindInstances(uint32_t first_instance);
+
+	template<typename T, typename Apply>
+	void change(StateType type, std::optional<T>& current, const T& value, Apply apply) {
+		if (current != value) {
+			apply(value);
+			current = value;
+			stats.changes[type]++;
+		}
+		else {
+			stats.avoided[type]++;
+		}
+	}
+
+	// last state sent to GL, empty when unknown.
+	struct State {
+		std::optional<GLuint> program;
+		std::optional<const GpuSkinning::Mesh*> mesh;
+		std::optional<uint32_t> firstInstance;
+		std::optional<GLuint> texture;
+		std::optional<GLuint> sampler;
+		std::optional<bool> blend;
+		std::optional<std::pair<GLenum, GLenum>> blendFunc;
+		std::optional<bool> cull;
+		std::optional<bool> depthWrite;
+		std::optional<bool> wireframe;
+	};
+
+	State state;
+	Stats stats;
+
+	std::array<Program, PERMUTATION_COUNT> programs;
+
+	// column major, set by begin.
+	core::Matrix projection;
+
+	// the scene has no lights, so lit passes are only shaded by the ambient and material emission.
+	// values are those the fixed function renderer leaves set between passes: the GL default ambient and diffuse,
+	// and the white emission ModelRenderPassRenderer::finish restores.
+	struct Lighting {
+		// light model ambient times material ambient.
+		core::Vector3 sceneAmbient = core::Vector3(0.04f, 0.04f, 0.04f);
+		core::Vector3 emission = core::Vector3(1.0f, 1.0f, 1.0f);
+		// lit alpha is the material diffuse alpha.
+		float alpha = 1.0f;
+	} lighting;
+
+	uint32_t batch;
+
+	GLuint vertexArray;
+	GLuint instanceBuffer;
+
+	// wrapping is sampler state rather than texture state, so textures shared with other renderers are left as they are.
+	enum SamplerWrap : uint32_t {
+		SAMPLER_WRAP_S = 1 << 0,
+		SAMPLER_WRAP_T = 1 << 1,
+		SAMPLER_COUNT = 1 << 2
+	};
+
+	std::array<GLuint, SAMPLER_COUNT> samplers;
+
+	GLuint samplerOf(bool swrap, bool twrap) const {
+		return samplers[(swrap ? SAMPLER_WRAP_S : 0) | (twrap ? SAMPLER_WRAP_T : 0)];
+	}
+};
@@ -483,6 +483,23 @@ void WMVx::setupControls() {
 
     connect(ui.actionToggle_Grid, &QAction::triggered, [&]() {
         scene->showGrid = !scene->showGrid;
+        scene->requestRedraw();
+    });
+
+    connect(ui.actionToggle_Frame_Statistics, &QAction::toggled, ui.renderWidget, &RenderWidget::setStatisticsOverlay);
+
+    connect(ui.actionRecord_Frame_Statistics, &QAction::toggled, [&](bool checked) {
+        if (!checked) {
+            ui.renderWidget->stopRecordingStatistics();
+            return;
+        }
+
+        auto outFile = QFileDialog::getSaveFileName(this, "Record Frame Statistics", "", "CSV (*.csv)");
+
+        if (outFile.isNull() || !ui.renderWidget->recordStatistics(outFile)) {
+            QSignalBlocker blocker(ui.actionRecord_Frame_Statistics);
+            ui.actionRecord_Frame_Statistics->setChecked(false);
+        }
     });
 
     connect(ui.actionBGColor, &QAction::triggered, [&]() {
@@ -509,7 +526,7 @@ void WMVx::setupControls() {
     connect(ui.actionCamera_Reset, &QAction::triggered, ui.renderWidget, &RenderWidget::resetCamera);
 
     connect(ui.actionOpen_Dev_Tools, &QAction::triggered, [&]() {
-        auto tools = new DevTools(this);
+        auto tools = new DevTools(ui.renderWidget, this);
         tools->setAttribute(Qt::WA_DeleteOnClose);
         tools->onSceneLoaded(scene);
         tools->show();
@@ -35,6 +35,8 @@ void WMVxSettings::load()
 	load_key(config::rendering::target_fps, int32_t(30));
 	load_key(config::rendering::camera_type, "basic");
 	load_key(config::rendering::camera_hide_mouse, false);
+	load_key(config::rendering::animation_bake_rate, int32_t(30));
+	load_key(config::rendering::gpu_skinning, false);
 
 	loaded = true;
 }
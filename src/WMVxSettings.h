@@ -21,6 +21,8 @@ WMVX_CONFIG_KEY(exporter, last_scene_directory)
 WMVX_CONFIG_KEY(rendering, target_fps)
 WMVX_CONFIG_KEY(rendering, camera_type);
 WMVX_CONFIG_KEY(rendering, camera_hide_mouse);
+WMVX_CONFIG_KEY(rendering, animation_bake_rate);
+WMVX_CONFIG_KEY(rendering, gpu_skinning);
 
 #undef WMVX_CONFIG_KEY
 
@@ -46,9 +48,17 @@ public:
 
 	template<typename T>
 	void set(const char* key, T val) {
-		values[key] = val;
+		const QVariant value = val;
+		if (values[key] != value) {
+			values[key] = value;
+			emit changed(key);
+		}
 	}
 
+signals:
+	// emitted by set when a value is different, settings loaded from file arent signalled.
+	void changed(const QString& key);
+
 protected: 
 	std::map<QString, QVariant> values;
 	bool loaded;
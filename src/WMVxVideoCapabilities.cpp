@@ -62,6 +62,7 @@ bool WMVxVideoCapabilities::load(QOpenGLWidget* widget)
 	support.pixelFormat = wglewIsSupported("WGL_ARB_pixel_format") == GL_TRUE;
 	support.frameBufferObject = glewIsSupported("GL_EXT_framebuffer_object") == GL_TRUE;
 	support.textureRectangle = glewIsSupported("GL_ARB_texture_rectangle") == GL_TRUE;
+	support.textureBufferObject = glewIsSupported("GL_ARB_texture_buffer_object") == GL_TRUE;
 
 	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &support.maxTextureSize);
 
@@ -38,6 +38,7 @@ public:
 		bool pixelFormat;
 		bool frameBufferObject;
 		bool textureRectangle;
+		bool textureBufferObject;
 		GLint maxTextureSize;
 		GLint maxTextureSizeRectangle;
 	};
@@ -3,6 +3,7 @@
 #include "../utility/Quaternion.h"
 #include "M2Definitions.h"
 #include "../utility/Memory.h"
+#include "AnimationTrackStore.h"
 #include <memory>
 #include <map>
 #include <span>
@@ -31,12 +32,43 @@ namespace core {
 	};
 
 
+	// spline tracks store each key as a (value, in tangent, out tangent) triple.
+	constexpr size_t interpolationKeyStride(uint16_t interpolation_type) {
+		return (interpolation_type == INTERPOLATION_HERMITE || interpolation_type == INTERPOLATION_BEZIER) ? 3 : 1;
+	}
+
+	template<typename T>
+	struct AnimationSegment;
+
+	// AnimationSegment of packed Quat16 keys, pointing at the raw values within the track store.
+	struct PackedAnimationSegment {
+		Interpolation type = INTERPOLATION_NONE;
+		float ratio = 0.0f;
+		const int16_t* v1 = nullptr;
+		const int16_t* v2 = nullptr;
+		const int16_t* t1 = nullptr;
+		const int16_t* t2 = nullptr;
+		// applied after decoding.
+		Quaternion(*fix)(const Quaternion&) = nullptr;
+	};
+
 	template<typename T>
 	class IAnimatedValue {
 	public:
 		virtual Interpolation getType() const = 0;
 		virtual bool uses(size_t animation_index) const = 0;
 		virtual T getValue(size_t animation_index, const AnimationTickArgs& tick) const = 0;
+		// locate the keys either side of the tick without interpolating, returns false when there is no value.
+		virtual bool getSegment(size_t animation_index, const AnimationTickArgs& tick, AnimationSegment<T>& segment) const = 0;
+		// global sequence values are driven by absolute time, rather than the current animation frame.
+		virtual bool usesGlobalSequence() const = 0;
+		// packed values keep their keys as raw Quat16, which can be located without decoding.
+		virtual bool isPacked() const {
+			return false;
+		}
+		virtual bool getPackedSegment(size_t animation_index, const AnimationTickArgs& tick, PackedAnimationSegment& segment) const {
+			return false;
+		}
 	};
 
 	//legacy type for use with RangeBasedAnimation
@@ -75,8 +107,9 @@ namespace core {
 			}
 
 			if (definition.keys.size) {
-				anim_block.keys.resize(definition.keys.size);
-				memcpy_x(anim_block.keys, buffer, definition.keys.offset, sizeof(T) * (definition.keys.size));
+				const auto key_count = definition.keys.size * interpolationKeyStride(definition.interpolationType);
+				anim_block.keys.resize(key_count);
+				memcpy_x(anim_block.keys, buffer, definition.keys.offset, sizeof(T) * key_count);
 			}
 
 			return anim_block;
@@ -101,7 +134,7 @@ namespace core {
 
 			assert(definition.timestamps.size == definition.keys.size);
 
-			auto load_data = [&](const M2Array& def, auto& dest) {
+			auto load_data = [&](const M2Array& def, auto& dest, size_t stride) {
 				using dest_val_t = std::remove_reference_t<decltype(dest)>::value_type::value_type;
 
 				if (def.size) {
@@ -120,9 +153,9 @@ namespace core {
 							continue;
 						}
 
-						const auto read_size = sizeof(dest_val_t) * header.size;
+						const auto read_size = sizeof(dest_val_t) * header.size * stride;
 						std::vector<dest_val_t> temp;
-						temp.resize(header.size);
+						temp.resize(header.size * stride);
 
 						const auto animFile = animFiles.find(header_index);
 						if (animFile != animFiles.end()) {
@@ -165,8 +198,8 @@ namespace core {
 				assert(dest.size() == def.size);
 			};
 
-			load_data(definition.timestamps, anim_block.timestamps);
-			load_data(definition.keys, anim_block.keys);
+			load_data(definition.timestamps, anim_block.timestamps, 1);
+			load_data(definition.keys, anim_block.keys, interpolationKeyStride(definition.interpolationType));
 
 			return anim_block;
 		}
@@ -226,6 +259,40 @@ namespace core {
 			return interpolate<T>((life - mid) / (1.0f - mid), b, c);
 	}
 
+	// keys either side of a point in time, along with the tangents used by spline interpolation.
+	template<typename T>
+	struct AnimationSegment {
+		Interpolation type = INTERPOLATION_NONE;
+		float ratio = 0.0f;
+		T v1;
+		T v2;
+		// out tangent of v1 and in tangent of v2, only set for hermite / bezier.
+		T t1;
+		T t2;
+
+		T evaluate() const {
+			switch (type) {
+			case INTERPOLATION_LINEAR:
+				return interpolate<T>(ratio, v1, v2);
+			case INTERPOLATION_HERMITE:
+				return normalized(interpolateHermite<T>(ratio, v1, v2, t1, t2));
+			case INTERPOLATION_BEZIER:
+				// control points are v1, out tangent, in tangent, v2.
+				return normalized(interpolateBezier<T>(ratio, v1, t1, t2, v2));
+			default:
+				return v1;
+			}
+		}
+
+	private:
+		static T normalized(T value) {
+			if constexpr (std::is_same_v<T, Quaternion>) {
+				value.normalize();
+			}
+			return value;
+		}
+	};
+
 
 	//TODO messy code - tidy or replace - this has been copied directly from WMV - tidy
 
@@ -266,47 +333,72 @@ namespace core {
 	};
 
 
-#define	MAX_ANIMATED	500
-
+	// append converted keys to the store, returning the offset of the first key.
+	// packed quaternions are kept in their raw form, to be decoded during evaluation.
+	template<typename T, typename D, class Conv>
+	uint32_t appendTrackKeys(AnimationTrackStore& store, const std::vector<D>& keys, auto& fix_fn) {
+		if constexpr (std::is_same_v<D, PACK_QUATERNION>) {
+			auto& dest = store.packedRotations;
+			const auto offset = (uint32_t)(dest.size() / 4);
+			dest.reserve(dest.size() + (keys.size() * 4));
+			for (const auto& key : keys) {
+				dest.push_back(key.x);
+				dest.push_back(key.y);
+				dest.push_back(key.z);
+				dest.push_back(key.w);
+			}
+			return offset;
+		}
+		else {
+			auto& dest = store.values<T>();
+			const auto offset = (uint32_t)dest.size();
+			dest.reserve(dest.size() + keys.size());
+			for (const auto& key : keys) {
+				dest.push_back(fix_fn(Conv::conv(key)));
+			}
+			return offset;
+		}
+	}
 
+	// shared access to keys held within an AnimationTrackStore.
 	template<typename T>
-	class TimelineBasedAnimatedValue : public IAnimatedValue<T> {
+	class StoredAnimatedValue : public IAnimatedValue<T> {
 	public:
-		TimelineBasedAnimatedValue() = default;
-		TimelineBasedAnimatedValue(TimelineBasedAnimatedValue&&) = default;
-		TimelineBasedAnimatedValue& operator=(TimelineBasedAnimatedValue&& other) = default;
-		virtual ~TimelineBasedAnimatedValue() {}
+		using fix_fn_t = T(*)(const T&);
+
+		StoredAnimatedValue() = default;
+		StoredAnimatedValue(StoredAnimatedValue&&) = default;
+		StoredAnimatedValue& operator=(StoredAnimatedValue&& other) = default;
+		virtual ~StoredAnimatedValue() {}
 
 		Interpolation getType() const override {
-			return (Interpolation)interpolationType;
+			return store ? (Interpolation)getTrack().interpolationType : INTERPOLATION_NONE;
 		}
 
-		bool uses(size_t animation_index) const override {
+		bool usesGlobalSequence() const override {
+			return store && getTrack().globalSequence > -1;
+		}
 
-			if (globalSequence > -1) {
-				animation_index = 0;
-			}
+		bool isPacked() const override {
+			return store && getTrack().packed;
+		}
 
-			auto found = data.find(animation_index);
-			if (found != data.end()) {
-				//ideally map entries are not created with zero entries, however its not guarenteed
-				return found->second.size() > 0;
-			}
+	protected:
 
-			return false;
+		const AnimationTrackStore::Track& getTrack() const {
+			return store->getTrack(track);
 		}
 
-		T getValue(size_t animation_index, const AnimationTickArgs& tick) const override {
-		
-			auto time = tick.currentFrame;
+		// resolve global sequence time, returns false when the sequence has no length.
+		bool resolveGlobal(const AnimationTrackStore::Track& definition, const AnimationTickArgs& tick, size_t& animation_index, uint32_t& time) const {
+			const auto& globals = store->globalSequences;
 
-			// obtain a time value and a data range
-			if (globalSequence > -1 && globalSequence < globals->size()) {
+			if (definition.globalSequence > -1 && definition.globalSequence < globals.size()) {
 
-				const auto& global_match = globals->at(globalSequence);
+				const auto& global_match = globals[definition.globalSequence];
 
 				if (!global_match) {
-					return T();
+					return false;
 				}
 
 				if (global_match == 0) {
@@ -319,218 +411,393 @@ namespace core {
 				animation_index = 0;
 			}
 
-			const auto data_match = data.find(animation_index);
-			const auto times_match = times.find(animation_index);
-
-			if (data_match != data.end() && times_match != times.end() &&
-				data_match->second.size() > 1 && times_match->second.size() > 1) {
-
-				auto compute = [&](size_t pos, size_t pos2, float r) {
-					switch (interpolationType) {
-					case INTERPOLATION_NONE:
-						return data_match->second[pos];
-					case INTERPOLATION_LINEAR:
-						return interpolate<T>(r, data_match->second[pos], data_match->second[pos2]);
-					case INTERPOLATION_HERMITE:
-						// INTERPOLATION_HERMITE is only used in cameras afaik?
-						return interpolateHermite<T>(r, data.at(animation_index)[pos], data.at(animation_index)[pos2], in.at(animation_index)[pos], out.at(animation_index)[pos]);
-					case INTERPOLATION_BEZIER:
-						//Is this used ingame or only by custom models?
-						return interpolateBezier<T>(r, data.at(animation_index)[pos], data.at(animation_index)[pos2], in.at(animation_index)[pos], out.at(animation_index)[pos]);
-					default:
-						//this shouldn't appear!
-						return data_match->second[pos];
-						
-					}
-				};
-
-				float r = 1.0f;
-				size_t pos = 0;
-				const size_t max_time = times_match->second.back();
+			return true;
+		}
 
-				//if (max_time > 0)
-				//	time %= max_time; // I think this might not be necessary?
-				if (time > max_time) {
-					pos = times_match->second.size() - 1;
+		// component 0 is the value, 1 and 2 are the in / out tangents of spline keys.
+		T key(const AnimationTrackStore::Track& definition, uint32_t value_offset, size_t pos, size_t component) const {
+			const auto index = value_offset + (pos * interpolationKeyStride(definition.interpolationType)) + component;
 
-					return compute(pos, pos, r);
+			if constexpr (std::is_same_v<T, Quaternion>) {
+				if (definition.packed) {
+					const int16_t* raw = &store->packedRotations[index * 4];
+					const Quaternion q = Quat16ToQuat32::conv(PACK_QUATERNION{ raw[0], raw[1], raw[2], raw[3] });
+					return fix != nullptr ? fix(q) : q;
 				}
-				else {
-					for (size_t i = 0; i < times_match->second.size() - 1; i++) {
-						if (time >= times_match->second[i] && time < times_match->second[i + 1]) {
-							pos = i;
-							break;
-						}
-					}
-					size_t t1 = times_match->second[pos];
-					size_t t2 = times_match->second[pos + 1];
-					r = (time - t1) / (float)(t2 - t1);
+			}
 
-					return compute(pos, pos + 1, r);
-				}
+			return store->values<T>()[index];
+		}
 
+		const int16_t* packedKey(const AnimationTrackStore::Track& definition, uint32_t value_offset, size_t pos, size_t component) const {
+			const auto index = value_offset + (pos * interpolationKeyStride(definition.interpolationType)) + component;
+			return &store->packedRotations[index * 4];
+		}
+
+		static Interpolation segmentType(const AnimationTrackStore::Track& definition) {
+			return definition.interpolationType <= INTERPOLATION_BEZIER ? (Interpolation)definition.interpolationType : INTERPOLATION_NONE;
+		}
+
+		static bool isSpline(Interpolation type) {
+			return type == INTERPOLATION_HERMITE || type == INTERPOLATION_BEZIER;
+		}
+
+		void setSegment(AnimationSegment<T>& segment, const AnimationTrackStore::Track& definition, uint32_t value_offset, size_t pos, size_t pos2, Interpolation type, float r) const {
+			segment.type = type;
+			segment.ratio = r;
+			segment.v1 = key(definition, value_offset, pos, 0);
+			segment.v2 = pos2 == pos ? segment.v1 : key(definition, value_offset, pos2, 0);
+
+			if (isSpline(type)) {
+				segment.t1 = key(definition, value_offset, pos, 2);
+				segment.t2 = key(definition, value_offset, pos2, 1);
 			}
-			else if(data_match != data.end() && data_match->second.size() > 0) {
-				return data.at(animation_index)[0];
+		}
+
+		void setPackedSegment(PackedAnimationSegment& segment, const AnimationTrackStore::Track& definition, uint32_t value_offset, size_t pos, size_t pos2, Interpolation type, float r) const {
+			segment.type = type;
+			segment.ratio = r;
+			segment.v1 = packedKey(definition, value_offset, pos, 0);
+			segment.v2 = packedKey(definition, value_offset, pos2, 0);
+			segment.t1 = isSpline(type) ? packedKey(definition, value_offset, pos, 2) : nullptr;
+			segment.t2 = isSpline(type) ? packedKey(definition, value_offset, pos2, 1) : nullptr;
+
+			if constexpr (std::is_same_v<T, Quaternion>) {
+				segment.fix = fix;
 			}
+		}
 
-			return T();
+		template<typename D>
+		static AnimationTrackStore::Track makeTrack(int32_t interpolation_type, int32_t global_sequence) {
+			AnimationTrackStore::Track definition;
+			definition.interpolationType = interpolation_type;
+			definition.globalSequence = global_sequence;
+			definition.packed = std::is_same_v<D, PACK_QUATERNION>;
+			return definition;
 		}
 
-		template<typename D = T, class Conv = Identity<T>>
-		static TimelineBasedAnimatedValue<T> make(TimelineBasedAnimationBlock<D>&& block, std::shared_ptr<std::vector<uint32_t>> globalSequences, auto fix_fn) {
-			TimelineBasedAnimatedValue<T> result;
-			result.globals = globalSequences;
-			result.interpolationType = block.interpolationType;
-			result.globalSequence = block.globalSequence;
+		std::shared_ptr<AnimationTrackStore> store;
+		uint32_t track = 0;
+		// applied to packed keys as they are decoded.
+		fix_fn_t fix = nullptr;
+	};
 
-			if (result.globalSequence != -1) {
-				if (!globalSequences->size()) {
-					return result;
-				}
+#define	MAX_ANIMATED	500
+
+
+	template<typename T>
+	class TimelineBasedAnimatedValue : public StoredAnimatedValue<T> {
+	public:
+		TimelineBasedAnimatedValue() = default;
+		TimelineBasedAnimatedValue(TimelineBasedAnimatedValue&&) = default;
+		TimelineBasedAnimatedValue& operator=(TimelineBasedAnimatedValue&& other) = default;
+		virtual ~TimelineBasedAnimatedValue() {}
+
+		bool uses(size_t animation_index) const override {
+			if (!this->store) {
+				return false;
 			}
 
-			assert(block.timestamps.size() == block.keys.size());
+			const auto& definition = this->getTrack();
 
-			// times
-			if (block.timestamps.size() != block.keys.size()) {
-				return result;
+			if (definition.globalSequence > -1) {
+				animation_index = 0;
 			}
-			else if (block.timestamps.size() == 0) {
-				return result;
+
+			if (animation_index < definition.sequenceCount) {
+				//ideally sequences are not created with zero entries, however its not guarenteed
+				return this->store->sequences[definition.firstSequence + animation_index].count > 0;
 			}
 
-			for (size_t j = 0; j < block.timestamps.size(); j++) {
-				result.times.emplace(j, std::move(block.timestamps[j]));
+			return false;
+		}
+
+		T getValue(size_t animation_index, const AnimationTickArgs& tick) const override {
+			AnimationSegment<T> segment;
+			if (getSegment(animation_index, tick, segment)) {
+				return segment.evaluate();
 			}
 
-			////keys
-			for (size_t j = 0; j < block.keys.size(); j++) {
+			return T();
+		}
 
-				switch (result.interpolationType) {
-					case INTERPOLATION_NONE:
-					case INTERPOLATION_LINEAR:
-					{
-						auto transform = [&fix_fn](auto& val) {
-							return fix_fn(Conv::conv(val));
-						};
+		bool getSegment(size_t animation_index, const AnimationTickArgs& tick, AnimationSegment<T>& segment) const override {
+			Location location;
+			if (!locate(animation_index, tick, location)) {
+				return false;
+			}
 
-						if constexpr (std::is_same_v<T, D>) {
-							std::transform(block.keys[j].begin(), block.keys[j].end(), block.keys[j].begin(), transform);
-							result.data.emplace(j, std::move(block.keys[j]));
-						}
-						else {
-							std::vector<T> temp;
-							temp.reserve(block.keys[j].size());
-							std::transform(block.keys[j].begin(), block.keys[j].end(), std::back_inserter(temp), transform);
-							result.data.emplace(j, std::move(temp));
-						}
+			this->setSegment(segment, this->getTrack(), location.valueOffset, location.pos, location.pos2, location.type, location.ratio);
+			return true;
+		}
 
-					}
-					break;
-					case INTERPOLATION_HERMITE:
-					case INTERPOLATION_BEZIER:
-					{
-						//TODO implement
-						assert(false);
-						throw 1;
-						//for (size_t i = 0; i < pHeadKeys->nEntrys; i++) {
-						//	data[j].push_back(Conv::conv(keys[i * 3]));
-						//	in[j].push_back(Conv::conv(keys[i * 3 + 1]));
-						//	out[j].push_back(Conv::conv(keys[i * 3 + 2]));
-						//}
-					}
-					break;
-				}
+		bool getPackedSegment(size_t animation_index, const AnimationTickArgs& tick, PackedAnimationSegment& segment) const override {
+			Location location;
+			if (!this->isPacked() || !locate(animation_index, tick, location)) {
+				return false;
 			}
-		
 
-			if (result.times.size() > 0) {
-				assert(result.times.rbegin()->first <= (MAX_ANIMATED - 1));
+			this->setPackedSegment(segment, this->getTrack(), location.valueOffset, location.pos, location.pos2, location.type, location.ratio);
+			return true;
+		}
+
+		template<typename D = T, class Conv = Identity<T>>
+		static TimelineBasedAnimatedValue<T> make(TimelineBasedAnimationBlock<D>&& block, std::shared_ptr<AnimationTrackStore> store, auto fix_fn) {
+			TimelineBasedAnimatedValue<T> result;
+			result.store = store;
+
+			if constexpr (std::is_same_v<D, PACK_QUATERNION>) {
+				result.fix = fix_fn;
 			}
-			if (result.data.size() > 0) {
-				assert(result.data.rbegin()->first <= (MAX_ANIMATED - 1));
+
+			auto definition = StoredAnimatedValue<T>::template makeTrack<D>(block.interpolationType, block.globalSequence);
+
+			const bool has_globals = definition.globalSequence == -1 || store->globalSequences.size() > 0;
+
+			if (has_globals) {
+				assert(block.timestamps.size() == block.keys.size());
 			}
 
+			// times
+			if (has_globals && block.timestamps.size() == block.keys.size() && definition.interpolationType <= INTERPOLATION_BEZIER) {
+				const auto stride = interpolationKeyStride(definition.interpolationType);
+
+				definition.firstSequence = (uint32_t)store->sequences.size();
+				definition.sequenceCount = (uint32_t)block.timestamps.size();
+
+				assert(definition.sequenceCount <= MAX_ANIMATED);
+
+				for (size_t j = 0; j < block.timestamps.size(); j++) {
+					AnimationTrackStore::Sequence sequence;
+					sequence.timeOffset = (uint32_t)store->times.size();
+					sequence.count = (uint32_t)std::min(block.timestamps[j].size(), block.keys[j].size() / stride);
+					sequence.valueOffset = appendTrackKeys<T, D, Conv>(*store, block.keys[j], fix_fn);
+
+					store->times.insert(store->times.end(), block.timestamps[j].begin(), block.timestamps[j].end());
+					store->sequences.push_back(sequence);
+				}
+			}
+
+			result.track = store->addTrack(definition);
+
 			return result;
 		}
 
 	protected:
-		int32_t interpolationType;
-		int32_t globalSequence;
-		std::shared_ptr<std::vector<uint32_t>> globals;
 
-		std::map<size_t, std::vector<uint32_t>> times;
-		std::map<size_t, std::vector<T>> data;
+		struct Location {
+			uint32_t valueOffset = 0;
+			size_t pos = 0;
+			size_t pos2 = 0;
+			Interpolation type = INTERPOLATION_NONE;
+			float ratio = 0.0f;
+		};
+
+		bool locate(size_t animation_index, const AnimationTickArgs& tick, Location& location) const {
+			if (!this->store) {
+				return false;
+			}
+
+			const auto& definition = this->getTrack();
+		
+			uint32_t time = tick.currentFrame;
+
+			// obtain a time value and a data range
+			if (!this->resolveGlobal(definition, tick, animation_index, time)) {
+				return false;
+			}
+
+			if (animation_index >= definition.sequenceCount) {
+				return false;
+			}
+
+			const auto& sequence = this->store->sequences[definition.firstSequence + animation_index];
+			location.valueOffset = sequence.valueOffset;
+
+			if (sequence.count > 1) {
+				const uint32_t* timestamps = &this->store->times[sequence.timeOffset];
+				const size_t max_time = timestamps[sequence.count - 1];
 
-		// for nonlinear interpolations:
-		std::map<size_t, std::vector<T>> in;
-		std::map<size_t, std::vector<T>> out;
+				//if (max_time > 0)
+				//	time %= max_time; // I think this might not be necessary?
+				if (time > max_time) {
+					location.pos = sequence.count - 1;
+					location.pos2 = location.pos;
+					location.type = this->segmentType(definition);
+					location.ratio = 1.0f;
+				}
+				else {
+					size_t pos = 0;
+					for (size_t i = 0; i < sequence.count - 1; i++) {
+						if (time >= timestamps[i] && time < timestamps[i + 1]) {
+							pos = i;
+							break;
+						}
+					}
+					size_t t1 = timestamps[pos];
+					size_t t2 = timestamps[pos + 1];
+
+					location.pos = pos;
+					location.pos2 = pos + 1;
+					location.type = this->segmentType(definition);
+					location.ratio = (time - t1) / (float)(t2 - t1);
+				}
+
+				return true;
+			}
+			else if (sequence.count > 0) {
+				location.pos = 0;
+				location.pos2 = 0;
+				location.type = INTERPOLATION_NONE;
+				location.ratio = 0.0f;
+				return true;
+			}
+
+			return false;
+		}
 	};
 
 	template<typename T>
-	class RangeBasedAnimatedValue : public IAnimatedValue<T> {
+	class RangeBasedAnimatedValue : public StoredAnimatedValue<T> {
 	public:
 		RangeBasedAnimatedValue() = default;
 		RangeBasedAnimatedValue(RangeBasedAnimatedValue&&) = default;
 		RangeBasedAnimatedValue& operator=(RangeBasedAnimatedValue&& other) = default;
 		virtual ~RangeBasedAnimatedValue() {}
 
-		Interpolation getType() const override {
-			return (Interpolation)interpolationType;
-		}
-
 		bool uses(size_t animation_index) const override {
+			if (!this->store) {
+				return false;
+			}
+
+			const auto& definition = this->getTrack();
 
-			if (globalSequence > -1) {
+			if (definition.globalSequence > -1) {
 				animation_index = 0;
 			}
 
-			return ranges.size() > animation_index;
+			return definition.rangeCount > animation_index;
 		}
 
 		T getValue(size_t animation_index, const AnimationTickArgs& tick) const override {
-			auto time = tick.currentFrame;
-			// obtain a time value and a data range
-			if (globalSequence > -1 && globalSequence < globals->size()) {
+			AnimationSegment<T> segment;
+			if (getSegment(animation_index, tick, segment)) {
+				return segment.evaluate();
+			}
 
-				const auto& global_match = globals->at(globalSequence);
+			return T();
+		}
 
-				if (!global_match) {
-					return T();
-				}
+		bool getSegment(size_t animation_index, const AnimationTickArgs& tick, AnimationSegment<T>& segment) const override {
+			Location location;
+			if (!locate(animation_index, tick, location)) {
+				return false;
+			}
 
-				if (global_match == 0) {
-					time = 0;
-				}
-				else {
-					time = tick.absoluteTime % global_match;
+			this->setSegment(segment, this->getTrack(), location.valueOffset, location.pos, location.pos2, location.type, location.ratio);
+			return true;
+		}
+
+		bool getPackedSegment(size_t animation_index, const AnimationTickArgs& tick, PackedAnimationSegment& segment) const override {
+			Location location;
+			if (!this->isPacked() || !locate(animation_index, tick, location)) {
+				return false;
+			}
+
+			this->setPackedSegment(segment, this->getTrack(), location.valueOffset, location.pos, location.pos2, location.type, location.ratio);
+			return true;
+		}
+
+		template<typename D = T, class Conv = Identity<T>>
+		static RangeBasedAnimatedValue<T> make(RangeBasedAnimationBlock<D>&& block, std::shared_ptr<AnimationTrackStore> store, auto fix_fn) {
+			RangeBasedAnimatedValue<T> result;
+			result.store = store;
+
+			if constexpr (std::is_same_v<D, PACK_QUATERNION>) {
+				result.fix = fix_fn;
+			}
+
+			auto definition = StoredAnimatedValue<T>::template makeTrack<D>(block.interpolationType, block.globalSequence);
+
+			const bool has_globals = definition.globalSequence == -1 || store->globalSequences.size() > 0;
+			const auto stride = interpolationKeyStride(definition.interpolationType);
+
+			if (has_globals) {
+				assert(block.timestamps.size() * stride == block.keys.size());
+			}
+
+			// times
+			if (has_globals && block.timestamps.size() > 0 && block.timestamps.size() * stride == block.keys.size() && definition.interpolationType <= INTERPOLATION_BEZIER) {
+				AnimationTrackStore::Sequence sequence;
+				sequence.timeOffset = (uint32_t)store->times.size();
+				sequence.count = (uint32_t)block.timestamps.size();
+				sequence.valueOffset = appendTrackKeys<T, D, Conv>(*store, block.keys, fix_fn);
+
+				store->times.insert(store->times.end(), block.timestamps.begin(), block.timestamps.end());
+
+				definition.firstSequence = (uint32_t)store->sequences.size();
+				definition.sequenceCount = 1;
+				store->sequences.push_back(sequence);
+
+				definition.firstRange = (uint32_t)store->ranges.size();
+				definition.rangeCount = (uint32_t)block.ranges.size();
+				for (const auto& range : block.ranges) {
+					store->ranges.push_back({ range.start, range.end });
 				}
+			}
 
-				animation_index = 0;
+			result.track = store->addTrack(definition);
+
+			return result;
+		}
+
+	protected:
+
+		struct Location {
+			uint32_t valueOffset = 0;
+			size_t pos = 0;
+			size_t pos2 = 0;
+			Interpolation type = INTERPOLATION_NONE;
+			float ratio = 0.0f;
+		};
+
+		bool locate(size_t animation_index, const AnimationTickArgs& tick, Location& location) const {
+			if (!this->store) {
+				return false;
 			}
 
-			if (ranges.size() > animation_index) {
+			const auto& definition = this->getTrack();
+
+			uint32_t time = tick.currentFrame;
+			// obtain a time value and a data range
+			if (!this->resolveGlobal(definition, tick, animation_index, time)) {
+				return false;
+			}
 
-				const auto& range = ranges.at(animation_index);
-				float r = 1.0f;
+			if (definition.rangeCount > animation_index && definition.sequenceCount > 0) {
+
+				const auto& sequence = this->store->sequences[definition.firstSequence];
+				const auto& range = this->store->ranges[definition.firstRange + animation_index];
+				const uint32_t* timestamps = &this->store->times[sequence.timeOffset];
 				const size_t max_time = timestamps[range.end];
 				const size_t start_time = timestamps[range.start];
-				size_t pos = 0;
+
+				location.valueOffset = sequence.valueOffset;
 
 				time = start_time + time;
 
 			//	// if (max_time > 0)
 			//	//	time %= max_time; // I think this might not be necessary?
-				if (time > max_time) {
-					pos = timestamps.size() - 1;
-					//TODO handle types
-
-					return data[pos]; //interpolate<T>(r, data[pos], data[pos]);
+				if (time > max_time || sequence.count < 2) {
+					location.pos = time > max_time ? sequence.count - 1 : 0;
+					location.pos2 = location.pos;
+					location.type = INTERPOLATION_NONE;
+					location.ratio = 0.0f;
 				}
 				else {
+					size_t pos = 0;
 					//TODO can this be limited t range.start and range.end?
-					for (size_t i = 0; i < timestamps.size() - 1; i++) {
+					for (size_t i = 0; i < sequence.count - 1; i++) {
 						if (time >= timestamps[i] && time < timestamps[i + 1]) {
 							pos = i;
 							break;
@@ -539,98 +806,18 @@ namespace core {
 
 					size_t t1 = timestamps[pos];
 					size_t t2 = timestamps[pos + 1];
-					r = (time - t1) / (float)(t2 - t1);
-
-					switch (interpolationType) {
-					case INTERPOLATION_NONE:
-						return data[pos];
-						break;
-					case INTERPOLATION_LINEAR:
-						return interpolate<T>(r, data[pos], data[pos + 1]);
-						break;
-					case INTERPOLATION_HERMITE:
-					case INTERPOLATION_BEZIER:
-						//TODO implement
-						assert(false);
-						throw 1;
-						break;
-					}
-				}
-			}
-
-			return T(); 
-		}
-
-		template<typename D = T, class Conv = Identity<T>>
-		static RangeBasedAnimatedValue<T> make(RangeBasedAnimationBlock<D>&& block, std::shared_ptr<std::vector<uint32_t>> globalSequences, auto fix_fn) {
-			RangeBasedAnimatedValue<T> result;
-			result.globals = globalSequences;
-			result.interpolationType = block.interpolationType;
-			result.globalSequence = block.globalSequence;
 
-			if (result.globalSequence != -1) {
-				if (!globalSequences->size()) {
-					return result;
+					location.pos = pos;
+					location.pos2 = pos + 1;
+					location.type = this->segmentType(definition);
+					location.ratio = (time - t1) / (float)(t2 - t1);
 				}
-			}
-
-			assert(block.timestamps.size() == block.keys.size());
 
-			// times
-			if (block.timestamps.size() != block.keys.size()) {
-				return result;
-			}
-			else if (block.timestamps.size() == 0) {
-				return result;
+				return true;
 			}
 
-			result.ranges = std::move(block.ranges);
-			result.timestamps = std::move(block.timestamps);
-
-			switch(result.interpolationType) {
-				case INTERPOLATION_NONE:
-				case INTERPOLATION_LINEAR:
-				{
-					auto transform = [&fix_fn](auto& val) {
-						return fix_fn(Conv::conv(val));
-					};
-
-					if constexpr (std::is_same_v<T, D>) {
-						std::transform(block.keys.begin(), block.keys.end(), block.keys.begin(), transform);
-						result.data = std::move(block.keys);
-					}
-					else {
-						result.data.reserve(block.keys.size());
-						std::transform(block.keys.begin(), block.keys.end(), std::back_inserter(result.data), transform);
-					}
-				}
-				break;
-				case INTERPOLATION_HERMITE:
-				case INTERPOLATION_BEZIER:
-				{
-					//TODO implement
-					assert(false);
-					throw 1;
-					//for (size_t i = 0; i < pHeadKeys->nEntrys; i++) {
-					//	data[j].push_back(Conv::conv(keys[i * 3]));
-					//	in[j].push_back(Conv::conv(keys[i * 3 + 1]));
-					//	out[j].push_back(Conv::conv(keys[i * 3 + 2]));
-					//}
-				}
-				break;
-			}
-
-			return result;
+			return false; 
 		}
-
-	protected:
-		int32_t interpolationType;
-		int32_t globalSequence;
-		std::shared_ptr<std::vector<uint32_t>> globals;
-
-		std::vector<AnimationRange> ranges;
-		std::vector<uint32_t> timestamps;
-		std::vector<T> data;
 	};
 
 	template<class T, M2_VER_RANGE R>
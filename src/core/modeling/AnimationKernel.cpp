@@ -0,0 +1,276 @@
+#include "../../stdafx.h"
+#include "AnimationKernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WMVX_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace core {
+
+	namespace {
+		constexpr size_t LANE_WIDTH = 4;
+		constexpr float QUAT16_SCALE = 1.0f / 32767.0f;
+	}
+
+	void InterpolationKernel::Batch::reset(size_t component_count, size_t lane_count, bool packed_keys)
+	{
+		components = component_count;
+		count = lane_count;
+		stride = ((lane_count + LANE_WIDTH - 1) / LANE_WIDTH) * LANE_WIDTH;
+		packed = packed_keys;
+
+		const auto size = components * stride;
+
+		types.assign(stride, (uint8_t)INTERPOLATION_NONE);
+		ratios.assign(stride, 0.0f);
+		weights.resize(stride * 4);
+
+		// padding lanes must hold valid numbers, they are blended along with the rest.
+		v1.assign(size, 0.0f);
+		v2.assign(size, 0.0f);
+		t1.assign(size, 0.0f);
+		t2.assign(size, 0.0f);
+		result.resize(size);
+
+		if (packed) {
+			// 32767 decodes to zero.
+			packedV1.assign(size, 32767);
+			packedV2.assign(size, 32767);
+			packedT1.assign(size, 32767);
+			packedT2.assign(size, 32767);
+		}
+	}
+
+	void InterpolationKernel::Batch::set(size_t lane, const AnimationSegment<Vector3>& segment)
+	{
+		assert(components == 3 && !packed);
+
+		types[lane] = (uint8_t)segment.type;
+		ratios[lane] = segment.ratio;
+
+		store(v1, lane, segment.v1.x, segment.v1.y, segment.v1.z);
+		store(v2, lane, segment.v2.x, segment.v2.y, segment.v2.z);
+		store(t1, lane, segment.t1.x, segment.t1.y, segment.t1.z);
+		store(t2, lane, segment.t2.x, segment.t2.y, segment.t2.z);
+	}
+
+	void InterpolationKernel::Batch::set(size_t lane, const AnimationSegment<Quaternion>& segment)
+	{
+		assert(components == 4 && !packed);
+
+		types[lane] = (uint8_t)segment.type;
+		ratios[lane] = segment.ratio;
+
+		store(v1, lane, segment.v1.x, segment.v1.y, segment.v1.z, segment.v1.w);
+		store(v2, lane, segment.v2.x, segment.v2.y, segment.v2.z, segment.v2.w);
+		store(t1, lane, segment.t1.x, segment.t1.y, segment.t1.z, segment.t1.w);
+		store(t2, lane, segment.t2.x, segment.t2.y, segment.t2.z, segment.t2.w);
+	}
+
+	void InterpolationKernel::Batch::setPacked(size_t lane, Interpolation type, float ratio, const int16_t* a, const int16_t* b, const int16_t* in, const int16_t* out)
+	{
+		assert(packed);
+
+		types[lane] = (uint8_t)type;
+		ratios[lane] = ratio;
+
+		for (size_t c = 0; c < components; c++) {
+			const auto index = (c * stride) + lane;
+			packedV1[index] = a[c];
+			packedV2[index] = b[c];
+			if (in != nullptr && out != nullptr) {
+				packedT1[index] = in[c];
+				packedT2[index] = out[c];
+			}
+		}
+	}
+
+	void InterpolationKernel::evaluate(Batch& batch, bool rotations)
+	{
+		if (batch.count == 0) {
+			return;
+		}
+
+		if (batch.packed) {
+			decode(batch);
+		}
+
+		computeWeights(batch, rotations);
+		blend(batch);
+
+		if (rotations) {
+			normalizeRotations(batch);
+		}
+	}
+
+	void InterpolationKernel::decode(Batch& batch)
+	{
+		// matches Quat16ToQuat32, (x < 0 ? x + 32768 : x - 32767) / 32767
+		auto decode_values = [](const std::vector<int16_t>& src, std::vector<float>& dest) {
+			const auto size = src.size();
+			size_t i = 0;
+
+#ifdef WMVX_KERNEL_SSE2
+			const __m128i bias = _mm_set1_epi32(32767);
+			const __m128i wrap = _mm_set1_epi32(65535);
+			const __m128i zero = _mm_setzero_si128();
+			const __m128 scale = _mm_set1_ps(QUAT16_SCALE);
+
+			for (; i + 8 <= size; i += 8) {
+				const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
+				// sign extend to 32 bits.
+				const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+				const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+
+				const __m128i lo_value = _mm_add_epi32(_mm_sub_epi32(lo, bias), _mm_and_si128(_mm_cmplt_epi32(lo, zero), wrap));
+				const __m128i hi_value = _mm_add_epi32(_mm_sub_epi32(hi, bias), _mm_and_si128(_mm_cmplt_epi32(hi, zero), wrap));
+
+				_mm_storeu_ps(&dest[i], _mm_mul_ps(_mm_cvtepi32_ps(lo_value), scale));
+				_mm_storeu_ps(&dest[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi_value), scale));
+			}
+#endif
+
+			for (; i < size; i++) {
+				const int32_t value = src[i];
+				dest[i] = float(value < 0 ? value + 32768 : value - 32767) * QUAT16_SCALE;
+			}
+		};
+
+		decode_values(batch.packedV1, batch.v1);
+		decode_values(batch.packedV2, batch.v2);
+		decode_values(batch.packedT1, batch.t1);
+		decode_values(batch.packedT2, batch.t2);
+	}
+
+	void InterpolationKernel::computeWeights(Batch& batch, bool rotations)
+	{
+		const auto stride = batch.stride;
+		float* w1 = &batch.weights[0];
+		float* w2 = &batch.weights[stride];
+		float* w3 = &batch.weights[stride * 2];
+		float* w4 = &batch.weights[stride * 3];
+
+		for (size_t i = 0; i < stride; i++) {
+			const float r = batch.ratios[i];
+
+			w1[i] = 1.0f;
+			w2[i] = 0.0f;
+			w3[i] = 0.0f;
+			w4[i] = 0.0f;
+
+			switch ((Interpolation)batch.types[i]) {
+			case INTERPOLATION_LINEAR:
+			{
+				w1[i] = 1.0f - r;
+				w2[i] = r;
+
+				if (rotations) {
+					// Quaternion::slerp expressed as weights on v1 and v2.
+					float dot = 0.0f;
+					float v1_len2 = 0.0f;
+					float v2_len2 = 0.0f;
+					for (size_t c = 0; c < batch.components; c++) {
+						const float a = batch.v1[(c * stride) + i];
+						const float b = batch.v2[(c * stride) + i];
+						dot += a * b;
+						v1_len2 += a * a;
+						v2_len2 += b * b;
+					}
+
+					if (fabs(dot) <= 0.9995f) {
+						// slerp = v1 * cos(a) + normalize(v2 - v1 * dot) * sin(a)
+						const float angle = acosf(dot) * r;
+						const float len = sqrtf(std::max(v2_len2 - (2.0f * dot * dot) + (dot * dot * v1_len2), 0.0f));
+						const float k = len > 0.0f ? sinf(angle) / len : 0.0f;
+
+						w1[i] = cosf(angle) - (k * dot);
+						w2[i] = k;
+					}
+				}
+			}
+			break;
+			case INTERPOLATION_HERMITE:
+			{
+				const float r2 = r * r;
+				const float r3 = r2 * r;
+				w1[i] = (2.0f * r3) - (3.0f * r2) + 1.0f;
+				w2[i] = (-2.0f * r3) + (3.0f * r2);
+				w3[i] = r3 - (2.0f * r2) + r;
+				w4[i] = r3 - r2;
+			}
+			break;
+			case INTERPOLATION_BEZIER:
+			{
+				const float inverse = 1.0f - r;
+				// control points are v1, out tangent (t1), in tangent (t2), v2.
+				w1[i] = inverse * inverse * inverse;
+				w2[i] = r * r * r;
+				w3[i] = 3.0f * r * inverse * inverse;
+				w4[i] = 3.0f * r * r * inverse;
+			}
+			break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void InterpolationKernel::blend(Batch& batch)
+	{
+		const auto stride = batch.stride;
+		const float* w1 = &batch.weights[0];
+		const float* w2 = &batch.weights[stride];
+		const float* w3 = &batch.weights[stride * 2];
+		const float* w4 = &batch.weights[stride * 3];
+
+		for (size_t c = 0; c < batch.components; c++) {
+			const float* a = &batch.v1[c * stride];
+			const float* b = &batch.v2[c * stride];
+			const float* in = &batch.t1[c * stride];
+			const float* out = &batch.t2[c * stride];
+			float* dest = &batch.result[c * stride];
+
+#ifdef WMVX_KERNEL_SSE2
+			for (size_t i = 0; i < stride; i += LANE_WIDTH) {
+				__m128 value = _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(w1 + i));
+				value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(b + i), _mm_loadu_ps(w2 + i)));
+				value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(w3 + i)));
+				value = _mm_add_ps(value, _mm_mul_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(w4 + i)));
+				_mm_storeu_ps(dest + i, value);
+			}
+#else
+			for (size_t i = 0; i < stride; i++) {
+				dest[i] = (a[i] * w1[i]) + (b[i] * w2[i]) + (in[i] * w3[i]) + (out[i] * w4[i]);
+			}
+#endif
+		}
+	}
+
+	void InterpolationKernel::normalizeRotations(Batch& batch)
+	{
+		assert(batch.components == 4);
+
+		const auto stride = batch.stride;
+
+		for (size_t i = 0; i < batch.count; i++) {
+			const auto type = (Interpolation)batch.types[i];
+			if (type != INTERPOLATION_HERMITE && type != INTERPOLATION_BEZIER) {
+				continue;
+			}
+
+			float len2 = 0.0f;
+			for (size_t c = 0; c < 4; c++) {
+				const float v = batch.result[(c * stride) + i];
+				len2 += v * v;
+			}
+
+			if (len2 > 0.0f) {
+				const float inv = 1.0f / sqrtf(len2);
+				for (size_t c = 0; c < 4; c++) {
+					batch.result[(c * stride) + i] *= inv;
+				}
+			}
+		}
+	}
+}
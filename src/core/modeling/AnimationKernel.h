@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Animation.h"
+
+namespace core {
+
+	/// <summary>
+	/// Evaluates many animation segments at once.
+	/// Values are stored component-major (structure of arrays), so a single blend loop covers every lane and track type,
+	/// the per-lane work is reduced to computing four weights for (v1, v2, t1, t2).
+	/// </summary>
+	class InterpolationKernel {
+	public:
+
+		struct Batch {
+			// number of float components per value, 3 for vectors, 4 for quaternions.
+			size_t components = 3;
+			size_t count = 0;
+			// distance between components within the value arrays, count rounded up to the SIMD width.
+			size_t stride = 0;
+
+			std::vector<uint8_t> types;
+			std::vector<float> ratios;
+
+			// component c of lane i is stored at [c * stride + i].
+			std::vector<float> v1;
+			std::vector<float> v2;
+			std::vector<float> t1;
+			std::vector<float> t2;
+			std::vector<float> result;
+
+			// optional packed quaternion keys, decoded by the kernel rather than at load.
+			bool packed = false;
+			std::vector<int16_t> packedV1;
+			std::vector<int16_t> packedV2;
+			std::vector<int16_t> packedT1;
+			std::vector<int16_t> packedT2;
+
+			// clears lanes while keeping allocations, so batches can be reused between frames.
+			void reset(size_t component_count, size_t lane_count, bool packed_keys = false);
+
+			void set(size_t lane, const AnimationSegment<Vector3>& segment);
+			void set(size_t lane, const AnimationSegment<Quaternion>& segment);
+
+			void setPacked(size_t lane, Interpolation type, float ratio, const int16_t* a, const int16_t* b, const int16_t* in, const int16_t* out);
+
+			Vector3 getVector(size_t lane) const {
+				return Vector3(result[lane], result[stride + lane], result[(stride * 2) + lane]);
+			}
+
+			Quaternion getQuaternion(size_t lane) const {
+				return Quaternion(result[lane], result[stride + lane], result[(stride * 2) + lane], result[(stride * 3) + lane]);
+			}
+
+		protected:
+			void store(std::vector<float>& values, size_t lane, float x, float y, float z) {
+				values[lane] = x;
+				values[stride + lane] = y;
+				values[(stride * 2) + lane] = z;
+			}
+
+			void store(std::vector<float>& values, size_t lane, float x, float y, float z, float w) {
+				store(values, lane, x, y, z);
+				values[(stride * 3) + lane] = w;
+			}
+
+			// four weights per lane, applied to v1, v2, t1 and t2.
+			std::vector<float> weights;
+
+			friend class InterpolationKernel;
+		};
+
+		// rotations use slerp for linear segments and normalize spline results, matching AnimationSegment::evaluate.
+		static void evaluate(Batch& batch, bool rotations);
+
+	protected:
+		static void decode(Batch& batch);
+		static void computeWeights(Batch& batch, bool rotations);
+		static void blend(Batch& batch);
+		static void normalizeRotations(Batch& batch);
+	};
+}
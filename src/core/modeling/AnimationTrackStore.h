@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "../utility/Vector3.h"
+#include "../utility/Quaternion.h"
+
+namespace core {
+
+	/// <summary>
+	/// Contiguous storage for every animated track of a model.
+	/// Tracks reference slices of the shared arrays through the sequence (and range) tables, rather than owning their own allocations.
+	/// The store is filled while loading, after which it is read only.
+	/// </summary>
+	class AnimationTrackStore {
+	public:
+
+		// keys of a single animation, legacy tracks use a single sequence holding the whole timeline.
+		struct Sequence {
+			uint32_t timeOffset = 0;
+			// index of the first key within the value array, spline keys occupy 3 slots (value, in tangent, out tangent).
+			uint32_t valueOffset = 0;
+			uint32_t count = 0;
+		};
+
+		// legacy tracks select each animation as a range of keys within their timeline.
+		struct Range {
+			uint32_t start = 0;
+			uint32_t end = 0;
+		};
+
+		struct Track {
+			int32_t interpolationType = 0;
+			int32_t globalSequence = -1;
+			// packed tracks hold raw int16 quaternion keys, see packedRotations.
+			bool packed = false;
+
+			uint32_t firstSequence = 0;
+			uint32_t sequenceCount = 0;
+			uint32_t firstRange = 0;
+			uint32_t rangeCount = 0;
+		};
+
+		AnimationTrackStore() = default;
+		AnimationTrackStore(AnimationTrackStore&&) = default;
+
+		uint32_t addTrack(const Track& track) {
+			tracks.push_back(track);
+			return (uint32_t)(tracks.size() - 1);
+		}
+
+		const Track& getTrack(uint32_t index) const {
+			return tracks[index];
+		}
+
+		size_t getTrackCount() const {
+			return tracks.size();
+		}
+
+		template<typename T>
+		std::vector<T>& values() {
+			if constexpr (std::is_same_v<T, float>) {
+				return scalars;
+			}
+			else if constexpr (std::is_same_v<T, Vector3>) {
+				return vectors;
+			}
+			else if constexpr (std::is_same_v<T, Quaternion>) {
+				return rotations;
+			}
+			else {
+				static_assert(sizeof(T) == 0, "Unsupported animated value type.");
+			}
+		}
+
+		template<typename T>
+		const std::vector<T>& values() const {
+			return const_cast<AnimationTrackStore*>(this)->values<T>();
+		}
+
+		// release spare capacity once loading has completed.
+		void shrink() {
+			globalSequences.shrink_to_fit();
+			tracks.shrink_to_fit();
+			sequences.shrink_to_fit();
+			ranges.shrink_to_fit();
+			times.shrink_to_fit();
+			scalars.shrink_to_fit();
+			vectors.shrink_to_fit();
+			rotations.shrink_to_fit();
+			packedRotations.shrink_to_fit();
+		}
+
+		// size of the stored key data in bytes.
+		size_t getDataSize() const {
+			return (tracks.size() * sizeof(Track)) +
+				(sequences.size() * sizeof(Sequence)) +
+				(ranges.size() * sizeof(Range)) +
+				(times.size() * sizeof(uint32_t)) +
+				(scalars.size() * sizeof(float)) +
+				(vectors.size() * sizeof(Vector3)) +
+				(rotations.size() * sizeof(Quaternion)) +
+				(packedRotations.size() * sizeof(int16_t));
+		}
+
+		std::vector<uint32_t> globalSequences;
+
+		std::vector<Sequence> sequences;
+		std::vector<Range> ranges;
+		std::vector<uint32_t> times;
+
+		std::vector<float> scalars;
+		std::vector<Vector3> vectors;
+		std::vector<Quaternion> rotations;
+		// Quat16 keys as stored in the file, 4 values per key. decoded during evaluation.
+		std::vector<int16_t> packedRotations;
+
+	protected:
+		std::vector<Track> tracks;
+	};
+}
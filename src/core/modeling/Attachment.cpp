@@ -5,7 +5,8 @@
 namespace core {
 
 	Attachment::Attachment(CharacterSlot slot):
-		ComponentMeta(ComponentMeta::Type::ATTACHMENT)
+		ComponentMeta(ComponentMeta::Type::ATTACHMENT),
+		itemVisualId(0)
 	{
 		AttachOwnedModel owned;
 		owned.model = nullptr;
@@ -16,7 +17,8 @@ namespace core {
 	}
 
 	Attachment::Attachment(MergedModel* merged_model, CharacterSlot slot) :
-		ComponentMeta(ComponentMeta::Type::ATTACHMENT)
+		ComponentMeta(ComponentMeta::Type::ATTACHMENT),
+		itemVisualId(0)
 	{
 		AttachMergedModel merged;
 		merged.model = merged_model;
@@ -24,20 +26,41 @@ namespace core {
 		characterSlot = slot;
 	}
 
-	void Attachment::update(const Animator& animator, const AnimationTickArgs& tick) {
+	void Attachment::step(const Animator& animator, const AnimationTickArgs& tick) {
+
+		stepModel(animator, tick);
+		
+		for (auto& effect : effects) {
+			effect->step(animator, tick);
+		}
+	}
+
+	void Attachment::present(float alpha) {
+
+		presentModel(alpha);
+
+		for (auto& effect : effects) {
+			effect->present(alpha);
+		}
+	}
+
+	void Attachment::stepModel(const Animator& animator, const AnimationTickArgs& tick) {
 
 		visit<AttachOwnedModel>([&](AttachOwnedModel* owned) {
 			owned->model->calculateBones(animator.getAnimationIndex().value(), tick);
-			owned->updateAnimation();
 
 			owned->model->updateParticles(animator.getAnimationIndex().value(), tick);
 			owned->model->updateRibbons(animator.getAnimationIndex().value(), tick);
 
 		});
-		
-		for (auto& effect : effects) {
-			effect->update(animator, tick);
-		}
+	}
+
+	void Attachment::presentModel(float alpha) {
+
+		visit<AttachOwnedModel>([&](AttachOwnedModel* owned) {
+			owned->model->presentBones(alpha);
+			owned->presentSkinning();
+		});
 	}
 
 	CharacterSlot Attachment::getSlot() const {
@@ -29,15 +29,19 @@ namespace core {
 			Effect(Effect&&) = default;
 			virtual ~Effect() {};
 
-			void update(const Animator& animator, const AnimationTickArgs& tick) {
+			void step(const Animator& animator, const AnimationTickArgs& tick) {
 
 				model->calculateBones(animator.getAnimationIndex().value(), tick);
-				updateAnimation();
 
 				model->updateParticles(animator.getAnimationIndex().value(), tick);
 				model->updateRibbons(animator.getAnimationIndex().value(), tick);
 			}
 
+			void present(float alpha) {
+				model->presentBones(alpha);
+				presentSkinning();
+			}
+
 
 			virtual GameFileInfo getMetaGameFileInfo() const override {
 				return model->getFileInfo();
@@ -56,7 +60,15 @@ namespace core {
 		Attachment(Attachment&&) = default;
 		virtual ~Attachment() {}
 
-		void update(const Animator& animator, const AnimationTickArgs& tick);
+		// advance the simulation by a single fixed step.
+		void step(const Animator& animator, const AnimationTickArgs& tick);
+
+		// skin using bones blended between the last two steps.
+		void present(float alpha);
+
+		// step / present the attached model only, excluding effects.
+		void stepModel(const Animator& animator, const AnimationTickArgs& tick);
+		void presentModel(float alpha);
 
 		CharacterSlot getSlot() const;
 
@@ -70,6 +82,11 @@ namespace core {
 			std::unique_ptr<M2Model> model;
 			uint16_t bone;
 			Vector3 position;
+
+		protected:
+			void skinPresented() override {
+				updateAnimation(getVisibleVertexRanges());
+			}
 		};
 
 		// model data lives in the parent model merges (DF+)
@@ -85,6 +102,11 @@ namespace core {
 
 		std::variant<AttachOwnedModel, AttachMergedModel> modelData;
 		AttachmentPosition attachmentPosition;
+
+		// files and visual the attachment was loaded from, compared when items are refreshed so unchanged attachments can be reused.
+		GameFileUri modelUri;
+		GameFileUri textureUri;
+		uint32_t itemVisualId;
 		
 		template<typename T>
 		requires (std::is_same_v<T, AttachOwnedModel> || std::is_same_v<T, AttachMergedModel>)
@@ -82,18 +82,60 @@ namespace core {
 			owned->initGeosetData(owned->model.get(), true);
 
 			//load attachment texture
-			auto tex = scene->textureManager.add(texture_file, gameFS);
-			if (tex != nullptr) {
-				owned->replacableTextures[TextureType::CAPE] = tex;
-			}
+			applyTexture(owned, texture_file, scene);
 		});
 
+		att->modelUri = model_file;
+		att->textureUri = texture_file;
 		
 		parent->setAttachmentPosition(att.get(), position);
 
 		return std::move(att);
 	}
 
+	bool StandardAttachmentCustomizationProvider::updateAttachment(
+		Attachment* attachment,
+		AttachmentPosition position,
+		const CharacterItemWrapper& wrapper,
+		const GameFileUri& model_file,
+		const GameFileUri& texture_file,
+		Model* parent,
+		Scene* scene
+	) const
+	{
+		bool reused = false;
+
+		attachment->visit<Attachment::AttachOwnedModel>([&](Attachment::AttachOwnedModel* owned) {
+			if (owned->model == nullptr || attachment->modelUri != model_file) {
+				return;
+			}
+
+			if (attachment->textureUri != texture_file) {
+				applyTexture(owned, texture_file, scene);
+				attachment->textureUri = texture_file;
+			}
+
+			reused = true;
+		});
+
+		if (reused && attachment->attachmentPosition != position) {
+			parent->setAttachmentPosition(attachment, position);
+		}
+
+		return reused;
+	}
+
+	void StandardAttachmentCustomizationProvider::applyTexture(ModelTextureInfo* info, const GameFileUri& texture_file, Scene* scene) const
+	{
+		auto tex = scene->textureManager.add(texture_file, gameFS);
+		if (tex != nullptr) {
+			info->replacableTextures[TextureType::CAPE] = tex;
+		}
+		else {
+			info->replacableTextures.erase(TextureType::CAPE);
+		}
+	}
+
 	StackVector<AttachmentPosition, 2> MergedAwareAttachmentCustomizationProvider::getAttachmentPositions(CharacterSlot slot, const ItemRecordAdaptor* item, bool sheatheWeapons) const
 	{
 		auto attach_positions = StandardAttachmentCustomizationProvider::getAttachmentPositions(slot, item, sheatheWeapons);
@@ -134,12 +176,7 @@ namespace core {
 		const bool is_merged_type = isMergedType(slot);
 
 		if (is_merged_type) {
-			const auto display_id = wrapper.display()->getId();
-
-			// enforce some assumptions on sizes.
-			static_assert(sizeof(display_id) == sizeof(uint32_t));
-			static_assert(sizeof(MergedModel::id_t) == sizeof(uint64_t));
-			const MergedModel::id_t merged_id = (uint64_t(display_id) << 32) + (uint64_t(slot) << 16) + uint64_t(position);
+			const MergedModel::id_t merged_id = getMergedId(wrapper, slot, position);
 
 			auto custom = std::make_unique<MergedModel>(
 				parent,
@@ -160,13 +197,12 @@ namespace core {
 			Log::message("Loaded merged model / attachment - " + QString::number(custom->getId()));
 
 			//load attachment texture
-			auto tex = scene->textureManager.add(texture_file, gameFS);
-			if (tex != nullptr) {
-				custom->replacableTextures[TextureType::CAPE] = tex;
-			}
+			applyTexture(custom.get(), texture_file, scene);
 
 			auto att = std::make_unique<Attachment>(custom.get(), slot);
 			att->attachmentPosition = position;
+			att->modelUri = model_file;
+			att->textureUri = texture_file;
 
 			
 			parent->addRelation(std::move(custom));
@@ -181,6 +217,52 @@ namespace core {
 
 		return nullptr; 
 	}
+
+	bool MergedAwareAttachmentCustomizationProvider::updateAttachment(
+		Attachment* attachment,
+		AttachmentPosition position,
+		const CharacterItemWrapper& wrapper,
+		const GameFileUri& model_file,
+		const GameFileUri& texture_file,
+		Model* parent,
+		Scene* scene
+	) const
+	{
+		if (!isMergedType(attachment->getSlot())) {
+			return StandardAttachmentCustomizationProvider::updateAttachment(attachment, position, wrapper, model_file, texture_file, parent, scene);
+		}
+
+		bool reused = false;
+
+		attachment->visit<Attachment::AttachMergedModel>([&](Attachment::AttachMergedModel* merged) {
+			// the relation id is derived from the display and position, so both must still match.
+			if (merged->model == nullptr || 
+				attachment->modelUri != model_file || 
+				merged->model->getId() != getMergedId(wrapper, attachment->getSlot(), position)) {
+				return;
+			}
+
+			if (attachment->textureUri != texture_file) {
+				applyTexture(merged->model, texture_file, scene);
+				attachment->textureUri = texture_file;
+			}
+
+			reused = true;
+		});
+
+		return reused;
+	}
+
+	MergedModel::id_t MergedAwareAttachmentCustomizationProvider::getMergedId(const CharacterItemWrapper& wrapper, CharacterSlot slot, AttachmentPosition position)
+	{
+		const auto display_id = wrapper.display()->getId();
+
+		// enforce some assumptions on sizes.
+		static_assert(sizeof(display_id) == sizeof(uint32_t));
+		static_assert(sizeof(MergedModel::id_t) == sizeof(uint64_t));
+		return (uint64_t(display_id) << 32) + (uint64_t(slot) << 16) + uint64_t(position);
+	}
+
 	bool MergedAwareAttachmentCustomizationProvider::isMergedType(CharacterSlot slot) const
 	{
 		return slot != CharacterSlot::HAND_LEFT && slot != CharacterSlot::HAND_RIGHT && slot != CharacterSlot::SHOULDER && slot != CharacterSlot::HEAD && slot != CharacterSlot::BELT;
@@ -27,6 +27,17 @@ namespace core {
 			Model* parent,
 			Scene* scene
 		) const = 0;
+
+		// bring an existing attachment in line with the requested files, returns false when it cannot be reused and must be loaded again.
+		virtual bool updateAttachment(
+			Attachment* attachment,
+			AttachmentPosition position,
+			const CharacterItemWrapper& wrapper,
+			const GameFileUri& model_file,
+			const GameFileUri& texture_file,
+			Model* parent,
+			Scene* scene
+		) const = 0;
 	};
 
 	class StandardAttachmentCustomizationProvider : public AttachmentCustomizationProvider {
@@ -50,10 +61,22 @@ namespace core {
 			Scene* scene
 		) const override;
 
+		virtual bool updateAttachment(
+			Attachment* attachment,
+			AttachmentPosition position,
+			const CharacterItemWrapper& wrapper,
+			const GameFileUri& model_file,
+			const GameFileUri& texture_file,
+			Model* parent,
+			Scene* scene
+		) const override;
+
 	protected:
 		GameFileSystem* gameFS;
 		GameDatabase* gameDB;
 		mutable M2Model::Factory modelFactory;
+
+		void applyTexture(ModelTextureInfo* info, const GameFileUri& texture_file, Scene* scene) const;
 	};
 
 	class MergedAwareAttachmentCustomizationProvider : public StandardAttachmentCustomizationProvider {
@@ -76,9 +99,21 @@ namespace core {
 			Scene* scene
 		) const override;
 
+		virtual bool updateAttachment(
+			Attachment* attachment,
+			AttachmentPosition position,
+			const CharacterItemWrapper& wrapper,
+			const GameFileUri& model_file,
+			const GameFileUri& texture_file,
+			Model* parent,
+			Scene* scene
+		) const override;
+
 	protected:
 
 		bool isMergedType(CharacterSlot slot) const;
 
+		static MergedModel::id_t getMergedId(const CharacterItemWrapper& wrapper, CharacterSlot slot, AttachmentPosition position);
+
 	};
 }
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "../../stdafx.h"
+#include "BakedAnimation.h"
+#include "BonePalette.h"
+
+namespace core {
+
+	namespace {
+
+		uint16_t quantize(float value, float min, float range) {
+			if (range <= 0.0f) {
+				return 0;
+			}
+
+			const float normalized = std::clamp((value - min) / range, 0.0f, 1.0f);
+			return (uint16_t)std::lround(normalized * 65535.0f);
+		}
+
+		float dequantize(uint16_t value, float min, float range) {
+			return min + (range * ((float)value / 65535.0f));
+		}
+
+		Vector3 decode(const uint16_t* packed, const Vector3& min, const Vector3& range) {
+			return Vector3(
+				dequantize(packed[0], min.x, range.x),
+				dequantize(packed[1], min.y, range.y),
+				dequantize(packed[2], min.z, range.z)
+			);
+		}
+
+		Quaternion decode(const int16_t* packed) {
+			return Quaternion(
+				packed[0] / 32767.0f,
+				packed[1] / 32767.0f,
+				packed[2] / 32767.0f,
+				packed[3] / 32767.0f
+			);
+		}
+
+		Vector3 lerp(const Vector3& a, const Vector3& b, float r) {
+			return a + ((b - a) * r);
+		}
+	}
+
+	std::unique_ptr<BakedAnimation> BakedAnimation::bake(const std::vector<ModelBoneAdaptor*>& bones, size_t animation_index, uint32_t duration, uint32_t sample_rate)
+	{
+		assert(sample_rate > 0);
+
+		auto baked = std::make_unique<BakedAnimation>();
+		baked->animationIndex = animation_index;
+		baked->duration = duration;
+		baked->sampleRate = sample_rate;
+		baked->sampleInterval = 1000.0f / sample_rate;
+		// +1 so the final frame of the sequence is always included.
+		baked->sampleCount = (size_t)std::ceil(duration / baked->sampleInterval) + 1;
+		baked->tracks.resize(bones.size());
+
+		for (size_t i = 0; i < bones.size(); i++) {
+			const auto* bone = bones[i];
+			auto& track = baked->tracks[i];
+
+			track.translated = bone->getTranslation()->uses(animation_index);
+			track.rotated = bone->getRotation()->uses(animation_index);
+			track.scaled = bone->getScale()->uses(animation_index);
+
+			track.live = (track.translated && bone->getTranslation()->usesGlobalSequence()) ||
+				(track.rotated && bone->getRotation()->usesGlobalSequence()) ||
+				(track.scaled && bone->getScale()->usesGlobalSequence());
+
+			if (track.animated() && !track.live) {
+				track.column = (int32_t)baked->columns++;
+			}
+		}
+
+		if (baked->columns == 0) {
+			return baked;
+		}
+
+		const auto column_count = baked->columns;
+		const auto sample_count = baked->sampleCount;
+
+		// sample everything at full precision first, the ranges are needed before quantizing.
+		std::vector<Vector3> translations(sample_count * column_count);
+		std::vector<Quaternion> rotations(sample_count * column_count);
+		std::vector<Vector3> scales(sample_count * column_count, Vector3(1.0f, 1.0f, 1.0f));
+
+		for (size_t s = 0; s < sample_count; s++) {
+			const auto frame = (uint32_t)std::min<float>(std::round(s * baked->sampleInterval), (float)duration);
+			const AnimationTickArgs tick(frame, 0, frame);
+
+			for (size_t i = 0; i < bones.size(); i++) {
+				const auto& track = baked->tracks[i];
+				if (track.column < 0) {
+					continue;
+				}
+
+				const auto index = (s * column_count) + track.column;
+
+				if (track.translated) {
+					translations[index] = bones[i]->getTranslation()->getValue(animation_index, tick);
+				}
+
+				if (track.rotated) {
+					Quaternion q = bones[i]->getRotation()->getValue(animation_index, tick);
+					q.normalize();
+
+					// keep consecutive samples in the same hemisphere, so blending takes the short path.
+					if (s > 0 && (q * rotations[index - column_count]) < 0.0f) {
+						q = Quaternion(q * -1.0f);
+					}
+
+					rotations[index] = q;
+				}
+
+				if (track.scaled) {
+					scales[index] = bones[i]->getScale()->getValue(animation_index, tick);
+				}
+			}
+		}
+
+		auto compute_range = [&](const std::vector<Vector3>& values, int32_t column, Vector3& min, Vector3& range) {
+			Vector3 max = values[column];
+			min = values[column];
+
+			for (size_t s = 1; s < sample_count; s++) {
+				const auto& v = values[(s * column_count) + column];
+				min = Vector3(std::min(min.x, v.x), std::min(min.y, v.y), std::min(min.z, v.z));
+				max = Vector3(std::max(max.x, v.x), std::max(max.y, v.y), std::max(max.z, v.z));
+			}
+
+			range = max - min;
+		};
+
+		for (auto& track : baked->tracks) {
+			if (track.column < 0) {
+				continue;
+			}
+
+			compute_range(translations, track.column, track.translationMin, track.translationRange);
+			compute_range(scales, track.column, track.scaleMin, track.scaleRange);
+		}
+
+		baked->samples.resize(sample_count * column_count);
+
+		for (const auto& track : baked->tracks) {
+			if (track.column < 0) {
+				continue;
+			}
+
+			for (size_t s = 0; s < sample_count; s++) {
+				const auto index = (s * column_count) + track.column;
+				auto& packed = baked->samples[index];
+
+				const auto& t = translations[index];
+				packed.translation[0] = quantize(t.x, track.translationMin.x, track.translationRange.x);
+				packed.translation[1] = quantize(t.y, track.translationMin.y, track.translationRange.y);
+				packed.translation[2] = quantize(t.z, track.translationMin.z, track.translationRange.z);
+
+				const auto& q = rotations[index];
+				packed.rotation[0] = (int16_t)std::lround(std::clamp(q.x, -1.0f, 1.0f) * 32767.0f);
+				packed.rotation[1] = (int16_t)std::lround(std::clamp(q.y, -1.0f, 1.0f) * 32767.0f);
+				packed.rotation[2] = (int16_t)std::lround(std::clamp(q.z, -1.0f, 1.0f) * 32767.0f);
+				packed.rotation[3] = (int16_t)std::lround(std::clamp(q.w, -1.0f, 1.0f) * 32767.0f);
+
+				const auto& sc = scales[index];
+				packed.scale[0] = quantize(sc.x, track.scaleMin.x, track.scaleRange.x);
+				packed.scale[1] = quantize(sc.y, track.scaleMin.y, track.scaleRange.y);
+				packed.scale[2] = quantize(sc.z, track.scaleMin.z, track.scaleRange.z);
+			}
+		}
+
+		return baked;
+	}
+
+	bool BakedAnimation::calculateLocal(size_t bone_index, const ModelBoneAdaptor* bone, const AnimationTickArgs& tick, Matrix& local, Quaternion& rotation) const
+	{
+		const auto& track = tracks[bone_index];
+
+		if (track.live) {
+			return bone->calculateLocal(animationIndex, tick, local, rotation);
+		}
+
+		if (track.column < 0) {
+			// matches the live result for static and billboarded bones, T(pivot) * T(-pivot).
+			local.unit();
+			return false;
+		}
+
+		const float position = std::min<float>(tick.currentFrame, (float)duration) / sampleInterval;
+		const size_t first = std::min((size_t)position, sampleCount - 1);
+		const size_t second = std::min(first + 1, sampleCount - 1);
+		const float r = position - (float)first;
+
+		const auto& a = samples[(first * columns) + track.column];
+		const auto& b = samples[(second * columns) + track.column];
+
+		const auto& pivot = bone->getPivot();
+		local.translation(pivot);
+
+		if (track.translated) {
+			local *= Matrix::newTranslation(lerp(
+				decode(a.translation, track.translationMin, track.translationRange),
+				decode(b.translation, track.translationMin, track.translationRange),
+				r
+			));
+		}
+
+		if (track.rotated) {
+			// samples are close together, so a normalized lerp is indistinguishable from slerp.
+			rotation = Quaternion((decode(a.rotation) * (1.0f - r)) + (decode(b.rotation) * r));
+			rotation.normalize();
+			local *= Matrix::newQuatRotate(rotation);
+		}
+
+		if (track.scaled) {
+			local *= Matrix::newScale(lerp(
+				decode(a.scale, track.scaleMin, track.scaleRange),
+				decode(b.scale, track.scaleMin, track.scaleRange),
+				r
+			));
+		}
+
+		local *= Matrix::newTranslation(pivot * -1.0f);
+
+		return track.rotated;
+	}
+
+	BakedAnimation::ErrorMetric BakedAnimation::measureError(const std::vector<ModelBoneAdaptor*>& bones) const
+	{
+		ErrorMetric metric;
+
+		if (bones.size() == 0 || sampleCount < 2) {
+			return metric;
+		}
+
+		BonePalette live;
+		BonePalette baked;
+		live.init(bones);
+		baked.init(bones);
+
+		double total = 0.0;
+		size_t count = 0;
+
+		for (size_t s = 0; s + 1 < sampleCount; s++) {
+			const auto frame = (uint32_t)std::min<float>((s + 0.5f) * sampleInterval, (float)duration);
+			const AnimationTickArgs tick(frame, 0, frame);
+
+			live.calculate(animationIndex, tick, bones);
+			baked.calculateWith([&](size_t bone_index, Matrix& local, Quaternion& rotation) -> bool {
+				return calculateLocal(bone_index, bones[bone_index], tick, local, rotation);
+			});
+
+			for (size_t i = 0; i < bones.size(); i++) {
+				const float error = (live.getTranslationPivot(i) - baked.getTranslationPivot(i)).length();
+				metric.maxError = std::max(metric.maxError, error);
+				total += error;
+				count++;
+			}
+		}
+
+		metric.meanError = (float)(total / count);
+
+		return metric;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../utility/Matrix.h"
+#include "../utility/Vector3.h"
+#include "../utility/Quaternion.h"
+#include "Animation.h"
+#include "ModelAdaptors.h"
+
+namespace core {
+
+	/// <summary>
+	/// Animation sequence pre-sampled at a fixed rate, with the bone tracks quantized into a compact palette.
+	/// Playback only needs to blend two neighbouring samples, rather than searching and interpolating each track.
+	/// </summary>
+	class BakedAnimation {
+	public:
+
+		struct ErrorMetric {
+			// distance between live and baked bone positions, in model units.
+			float maxError = 0.0f;
+			float meanError = 0.0f;
+		};
+
+		BakedAnimation() = default;
+		BakedAnimation(BakedAnimation&&) = default;
+
+		static std::unique_ptr<BakedAnimation> bake(const std::vector<ModelBoneAdaptor*>& bones, size_t animation_index, uint32_t duration, uint32_t sample_rate);
+
+		// calculates the bone transform relative to its parent, matches ModelBoneAdaptor::calculateLocal.
+		bool calculateLocal(size_t bone_index, const ModelBoneAdaptor* bone, const AnimationTickArgs& tick, Matrix& local, Quaternion& rotation) const;
+
+		// compare baked output against live evaluation, sampled between the baked keys where the error is largest.
+		ErrorMetric measureError(const std::vector<ModelBoneAdaptor*>& bones) const;
+
+		size_t getAnimationIndex() const {
+			return animationIndex;
+		}
+
+		uint32_t getSampleRate() const {
+			return sampleRate;
+		}
+
+		size_t getSampleCount() const {
+			return sampleCount;
+		}
+
+		// size of the packed sample data in bytes.
+		size_t getDataSize() const {
+			return samples.size() * sizeof(PackedSample);
+		}
+
+	protected:
+
+		struct PackedSample {
+			int16_t rotation[4];
+			uint16_t translation[3];
+			uint16_t scale[3];
+		};
+
+		struct BoneTrack {
+			bool translated = false;
+			bool rotated = false;
+			bool scaled = false;
+			// bones using global sequences depend on absolute time, so cannot be baked against the animation frame.
+			bool live = false;
+			int32_t column = -1;
+
+			Vector3 translationMin;
+			Vector3 translationRange;
+			Vector3 scaleMin;
+			Vector3 scaleRange;
+
+			bool animated() const {
+				return translated || rotated || scaled;
+			}
+		};
+
+		size_t animationIndex = 0;
+		uint32_t duration = 0;
+		uint32_t sampleRate = 0;
+		float sampleInterval = 0.0f;
+		size_t sampleCount = 0;
+		size_t columns = 0;
+
+		std::vector<BoneTrack> tracks;
+		// laid out as samples[sample * columns + column].
+		std::vector<PackedSample> samples;
+	};
+}
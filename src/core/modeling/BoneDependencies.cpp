@@ -0,0 +1,72 @@
+#include "../../stdafx.h"
+#include "BoneDependencies.h"
+#include "M2.h"
+
+namespace core {
+
+	void BoneDependencies::init(const M2Model* model)
+	{
+		const auto bone_count = model->getBoneAdaptors().size();
+		const auto& geosets = model->getGeosetAdaptors();
+		const auto& indices = model->getIndices();
+		const auto& vertices = model->getRawVertices();
+
+		geosetBones.clear();
+		emitterBones.clear();
+		geosetBones.resize(geosets.size());
+
+		std::vector<bool> used(bone_count, false);
+
+		for (size_t g = 0; g < geosets.size(); g++) {
+			const auto start = geosets[g]->getTriangleStart();
+			const auto end = std::min<size_t>(start + geosets[g]->getTriangleCount(), indices.size());
+
+			std::fill(used.begin(), used.end(), false);
+
+			for (size_t i = start; i < end; i++) {
+				const auto& vertex = vertices[indices[i]];
+
+				for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++) {
+					if (vertex.boneWeights[b] > 0 && vertex.bones[b] < bone_count) {
+						used[vertex.bones[b]] = true;
+					}
+				}
+			}
+
+			for (size_t bone_index = 0; bone_index < bone_count; bone_index++) {
+				if (used[bone_index]) {
+					geosetBones[g].push_back((uint16_t)bone_index);
+				}
+			}
+		}
+
+		for (const auto* particle : model->getParticleAdaptors()) {
+			if (particle->getBone() < bone_count) {
+				emitterBones.push_back(particle->getBone());
+			}
+		}
+
+		for (const auto* ribbon : model->getRibbonAdaptors()) {
+			if (ribbon->getBone() < bone_count) {
+				emitterBones.push_back(ribbon->getBone());
+			}
+		}
+	}
+
+	void BoneDependencies::collect(const GeosetState& state, std::vector<bool>& required) const
+	{
+		for (size_t g = 0; g < geosetBones.size(); g++) {
+			if (!state.indexVisible((uint32_t)g)) {
+				continue;
+			}
+
+			for (const auto bone_index : geosetBones[g]) {
+				required[bone_index] = true;
+			}
+		}
+
+		for (const auto bone_index : emitterBones) {
+			required[bone_index] = true;
+		}
+	}
+}
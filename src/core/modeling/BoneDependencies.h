@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Geoset.h"
+
+namespace core {
+
+	class M2Model;
+
+	/// <summary>
+	/// Lookup of the bones each part of a model depends on, used to skip evaluating bones that nothing visible uses.
+	/// </summary>
+	class BoneDependencies {
+	public:
+		BoneDependencies() = default;
+		BoneDependencies(BoneDependencies&&) = default;
+
+		void init(const M2Model* model);
+
+		// marks the bones used by the visible geosets and the emitters.
+		void collect(const GeosetState& state, std::vector<bool>& required) const;
+
+		// bones weighted by the vertices of a geoset.
+		const std::vector<uint16_t>& getGeosetBones(size_t geoset_index) const {
+			return geosetBones[geoset_index];
+		}
+
+		// bones the particle and ribbon emitters are attached to.
+		const std::vector<uint16_t>& getEmitterBones() const {
+			return emitterBones;
+		}
+
+		size_t getGeosetCount() const {
+			return geosetBones.size();
+		}
+
+	protected:
+		std::vector<std::vector<uint16_t>> geosetBones;
+		std::vector<uint16_t> emitterBones;
+	};
+}
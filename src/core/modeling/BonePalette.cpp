@@ -0,0 +1,236 @@
+#include "../../stdafx.h"
+#include "BonePalette.h"
+
+namespace core {
+
+	namespace {
+
+		// affine bone transform split into scale, rotation and translation, so poses can be blended without shearing.
+		struct Decomposed {
+			Vector3 scale;
+			Quaternion rotation;
+			Vector3 translation;
+		};
+
+		bool decompose(const Matrix& source, Decomposed& result) {
+			float scale[3];
+			for (size_t col = 0; col < 3; col++) {
+				scale[col] = std::sqrt((source.m[0][col] * source.m[0][col]) + (source.m[1][col] * source.m[1][col]) + (source.m[2][col] * source.m[2][col]));
+				if (scale[col] < 1e-6f) {
+					return false;
+				}
+			}
+
+			Matrix rotation = Matrix::identity();
+			for (size_t row = 0; row < 3; row++) {
+				for (size_t col = 0; col < 3; col++) {
+					rotation.m[row][col] = source.m[row][col] / scale[col];
+				}
+			}
+
+			// mirrored transforms keep a proper rotation, the reflection is carried by the scale.
+			const float det = (rotation.m[0][0] * ((rotation.m[1][1] * rotation.m[2][2]) - (rotation.m[1][2] * rotation.m[2][1]))) -
+				(rotation.m[0][1] * ((rotation.m[1][0] * rotation.m[2][2]) - (rotation.m[1][2] * rotation.m[2][0]))) +
+				(rotation.m[0][2] * ((rotation.m[1][0] * rotation.m[2][1]) - (rotation.m[1][1] * rotation.m[2][0])));
+			if (det < 0.0f) {
+				scale[0] = -scale[0];
+				for (size_t row = 0; row < 3; row++) {
+					rotation.m[row][0] = -rotation.m[row][0];
+				}
+			}
+
+			result.scale = Vector3(scale[0], scale[1], scale[2]);
+			result.rotation = rotation.GetQuaternion();
+			result.rotation.normalize();
+			result.translation = Vector3(source.m[0][3], source.m[1][3], source.m[2][3]);
+			return true;
+		}
+
+		// inverse of decompose, the rotation uses the same convention as Matrix::GetQuaternion.
+		Matrix compose(const Decomposed& source) {
+			const auto& q = source.rotation;
+			const float rotation[3][3] = {
+				{ 1.0f - 2.0f * ((q.y * q.y) + (q.z * q.z)), 2.0f * ((q.x * q.y) - (q.w * q.z)), 2.0f * ((q.x * q.z) + (q.w * q.y)) },
+				{ 2.0f * ((q.x * q.y) + (q.w * q.z)), 1.0f - 2.0f * ((q.x * q.x) + (q.z * q.z)), 2.0f * ((q.y * q.z) - (q.w * q.x)) },
+				{ 2.0f * ((q.x * q.z) - (q.w * q.y)), 2.0f * ((q.y * q.z) + (q.w * q.x)), 1.0f - 2.0f * ((q.x * q.x) + (q.y * q.y)) }
+			};
+			const float scale[3] = { source.scale.x, source.scale.y, source.scale.z };
+			const float translation[3] = { source.translation.x, source.translation.y, source.translation.z };
+
+			Matrix result;
+			for (size_t row = 0; row < 3; row++) {
+				for (size_t col = 0; col < 3; col++) {
+					result.m[row][col] = rotation[row][col] * scale[col];
+				}
+				result.m[row][3] = translation[row];
+			}
+			result.m[3][0] = result.m[3][1] = result.m[3][2] = 0.0f;
+			result.m[3][3] = 1.0f;
+
+			return result;
+		}
+
+		// slerp of the rotation, linear scale and translation. degenerate (zero scaled) bones fall back to a component-wise blend.
+		Matrix blend(const Matrix& a, const Matrix& b, float alpha) {
+			Decomposed from;
+			Decomposed to;
+			if (!decompose(a, from) || !decompose(b, to)) {
+				return Matrix::lerp(a, b, alpha);
+			}
+
+			// take the shorter way round.
+			if ((from.rotation * to.rotation) < 0.0f) {
+				to.rotation = to.rotation * -1.0f;
+			}
+
+			Decomposed result;
+			result.scale = from.scale + ((to.scale - from.scale) * alpha);
+			result.rotation = Quaternion::slerp(alpha, from.rotation, to.rotation);
+			result.rotation.normalize();
+			result.translation = from.translation + ((to.translation - from.translation) * alpha);
+
+			return compose(result);
+		}
+	}
+
+	void BonePalette::init(const std::vector<ModelBoneAdaptor*>& bones)
+	{
+		const auto bone_count = bones.size();
+
+		order.clear();
+		parents.clear();
+		pivots.clear();
+
+		order.reserve(bone_count);
+		parents.reserve(bone_count);
+		pivots.reserve(bone_count);
+
+		for (const auto* bone : bones) {
+			auto parent = bone->getParentBoneId();
+			if (parent < 0 || parent >= (int32_t)bone_count) {
+				parent = -1;
+			}
+			parents.push_back(parent);
+			pivots.push_back(bone->getPivot());
+		}
+
+		// depth of each bone within the hierarchy, parents always have a lower depth than their children.
+		std::vector<uint32_t> depths(bone_count, 0);
+		for (size_t i = 0; i < bone_count; i++) {
+			uint32_t depth = 0;
+			auto parent = parents[i];
+			while (parent > -1) {
+				if (++depth > bone_count) {
+					// cyclic hierarchy, shouldnt happen with valid files - treat as a root bone.
+					assert(false);
+					parents[i] = -1;
+					depth = 0;
+					break;
+				}
+				parent = parents[parent];
+			}
+			depths[i] = depth;
+		}
+
+		for (size_t i = 0; i < bone_count; i++) {
+			order.push_back((uint16_t)i);
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&depths](uint16_t a, uint16_t b) {
+			return depths[a] < depths[b];
+		});
+
+		active = order;
+
+		mat.resize(bone_count);
+		mrot.resize(bone_count);
+		translationPivots.resize(bone_count);
+
+		for (size_t i = 0; i < bone_count; i++) {
+			mat[i].unit();
+			mrot[i].unit();
+			translationPivots[i] = pivots[i];
+		}
+
+		steps = 0;
+		presenting = false;
+	}
+
+	void BonePalette::beginStep()
+	{
+		restoreSimulated();
+
+		previousMat = mat;
+		previousMrot = mrot;
+		steps = std::min(steps + 1, 2u);
+	}
+
+	void BonePalette::present(float alpha)
+	{
+		restoreSimulated();
+
+		if (steps < 2 || alpha >= 1.0f) {
+			return;
+		}
+
+		simulatedMat = mat;
+		simulatedMrot = mrot;
+		simulatedPivots = translationPivots;
+		presenting = true;
+
+		// inactive bones are unchanged between steps.
+		// pivots follow the blended transforms, so the bones overlay stays on the presented mesh.
+		for (const auto bone_index : active) {
+			mat[bone_index] = blend(previousMat[bone_index], simulatedMat[bone_index], alpha);
+			mrot[bone_index] = blend(previousMrot[bone_index], simulatedMrot[bone_index], alpha);
+			translationPivots[bone_index] = mat[bone_index] * pivots[bone_index];
+		}
+	}
+
+	void BonePalette::restoreSimulated()
+	{
+		if (presenting) {
+			mat.swap(simulatedMat);
+			mrot.swap(simulatedMrot);
+			translationPivots.swap(simulatedPivots);
+			presenting = false;
+		}
+	}
+
+	void BonePalette::setRequired(const std::vector<bool>& required)
+	{
+		if (required.size() != parents.size()) {
+			active = order;
+			return;
+		}
+
+		std::vector<bool> keep(required);
+		for (size_t i = 0; i < keep.size(); i++) {
+			if (!required[i]) {
+				continue;
+			}
+
+			auto parent = parents[i];
+			while (parent > -1 && !required[parent] && !keep[parent]) {
+				keep[parent] = true;
+				parent = parents[parent];
+			}
+		}
+
+		active.clear();
+		for (const auto bone_index : order) {
+			if (keep[bone_index]) {
+				active.push_back(bone_index);
+			}
+		}
+	}
+
+	void BonePalette::calculate(size_t animation_index, const AnimationTickArgs& tick, const std::vector<ModelBoneAdaptor*>& bones)
+	{
+		assert(bones.size() == parents.size());
+
+		calculateWith([&](size_t bone_index, Matrix& local, Quaternion& rotation) -> bool {
+			return bones[bone_index]->calculateLocal(animation_index, tick, local, rotation);
+		});
+	}
+}
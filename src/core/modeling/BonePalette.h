@@ -0,0 +1,137 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../utility/Matrix.h"
+#include "../utility/Vector3.h"
+#include "Animation.h"
+#include "ModelAdaptors.h"
+
+namespace core {
+
+	/// <summary>
+	/// Flat storage of the calculated bone transforms for a model.
+	/// Bones are evaluated in parent-before-child order, so the whole skeleton can be resolved in a single linear pass.
+	/// </summary>
+	class BonePalette {
+	public:
+		BonePalette() = default;
+		BonePalette(BonePalette&&) = default;
+		BonePalette& operator=(BonePalette&&) = default;
+
+		// build the evaluation order and parent table, must be called once all bones have been loaded.
+		void init(const std::vector<ModelBoneAdaptor*>& bones);
+
+		void calculate(size_t animation_index, const AnimationTickArgs& tick, const std::vector<ModelBoneAdaptor*>& bones);
+
+		// restrict evaluation to the required bones and their ancestors, other bones keep their last calculated values.
+		// an empty mask restores evaluation of every bone.
+		void setRequired(const std::vector<bool>& required);
+
+		// calculate using an alternative source of parent-relative transforms.
+		// local_fn(bone_index, local, rotation) must return true when the bone is rotated.
+		template<typename fn>
+		void calculateWith(fn local_fn) {
+			Matrix local;
+			Quaternion rotation;
+
+			for (const auto bone_index : active) {
+				const bool rotated = local_fn(bone_index, local, rotation);
+				resolve(bone_index, local, rotated, rotation);
+			}
+		}
+
+		// fixed step interpolation, called before calculating each simulation step.
+		// restores the simulated transforms if interpolated ones are being presented, then keeps them as the previous step.
+		void beginStep();
+
+		// present transforms blended between the previous and latest step, alpha of 1 presents the latest step as is.
+		// the simulated transforms are restored by the next beginStep.
+		void present(float alpha);
+
+		size_t size() const {
+			return parents.size();
+		}
+
+		const Matrix& getMat(size_t bone_index) const {
+			return mat[bone_index];
+		}
+
+		const Matrix& getMRot(size_t bone_index) const {
+			return mrot[bone_index];
+		}
+
+		const Vector3& getTranslationPivot(size_t bone_index) const {
+			return translationPivots[bone_index];
+		}
+
+		int16_t getParent(size_t bone_index) const {
+			return parents[bone_index];
+		}
+
+		// bone indices sorted so that every parent appears before its children.
+		const std::vector<uint16_t>& getOrder() const {
+			return order;
+		}
+
+		// subset of the order which is evaluated by calculate.
+		const std::vector<uint16_t>& getActive() const {
+			return active;
+		}
+
+		const std::vector<Matrix>& getMatrices() const {
+			return mat;
+		}
+
+		const std::vector<Matrix>& getRotationMatrices() const {
+			return mrot;
+		}
+
+	protected:
+
+		// combine a parent-relative transform with the (already resolved) parent bone.
+		void resolve(uint16_t bone_index, const Matrix& local, bool rotated, const Quaternion& rotation) {
+			const auto parent = parents[bone_index];
+
+			if (parent > -1) {
+				mat[bone_index] = mat[parent] * local;
+			}
+			else {
+				mat[bone_index] = local;
+			}
+
+			if (rotated) {
+				if (parent > -1) {
+					mrot[bone_index] = mrot[parent] * Matrix::newQuatRotate(rotation);
+				}
+				else {
+					mrot[bone_index] = Matrix::newQuatRotate(rotation);
+				}
+			}
+			else {
+				mrot[bone_index].unit();
+			}
+
+			translationPivots[bone_index] = mat[bone_index] * pivots[bone_index];
+		}
+
+		std::vector<uint16_t> order;
+		std::vector<uint16_t> active;
+		std::vector<int16_t> parents;
+		std::vector<Vector3> pivots;
+
+		std::vector<Matrix> mat;
+		std::vector<Matrix> mrot;
+		std::vector<Vector3> translationPivots;
+
+		void restoreSimulated();
+
+		std::vector<Matrix> previousMat;
+		std::vector<Matrix> previousMrot;
+		std::vector<Matrix> simulatedMat;
+		std::vector<Matrix> simulatedMrot;
+		std::vector<Vector3> simulatedPivots;
+		// steps calculated since init (capped at 2), blending needs a previous step to start from.
+		uint32_t steps = 0;
+		bool presenting = false;
+	};
+}
@@ -0,0 +1,126 @@
+#include "../../stdafx.h"
+#include "BoneTrackEvaluator.h"
+#include "BonePalette.h"
+
+namespace core {
+
+	namespace {
+		// Quat16 encoding of (0, 0, 0, 1), used when a packed track has no value.
+		const int16_t PACKED_IDENTITY[4] = { 32767, 32767, 32767, -1 };
+	}
+
+	void BoneTrackEvaluator::calculate(size_t animation_index, const AnimationTickArgs& tick, const std::vector<ModelBoneAdaptor*>& bones, BonePalette& palette)
+	{
+		assert(bones.size() == palette.size());
+
+		const auto& active = palette.getActive();
+
+		lanes.resize(bones.size());
+
+		size_t translation_count = 0;
+		size_t rotation_count = 0;
+		size_t scale_count = 0;
+		// rotations are decoded by the kernel when every track holds packed keys.
+		bool packed_rotations = true;
+
+		for (const auto bone_index : active) {
+			const auto* bone = bones[bone_index];
+			auto& lane = lanes[bone_index];
+
+			lane.translation = bone->getTranslation()->uses(animation_index) ? (int32_t)translation_count++ : -1;
+			lane.rotation = bone->getRotation()->uses(animation_index) ? (int32_t)rotation_count++ : -1;
+			lane.scale = bone->getScale()->uses(animation_index) ? (int32_t)scale_count++ : -1;
+
+			if (lane.rotation > -1) {
+				packed_rotations = packed_rotations && bone->getRotation()->isPacked();
+			}
+		}
+
+		translations.reset(3, translation_count);
+		rotations.reset(4, rotation_count, packed_rotations);
+		scales.reset(3, scale_count);
+
+		rotationFixes.assign(rotation_count, nullptr);
+
+		// segments are default constructed each time, tracks without a segment evaluate to T() as getValue does.
+		for (const auto bone_index : active) {
+			const auto* bone = bones[bone_index];
+			const auto& lane = lanes[bone_index];
+
+			if (lane.translation > -1) {
+				AnimationSegment<Vector3> segment;
+				bone->getTranslation()->getSegment(animation_index, tick, segment);
+				translations.set(lane.translation, segment);
+			}
+
+			if (lane.rotation > -1) {
+				if (packed_rotations) {
+					PackedAnimationSegment segment;
+					if (bone->getRotation()->getPackedSegment(animation_index, tick, segment)) {
+						rotations.setPacked(lane.rotation, segment.type, segment.ratio, segment.v1, segment.v2, segment.t1, segment.t2);
+						rotationFixes[lane.rotation] = segment.fix;
+					}
+					else {
+						rotations.setPacked(lane.rotation, INTERPOLATION_NONE, 0.0f, PACKED_IDENTITY, PACKED_IDENTITY, nullptr, nullptr);
+					}
+				}
+				else {
+					AnimationSegment<Quaternion> segment;
+					bone->getRotation()->getSegment(animation_index, tick, segment);
+					rotations.set(lane.rotation, segment);
+				}
+			}
+
+			if (lane.scale > -1) {
+				AnimationSegment<Vector3> segment;
+				bone->getScale()->getSegment(animation_index, tick, segment);
+				scales.set(lane.scale, segment);
+			}
+		}
+
+		InterpolationKernel::evaluate(translations, false);
+		InterpolationKernel::evaluate(rotations, true);
+		InterpolationKernel::evaluate(scales, false);
+
+		palette.calculateWith([&](size_t bone_index, Matrix& local, Quaternion& rotation) -> bool {
+			const auto& lane = lanes[bone_index];
+
+			if (lane.translation < 0 && lane.rotation < 0 && lane.scale < 0) {
+				// static and billboarded bones, T(pivot) * T(-pivot).
+				local.unit();
+				return false;
+			}
+
+			Vector3 translation;
+			Vector3 scale;
+
+			if (lane.translation > -1) {
+				translation = translations.getVector(lane.translation);
+			}
+
+			if (lane.rotation > -1) {
+				rotation = rotations.getQuaternion(lane.rotation);
+
+				// fixes are orthogonal, so applying them after blending matches fixing each key.
+				const auto fix = rotationFixes[lane.rotation];
+				if (fix != nullptr) {
+					rotation = fix(rotation);
+				}
+			}
+
+			if (lane.scale > -1) {
+				scale = scales.getVector(lane.scale);
+			}
+
+			ModelBoneAdaptor::composeLocal(
+				bones[bone_index]->getPivot(),
+				lane.translation > -1 ? &translation : nullptr,
+				lane.rotation > -1 ? &rotation : nullptr,
+				lane.scale > -1 ? &scale : nullptr,
+				local
+			);
+
+			return lane.rotation > -1;
+		});
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Animation.h"
+#include "AnimationKernel.h"
+#include "ModelAdaptors.h"
+
+namespace core {
+
+	class BonePalette;
+
+	/// <summary>
+	/// Evaluates the bone tracks of a model in batches.
+	/// Key lookup remains per track, but decoding and interpolation for every translation, rotation and scale is handed to the InterpolationKernel in one go.
+	/// </summary>
+	class BoneTrackEvaluator {
+	public:
+		BoneTrackEvaluator() = default;
+		BoneTrackEvaluator(BoneTrackEvaluator&&) = default;
+		BoneTrackEvaluator& operator=(BoneTrackEvaluator&&) = default;
+
+		// calculate the palette's active bones, produces the same result as BonePalette::calculate.
+		void calculate(size_t animation_index, const AnimationTickArgs& tick, const std::vector<ModelBoneAdaptor*>& bones, BonePalette& palette);
+
+	protected:
+		// lane used by each bone within the batches, -1 when the track isnt used by the animation.
+		struct BoneLanes {
+			int32_t translation = -1;
+			int32_t rotation = -1;
+			int32_t scale = -1;
+		};
+
+		std::vector<BoneLanes> lanes;
+
+		InterpolationKernel::Batch translations;
+		InterpolationKernel::Batch rotations;
+		InterpolationKernel::Batch scales;
+
+		// per rotation lane, applied to packed results after decoding.
+		std::vector<Quaternion(*)(const Quaternion&)> rotationFixes;
+	};
+}
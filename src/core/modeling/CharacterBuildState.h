@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../game/GameConstants.h"
+
+namespace core {
+
+	/// <summary>
+	/// Tracks which character inputs have changed since the model was last rebuilt.
+	/// Each output lists the inputs it depends on, so a rebuild only recomputes the outputs affected by the change.
+	/// </summary>
+	class CharacterBuildState {
+	public:
+
+		enum Input : uint32_t {
+			INPUT_NONE = 0,
+			// chosen customization options (skin, face, hair etc).
+			INPUT_CUSTOMIZATION = 1 << 0,
+			// CharacterRenderOptions, e.g underwear, feet and hair visibility.
+			INPUT_RENDER_OPTIONS = 1 << 1,
+			// custom tabard choices.
+			INPUT_TABARD = 1 << 2,
+			// equipped items, the slots affected are tracked separately.
+			INPUT_EQUIPMENT = 1 << 3,
+			INPUT_ALL = INPUT_CUSTOMIZATION | INPUT_RENDER_OPTIONS | INPUT_TABARD | INPUT_EQUIPMENT
+		};
+
+		enum class Output {
+			// customization texture layers, replaceable textures and merged models, produced by the customization provider.
+			CUSTOMIZATION,
+		};
+
+		CharacterBuildState() {
+			invalidateAll();
+		}
+
+		void invalidate(uint32_t inputs) {
+			dirtyInputs |= inputs;
+		}
+
+		void invalidateSlot(CharacterSlot slot) {
+			dirtyInputs |= INPUT_EQUIPMENT;
+			dirtySlots |= slotBit(slot);
+		}
+
+		// equipment layers are indexed by their position in the slot order, so slots that moved since the last build need rebuilding.
+		void updateSlotOrder(const std::vector<CharacterSlot>& order) {
+			for (size_t i = 0; i < order.size(); i++) {
+				if (i >= slotOrder.size() || slotOrder[i] != order[i]) {
+					invalidateSlot(order[i]);
+				}
+			}
+
+			slotOrder = order;
+		}
+
+		void invalidateAll() {
+			dirtyInputs = INPUT_ALL;
+			dirtySlots = ~0u;
+		}
+
+		bool needs(Output output) const {
+			return (dirtyInputs & dependencies(output)) != 0;
+		}
+
+		bool needsSlot(CharacterSlot slot) const {
+			return (dirtySlots & slotBit(slot)) != 0 || (dirtyInputs & slotDependencies(slot)) != 0;
+		}
+
+		// called once all dirty outputs have been recomputed.
+		void clear() {
+			dirtyInputs = INPUT_NONE;
+			dirtySlots = 0;
+		}
+
+		static constexpr uint32_t dependencies(Output output) {
+			switch (output) {
+			case Output::CUSTOMIZATION:
+				return INPUT_CUSTOMIZATION | INPUT_RENDER_OPTIONS;
+			}
+
+			return INPUT_ALL;
+		}
+
+		// inputs, other than the item itself, that the texture layers of an equipment slot depend on.
+		static constexpr uint32_t slotDependencies(CharacterSlot slot) {
+			switch (slot) {
+			case CharacterSlot::BOOTS:
+				return INPUT_RENDER_OPTIONS;
+			case CharacterSlot::TABARD:
+				return INPUT_TABARD;
+			default:
+				return INPUT_NONE;
+			}
+		}
+
+	protected:
+		static_assert((uint32_t)CharacterSlot::MAX <= 32);
+
+		static constexpr uint32_t slotBit(CharacterSlot slot) {
+			return 1u << (uint32_t)slot;
+		}
+
+		uint32_t dirtyInputs;
+		uint32_t dirtySlots;
+		// of the last build.
+		std::vector<CharacterSlot> slotOrder;
+	};
+}
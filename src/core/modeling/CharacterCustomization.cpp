@@ -930,12 +930,11 @@ namespace core {
 
 	void ModelDefaultsGeosetModifier::operator()(GeosetState& state)
 	{
-		state.each([](auto& el) {
+		state.each([](uint32_t geoset_id, bool& visible) {
 			//load all the default geosets
 			//e.g 0, 101, 201, 301 ... etc
 			//equipment is responsible for unsetting the visibility of the default geosets.
-			const auto geoset_id = el.first;
-			el.second = geoset_id == 0 || (geoset_id > 100 && geoset_id % 100 == 1);
+			visible = geoset_id == 0 || (geoset_id > 100 && geoset_id % 100 == 1);
 		});
 	}
 
@@ -947,6 +946,25 @@ namespace core {
 		}
 	}
 
+	size_t CharacterDefaultsGeosetModifier::signature() const
+	{
+		return (size_t)model->characterOptions.earVisibilty;
+	}
+
+	size_t CharacterEquipGeosetModifier::signature() const
+	{
+		size_t seed = 0;
+		for (const auto& equip : model->characterEquipment) {
+			const auto* record = equip.second.display();
+			combine(seed, (size_t)equip.first);
+			combine(seed, (size_t)equip.second.item()->getInventorySlotId());
+			combine(seed, record->getGeosetGlovesFlags());
+			combine(seed, record->getGeosetRobeFlags());
+			combine(seed, record->getGeosetBracerFlags());
+		}
+		return seed;
+	}
+
 	void CharacterEquipGeosetModifier::operator()(GeosetState& state)
 	{
 		ModelTraits traits = ModelTraits(model);
@@ -989,13 +1007,32 @@ namespace core {
 		}
 	}
 
+	size_t LegacyCharCustomGeosetModifier::signature() const
+	{
+		size_t seed = 0;
+		combine(seed, model->characterOptions.showHair);
+		combine(seed, model->characterOptions.showFacialHair);
+
+		if (context->hairStyle != nullptr) {
+			combine(seed, context->hairStyle->getGeoset());
+		}
+
+		if (context->facialStyle != nullptr) {
+			combine(seed, context->facialStyle->getGeoset100());
+			combine(seed, context->facialStyle->getGeoset200());
+			combine(seed, context->facialStyle->getGeoset300());
+		}
+
+		return seed;
+	}
+
 	void LegacyCharCustomGeosetModifier::operator()(GeosetState& state)
 	{
 		if (context->hairStyle != nullptr) {
 			const auto hair_geoset_id = std::max(1u, context->hairStyle->getGeoset());
-			state.each([&](auto& el) {
-				if (el.first == hair_geoset_id) {
-					el.second = model->characterOptions.showHair;
+			state.each([&](uint32_t geoset_id, bool& visible) {
+				if (geoset_id == hair_geoset_id) {
+					visible = model->characterOptions.showHair;
 				}
 			});
 		}
@@ -1014,6 +1051,16 @@ namespace core {
 		}
 	}
 
+	size_t ModernCharCustomGeosetModifier::signature() const
+	{
+		size_t seed = 0;
+		for (const auto& geo : context->geosets) {
+			combine(seed, geo.geosetType);
+			combine(seed, geo.geosetId);
+		}
+		return seed;
+	}
+
 	void ModernCharCustomGeosetModifier::operator()(GeosetState& state)
 	{
 		//TODO handle model->characterOptions.showFacialHair
@@ -1026,6 +1073,11 @@ namespace core {
 		state.setVisibility(core::CharacterGeosets::CG_FACE, 1);
 	}
 
+	size_t CharEyeGlowGeosetModifier::signature() const
+	{
+		return (size_t)model->characterOptions.eyeGlow;
+	}
+
 	void CharEyeGlowEnumBasedGeosetModifier::operator()(GeosetState& state)
 	{
 		state.setVisibility(CharacterGeosets::CG_EYEGLOW, (uint32_t)model->characterOptions.eyeGlow);
@@ -1041,6 +1093,11 @@ namespace core {
 		}
 	}
 
+	size_t CharacterOverridesGeosetModifier::signature() const
+	{
+		return (size_t)model->characterOptions.earVisibilty;
+	}
+
 	void CharacterOverridesGeosetModifier::operator()(GeosetState& state)
 	{
 		// after the provider update, handle ear visiblity overrides.
@@ -1063,9 +1120,9 @@ namespace core {
 			const uint32_t start = geoset * 100;
 			const uint32_t end = (geoset * (100 + 1)) - 1;
 
-			state.each([&](auto& el) {
-				if (el.first >= start && el.first <= end) {
-					el.second = true;
+			state.each([&](uint32_t geoset_id, bool& visible) {
+				if (geoset_id >= start && geoset_id <= end) {
+					visible = true;
 				}
 			});
 		};
@@ -1111,6 +1168,16 @@ namespace core {
 
 	}
 
+	size_t MergedCustomizationGeosetModifier::signature() const
+	{
+		size_t seed = 0;
+		for (const auto& context : contextModels) {
+			combine(seed, context.geosetType);
+			combine(seed, context.geosetId);
+		}
+		return seed;
+	}
+
 	void MergedCustomizationGeosetModifier::operator()(GeosetState& state)
 	{
 		for (const auto& context : contextModels) {
@@ -265,6 +265,7 @@ namespace core {
 	public:
 		using GeosetModifier::GeosetModifier;
 		void operator()(GeosetState& state) override;
+		size_t signature() const override;
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharCustomsEarly;
 		}
@@ -274,6 +275,7 @@ namespace core {
 	public:
 		using GeosetModifier::GeosetModifier;
 		void operator()(GeosetState& state) override;
+		size_t signature() const override;
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharEquip;
 		}
@@ -283,6 +285,7 @@ namespace core {
 	public:
 		using GeosetModifier::GeosetModifier;
 		void operator()(GeosetState& state) override;
+		size_t signature() const override;
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharCustomsLate;
 		}
@@ -294,6 +297,7 @@ namespace core {
 	public:
 		using GeosetModifier::GeosetModifier;
 		void operator()(GeosetState& state) override;
+		size_t signature() const override;
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharCustomsLate;
 		}
@@ -304,6 +308,7 @@ namespace core {
 	class CharEyeGlowGeosetModifier : public GeosetModifier {
 	public:
 		using GeosetModifier::GeosetModifier;
+		size_t signature() const override;
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharCustomsOverride + 10;
 		}
@@ -325,6 +330,7 @@ namespace core {
 	public:
 		using GeosetModifier::GeosetModifier;
 		void operator()(GeosetState& state) override;
+		size_t signature() const override;
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharCustomsOverride;
 		}
@@ -333,6 +339,9 @@ namespace core {
 	class MergedEquipmentGeosetModifier : public GeosetModifier {
 	public:
 		void operator()(GeosetState& state) override;
+		size_t signature() const override {
+			return (size_t)slot;
+		}
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharEquip;
 		}
@@ -343,6 +352,7 @@ namespace core {
 	class MergedCustomizationGeosetModifier : public GeosetModifier{
 	public:
 		void operator()(GeosetState & state) override;
+		size_t signature() const override;
 		int32_t priority() const override {
 			return (int32_t)GeosetModiferPriority::CharCustomsLate + 10;
 		}
@@ -4,6 +4,7 @@
 #include "../game/GameConstants.h"
 #include "../database/GameDatasetAdaptors.h"
 #include "Particles.h"
+#include "BonePalette.h"
 
 namespace core {
 
@@ -218,8 +219,7 @@ namespace core {
 			boneDefinition(std::move(def)),
 			translation(std::move(t)),
 			rotation(std::move(r)),
-			scale(std::move(s)),
-			calculated(false)
+			scale(std::move(s))
 		{
 			pivot = Vector3::yUpToZUp(boneDefinition.pivot);
 			billboard = (boneDefinition.flags & ModelBoneFlags::spherical_billboard) != 0;
@@ -232,16 +232,11 @@ namespace core {
 		AnimatedValue<Vector3, R> scale;
 
 		Vector3 pivot;
-		Vector3 translationPivot;
 
 		bool billboard;
-		Matrix mat;
-		Matrix mrot;
 
 		ModelBoneM2<R> boneDefinition;
 
-		bool calculated;
-
 		virtual const IAnimatedValue<Vector3>* getTranslation() const override {
 			return &translation;
 		}
@@ -254,18 +249,6 @@ namespace core {
 			return &scale;
 		}
 
-		virtual const Matrix& getMat() const {
-			return mat;
-		}
-
-		virtual const Matrix& getMRot() const {
-			return mrot;
-		}
-
-		virtual const Vector3& getTranslationPivot() const {
-			return translationPivot;
-		}
-
 		virtual const Vector3& getPivot() const {
 			return pivot;
 		}
@@ -274,68 +257,37 @@ namespace core {
 			return boneDefinition.parentBoneId;
 		}
 
-		virtual void resetCalculated() {
-			calculated = false;
-		}
-
-		virtual void calculateMatrix(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) {
+		virtual bool calculateLocal(size_t animation_index, const AnimationTickArgs& tick, Matrix& local, Quaternion& q) const override {
 
-			if (calculated) {
-				return;
-			}
+			const bool rotated = rotation.uses(animation_index);
 
-			Matrix m;
-			Quaternion q;
-
-			if (rotation.uses(animation_index) || scale.uses(animation_index) || translation.uses(animation_index) || billboard) {
-				m.translation(pivot);
+			if (rotated || scale.uses(animation_index) || translation.uses(animation_index) || billboard) {
+				std::optional<Vector3> t;
+				std::optional<Vector3> s;
 
 				if (translation.uses(animation_index)) {
-					m *= Matrix::newTranslation(translation.getValue(animation_index, tick));
+					t = translation.getValue(animation_index, tick);
 				}
 
-				if (rotation.uses(animation_index)) {
+				if (rotated) {
 					q = rotation.getValue(animation_index, tick);
-					m *= Matrix::newQuatRotate(q);
 				}
 
 				if (scale.uses(animation_index)) {
-					m *= Matrix::newScale(scale.getValue(animation_index, tick));
+					s = scale.getValue(animation_index, tick);
 				}
 
 				if (billboard) {
 					//TODO
 				}
 
-				m *= Matrix::newTranslation(pivot * -1.0f);
+				composeLocal(pivot, t ? &*t : nullptr, rotated ? &q : nullptr, s ? &*s : nullptr, local);
 			}
 			else {
-				m.unit();
+				local.unit();
 			}
 
-			if (boneDefinition.parentBoneId > -1) {
-				allbones[boneDefinition.parentBoneId]->calculateMatrix(animation_index, tick, allbones);
-				mat = allbones[boneDefinition.parentBoneId]->getMat() * m;
-			}
-			else {
-				mat = m;
-			}
-
-			if (rotation.uses(animation_index)) {
-				if (boneDefinition.parentBoneId >= 0) {
-					mrot = allbones[boneDefinition.parentBoneId]->getMRot() * Matrix::newQuatRotate(q);
-				}
-				else {
-					mrot = Matrix::newQuatRotate(q);
-				}
-			}
-			else {
-				mrot.unit();
-			}
-
-			//TODO
-			translationPivot = mat * pivot;
-			calculated = true;
+			return rotated;
 		}
 	};
 
@@ -359,38 +311,50 @@ namespace core {
 			numberOfSegments = (uint32_t)definition.edgesPerSecond;
 			length = definition.edgesPerSecond * definition.edgeLifetime;
 
-			auto segment = ModelRibbonEmitterAdaptor::RibbonSegment();
-			segment.position = tpos;
-			segment.len = 0;
-			segments.push_back(std::move(segment));
+			// every segment bar the newest is at least edgeLifetime long, so the trail can never exceed this.
+			segments.resize(std::max(numberOfSegments, 1) + 2);
+			segmentHead = 0;
+			segmentCount = 1;
+			segments[0].position = tpos;
 
+			strip.reserve((segments.size() + 1) * 2);
 		}
 		GenericModelRibbonEmitter(GenericModelRibbonEmitter&&) = default;
 		virtual ~GenericModelRibbonEmitter() {}
 
-		virtual void update(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) {
+		virtual void update(size_t animation_index, const AnimationTickArgs& tick, const BonePalette& bones) {
 
-			const auto* parent_bone = allbones[definition.boneIndex];
+			if (segments.size() == 0) {
+				return;
+			}
+
+			const auto& parent_mat = bones.getMat(definition.boneIndex);
 
 			//TODO tidy code, better names, better logic
 
-			Vector3 ntpos = parent_bone->getMat() * pos;
-			Vector3 ntup = parent_bone->getMat() * (pos + Vector3(0, 0, 1));
+			Vector3 ntpos = parent_mat * pos;
+			Vector3 ntup = parent_mat * (pos + Vector3(0, 0, 1));
 			ntup -= ntpos;
 			ntup.normalize();
 			float dlen = (ntpos - tpos).length();
 
 			// move first segment
-			RibbonSegment& first = *segments.begin();
+			RibbonSegment& first = segment(0);
 			if (first.len > definition.edgeLifetime) {
 				// add new segment
 				first.back = (tpos - ntpos).normalize();
 				first.len0 = first.len;
-				RibbonSegment newseg;
+
+				// newest segment lives at the head, when full the oldest gets overwritten.
+				segmentHead = (segmentHead + segments.size() - 1) % segments.size();
+				segmentCount = std::min(segmentCount + 1, segments.size());
+
+				RibbonSegment& newseg = segment(0);
 				newseg.position = ntpos;
 				newseg.up = ntup;
+				newseg.back = Vector3();
 				newseg.len = dlen;
-				segments.push_front(newseg);
+				newseg.len0 = 0.0f;
 			}
 			else {
 				first.up = ntup;
@@ -400,18 +364,13 @@ namespace core {
 
 			// kill stuff from the end
 			float l = 0;
-			bool erasemode = false;
-			for (std::list<RibbonSegment>::iterator it = segments.begin(); it != segments.end(); ) {
-				if (!erasemode) {
-					l += it->len;
-					if (l > length) {
-						it->len = l - length;
-						erasemode = true;
-					}
-					++it;
-				}
-				else {
-					segments.erase(it++);
+			for (size_t i = 0; i < segmentCount; i++) {
+				auto& seg = segment(i);
+				l += seg.len;
+				if (l > length) {
+					seg.len = l - length;
+					segmentCount = i + 1;
+					break;
 				}
 			}
 
@@ -419,12 +378,18 @@ namespace core {
 			tcolor = Vector4(color.getValue(animation_index, tick), opacity.getValue(animation_index, tick));
 			tabove = above.getValue(animation_index, tick);
 			tbelow = below.getValue(animation_index, tick);
+
+			buildStrip();
 		}
 
 		virtual const std::vector<uint16_t> getTexture() const {
 			return textures;
 		}
 
+		constexpr virtual uint16_t getBone() const override {
+			return (uint16_t)definition.boneIndex;
+		}
+
 		virtual const Vector4& getTColor() const {
 			return tcolor;
 		}
@@ -441,8 +406,12 @@ namespace core {
 			return tbelow;
 		}
 
-		virtual const std::list<ModelRibbonEmitterAdaptor::RibbonSegment>& getSegments() const {
-			return segments;
+		virtual size_t getSegmentCount() const override {
+			return segmentCount;
+		}
+
+		virtual const std::vector<ModelRibbonEmitterAdaptor::RibbonVertex>& getStrip() const override {
+			return strip;
 		}
 
 		ModelRibbonEmitterM2<R> definition;
@@ -462,8 +431,42 @@ namespace core {
 
 		std::vector<uint16_t> textures;
 
+	protected:
+
+		// fixed capacity ring, index 0 is the newest segment.
+		std::vector<ModelRibbonEmitterAdaptor::RibbonSegment> segments;
+		size_t segmentHead = 0;
+		size_t segmentCount = 0;
+
+		std::vector<ModelRibbonEmitterAdaptor::RibbonVertex> strip;
+
+		ModelRibbonEmitterAdaptor::RibbonSegment& segment(size_t index) {
+			return segments[(segmentHead + index) % segments.size()];
+		}
 
-		std::list<ModelRibbonEmitterAdaptor::RibbonSegment> segments;
+		void buildStrip() {
+			strip.clear();
+
+			float l = 0;
+			for (size_t i = 0; i < segmentCount; i++) {
+				const auto& seg = segment(i);
+				const float u = l / length;
+
+				strip.push_back({ seg.position + (tabove * seg.up), Vector2(u, 0) });
+				strip.push_back({ seg.position - (tbelow * seg.up), Vector2(u, 1) });
+
+				l += seg.len;
+			}
+
+			if (segmentCount > 1) {
+				// extend the oldest segment towards where it was spawned from.
+				const auto& last = segment(segmentCount - 1);
+				const Vector3 tail = last.len0 > 0 ? (last.len / last.len0) * last.back : Vector3();
+
+				strip.push_back({ last.position + (tabove * last.up) + tail, Vector2(1, 0) });
+				strip.push_back({ last.position - (tbelow * last.up) + tail, Vector2(1, 1) });
+			}
+		}
 	};
 
 
@@ -505,6 +508,18 @@ namespace core {
 
 		float rem;
 
+		RandomGenerator random;
+
+		virtual void reset(uint64_t seed, uint64_t stream) override {
+			particles.clear();
+			rem = 0;
+			random.seed(seed, stream);
+		}
+
+		virtual RandomGenerator& getRandom() override {
+			return random;
+		}
+
 		virtual const std::vector<TexCoordSet>& getTiles() const override {
 			return tiles;
 		}
@@ -579,7 +594,7 @@ namespace core {
 			}
 		}
 
-		virtual void update(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) override {
+		virtual void update(size_t animation_index, const AnimationTickArgs& tick, const BonePalette& bones) override {
 			const float deltat = tick.deltaTime / 1000.0f;
 
 			size_t l_manim = animation_index;
@@ -637,7 +652,7 @@ namespace core {
 								this,
 								animation_index,
 								tick,
-								allbones,
+								bones,
 								{ w, l, spd, var, spr, spr2 }
 							);
 							// sanity check:
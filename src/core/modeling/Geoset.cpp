@@ -11,33 +11,43 @@ static bool geoset_match(core::CharacterGeosets geoset, uint32_t id) {
 
 void core::GeosetState::init(const M2Model* _model, bool default_vis)
 {
-	visibleGeosets.reserve(_model->getGeosetAdaptors().size());
-	for (const auto& geo : _model->getGeosetAdaptors()) {
-		visibleGeosets.emplace_back(geo->getId(), default_vis);
+	revision++;
+	layout++;
+
+	const auto& geosets = _model->getGeosetAdaptors();
+
+	ids.clear();
+	ids.reserve(geosets.size());
+	for (const auto& geo : geosets) {
+		ids.push_back(geo->getId());
+	}
+
+	bits.assign((ids.size() + 63) / 64, 0);
+	if (default_vis) {
+		for (uint32_t i = 0; i < ids.size(); i++) {
+			setIndexVisible(i, true);
+		}
 	}
 }
 
 bool core::GeosetState::has(CharacterGeosets geoset) const
 {
-	auto found = std::find_if(visibleGeosets.begin(), visibleGeosets.end(), [geoset](const auto& el) {
-		return geoset_match(geoset, el.first);
+	auto found = std::find_if(ids.begin(), ids.end(), [geoset](const auto& id) {
+		return geoset_match(geoset, id);
 	});
 
-	return found != visibleGeosets.end();
+	return found != ids.end();
 }
 
 bool core::GeosetState::visible(CharacterGeosets geoset) const
 {
-	auto found = std::find_if(visibleGeosets.begin(), visibleGeosets.end(), [geoset](const auto& el) {
-			return geoset_match(geoset, el.first) && el.second;
-		});
-
-	return found != visibleGeosets.end();
-}
+	for (uint32_t i = 0; i < ids.size(); i++) {
+		if (geoset_match(geoset, ids[i]) && indexVisible(i)) {
+			return true;
+		}
+	}
 
-bool core::GeosetState::indexVisible(uint32_t index) const
-{
-	return visibleGeosets[index].second;
+	return false;
 }
 
 void core::GeosetState::setVisibility(CharacterGeosets geoset, uint32_t flags, bool relative)
@@ -46,30 +56,70 @@ void core::GeosetState::setVisibility(CharacterGeosets geoset, uint32_t flags, b
 	//depending on the context and usage, xx0 can be the default (hidden/empty) , or xx1 can be default (non-empty?)
 	//xx1 id's look to be the default, so +1 gets added to the flags
 	const auto geoset_id = (geoset * 100) + flags + (relative ? 1 : 0);
+	revision++;
 
-	for (auto& el : visibleGeosets) {
-		if (geoset_match(geoset, el.first)) {
-			el.second = el.first == geoset_id;
+	for (uint32_t i = 0; i < ids.size(); i++) {
+		if (geoset_match(geoset, ids[i])) {
+			setIndexVisible(i, ids[i] == geoset_id);
 		}
 	}
 }
 
 void core::GeosetState::clearVisibility(CharacterGeosets geoset)
 {
-	for (auto& el : visibleGeosets) {
-		if (geoset_match(geoset, el.first)) {
-			el.second = false;
+	revision++;
+	for (uint32_t i = 0; i < ids.size(); i++) {
+		if (geoset_match(geoset, ids[i])) {
+			setIndexVisible(i, false);
 		}
 	}
 }
 
-void core::GeosetTransform::apply(GeosetState& state)
+bool core::GeosetTransform::apply(GeosetState& state)
 {
-	for (auto& el : state.visibleGeosets) {
-		el.second = false;
+	// a rebuilt (or different) state invalidates everything cached against the old geoset list.
+	const bool relayout = appliedState != &state || appliedLayout != state.layout;
+	if (relayout) {
+		appliedState = &state;
+		appliedLayout = state.layout;
+		scratch.ids = state.ids;
+		invalidate();
 	}
 
-	for (auto& mod : modifiers) {
-		(*mod)(state);
+	size_t first_dirty = entries.size();
+	for (size_t i = 0; i < entries.size(); i++) {
+		auto& entry = entries[i];
+		const auto signature = entry.modifier->signature();
+		if (entry.modifier->dirty || entry.signature != signature) {
+			first_dirty = i;
+			break;
+		}
 	}
+
+	if (first_dirty == entries.size() && !relayout) {
+		return false;
+	}
+
+	if (first_dirty == 0) {
+		scratch.bits.assign(state.bits.size(), 0);
+	}
+	else {
+		scratch.bits = entries[first_dirty - 1].output;
+	}
+
+	for (size_t i = first_dirty; i < entries.size(); i++) {
+		auto& entry = entries[i];
+		(*entry.modifier)(scratch);
+		entry.signature = entry.modifier->signature();
+		entry.modifier->dirty = false;
+		entry.output = scratch.bits;
+	}
+
+	if (scratch.bits == state.bits) {
+		return false;
+	}
+
+	state.bits = scratch.bits;
+	state.revision++;
+	return true;
 }
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <typeindex>
 #include <vector>
 #include <utility>
 #include "../game/GameConstants.h"
@@ -14,22 +15,58 @@ namespace core {
     class GeosetModifier;
     class GeosetTransform;
 
+    // contiguous run of model vertices, belonging to one or more geosets.
+    struct GeosetVertexRange {
+        uint32_t start;
+        uint32_t count;
+    };
+
     class GeosetState {
         public:
         void init(const M2Model* _model, bool default_vis = true);
 
         bool has(CharacterGeosets geoset) const;
         bool visible(CharacterGeosets geoset) const;
-        bool indexVisible(uint32_t index) const;
+        bool indexVisible(uint32_t index) const {
+            return (bits[index / 64] >> (index % 64)) & 1;
+        }
+        void setIndexVisible(uint32_t index, bool visible) {
+            if (visible) {
+                bits[index / 64] |= (uint64_t(1) << (index % 64));
+            }
+            else {
+                bits[index / 64] &= ~(uint64_t(1) << (index % 64));
+            }
+        }
         void setVisibility(CharacterGeosets geoset, uint32_t flags, bool relative = true);
         void clearVisibility(CharacterGeosets geoset);
 
+        // clb(geoset_id, visible) may modify the visibility.
         void each(auto clb) {
-            std::for_each(visibleGeosets.begin(), visibleGeosets.end(), clb);
+            for (uint32_t i = 0; i < ids.size(); i++) {
+                bool visible = indexVisible(i);
+                clb(ids[i], visible);
+                setIndexVisible(i, visible);
+            }
+        }
+
+        size_t size() const {
+            return ids.size();
+        }
+
+        // incremented whenever visibility has changed.
+        uint32_t getRevision() const {
+            return revision;
         }
 
         private:
-        std::vector<std::pair<uint32_t, bool>> visibleGeosets;	// vector index corrisponds to getGeosets index.
+        // index corrisponds to getGeosets index.
+        std::vector<uint32_t> ids;
+        // visibility, one bit per geoset.
+        std::vector<uint64_t> bits;
+        uint32_t revision = 0;
+        // incremented when the geoset list itself is rebuilt.
+        uint32_t layout = 0;
 
         friend class GeosetTransform;
     };
@@ -46,24 +83,63 @@ namespace core {
 
     class GeosetModifier : public std::enable_shared_from_this<GeosetModifier> {
     public:
-        GeosetModifier(const Model* _model = nullptr) : model(_model) {}
+        GeosetModifier(const Model* _model = nullptr) : model(_model), dirty(true) {}
         virtual void operator()(GeosetState& state) = 0;
         virtual int32_t priority() const = 0;
         virtual ~GeosetModifier() = default;
 
+        // summary of the inputs used by the modifier, the cached output is reused while it remains unchanged.
+        virtual size_t signature() const {
+            return 0;
+        }
+
+        // force the modifier to be re-applied, for changes not covered by the signature.
+        void invalidate() {
+            dirty = true;
+        }
+
     protected:
+        static void combine(size_t& seed, size_t value) {
+            seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+
         const Model* model;
+
+    private:
+        bool dirty;
+
+        friend class GeosetTransform;
     };
 
+    /*
+        Applies the modifiers in priority order.
+        The output of each modifier is cached, so only modifiers following the first changed one need to run again.
+    */
     class GeosetTransform {
     public:
-        void apply(GeosetState& state);
+        // returns true if the visibility changed.
+        bool apply(GeosetState& state);
+
+        // discard all cached outputs, the next apply will run every modifier.
+        void invalidate() {
+            for (auto& entry : entries) {
+                entry.modifier->invalidate();
+            }
+        }
 
         template<typename T> 
         std::shared_ptr<T> getModifier() const 
         { 
-            for (const auto& modifier : modifiers) { 
-                auto derived = std::dynamic_pointer_cast<T>(modifier); 
+            const std::type_index type = typeid(T);
+
+            for (const auto& entry : entries) {
+                if (entry.type == type) {
+                    return std::static_pointer_cast<T>(entry.modifier);
+                }
+            }
+
+            for (const auto& entry : entries) { 
+                auto derived = std::dynamic_pointer_cast<T>(entry.modifier); 
                 if (derived) { 
                     return derived; 
                 } 
@@ -87,17 +163,36 @@ namespace core {
         template<typename T>
         void addModifier(std::shared_ptr<T> modifier)
         {
-            modifiers.push_back(modifier);
+            Entry entry;
+            entry.modifier = modifier;
+            entry.type = typeid(T);
+            entries.push_back(std::move(entry));
 
-            std::sort(modifiers.begin(), modifiers.end(), [](const auto& l, const auto& r) {
-                return l->priority() < r->priority();
+            std::stable_sort(entries.begin(), entries.end(), [](const auto& l, const auto& r) {
+                return l.modifier->priority() < r.modifier->priority();
             });
 
-            assert(modifiers.size() < 10);
+            modifier->invalidate();
+
+            assert(entries.size() < 10);
         }
 
     protected:
-        std::vector<std::shared_ptr<GeosetModifier>> modifiers;
+        struct Entry {
+            std::shared_ptr<GeosetModifier> modifier;
+            // type the modifier was registered as, allows lookup without a dynamic cast.
+            std::type_index type = typeid(void);
+            size_t signature = 0;
+            // visibility after this modifier was applied.
+            std::vector<uint64_t> output;
+        };
+
+        std::vector<Entry> entries;
+
+        // working state, modifiers are applied to this before the result is copied out.
+        GeosetState scratch;
+        uint32_t appliedLayout = 0;
+        const GeosetState* appliedState = nullptr;
     };
     
 
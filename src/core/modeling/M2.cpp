@@ -207,7 +207,7 @@ namespace core {
 		// no-op placeholder for animated fix functions.
 		auto no_fix = [](auto&& val) { return val; };
 
-		m2->globalSequences = std::make_shared<std::vector<uint32_t>>();
+		m2->trackStore = std::make_shared<AnimationTrackStore>();
 
 		std::map<size_t, ChunkedFile> animFiles;	//archive files keyed by animation_id
 
@@ -233,10 +233,10 @@ namespace core {
 					f->read(&sks1, sizeof(sks1), sks1_chunk->second.offset);
 
 					if (sks1.globalSequences.size) {
-						decltype(m2->globalSequences)::element_type temp_sequences;
+						std::vector<uint32_t> temp_sequences;
 						temp_sequences.resize(sks1.globalSequences.size);
 						f->read(temp_sequences.data(), sizeof(uint32_t) * sks1.globalSequences.size, sks1_chunk->second.offset + sks1.globalSequences.offset);
-						std::move(temp_sequences.begin(), temp_sequences.end(), std::back_inserter(*(m2->globalSequences)));
+						std::move(temp_sequences.begin(), temp_sequences.end(), std::back_inserter(m2->trackStore->globalSequences));
 					}
 				}
 
@@ -283,8 +283,8 @@ namespace core {
 		}
 		else if (m2->_header.globalSequences.size) {
 
-			m2->globalSequences->resize(m2->_header.globalSequences.size);
-			memcpy(m2->globalSequences->data(), md2x_buffer.data() + m2->_header.globalSequences.offset, sizeof(uint32_t) * m2->_header.globalSequences.size);
+			m2->trackStore->globalSequences.resize(m2->_header.globalSequences.size);
+			memcpy(m2->trackStore->globalSequences.data(), md2x_buffer.data() + m2->_header.globalSequences.offset, sizeof(uint32_t) * m2->_header.globalSequences.size);
 
 			if (m2->_header.attachments.size) {
 
@@ -742,8 +742,8 @@ namespace core {
 					auto opacity_data = AnimationBlock<int16_t, R>::fromDefinition(color_def.opacity, md2x_buffer, animFiles);
 
 					auto adaptor = std::make_unique<GenericModelColorAdaptor<R>>(
-						AnimatedValue<Vector3, R>::make(std::move(color_data), m2->globalSequences, no_fix),
-						AnimatedValue<float, R>::template make<int16_t, ShortToFloat>(std::move(opacity_data), m2->globalSequences, no_fix)
+						AnimatedValue<Vector3, R>::make(std::move(color_data), m2->trackStore, no_fix),
+						AnimatedValue<float, R>::template make<int16_t, ShortToFloat>(std::move(opacity_data), m2->trackStore, no_fix)
 					);
 
 					m2->colorAdaptors.push_back(std::move(adaptor));
@@ -762,7 +762,7 @@ namespace core {
 					auto trans_data = AnimationBlock<int16_t, R>::fromDefinition(trans_def.transparency, md2x_buffer, animFiles);
 
 					auto adaptor = std::make_unique<GenericModelTransparencyAdaptor<R>>(
-						AnimatedValue<float, R>::template make<int16_t, ShortToFloat>(std::move(trans_data), m2->globalSequences, no_fix)
+						AnimatedValue<float, R>::template make<int16_t, ShortToFloat>(std::move(trans_data), m2->trackStore, no_fix)
 					);
 
 					m2->transparencyAdaptors.push_back(std::move(adaptor));
@@ -783,9 +783,9 @@ namespace core {
 					auto scale = AnimationBlock<Vector3, R>::fromDefinition(uv_anim_def.scale, md2x_buffer, animFiles);
 
 					auto adaptor = std::make_unique<GenericModelTextureAnimationAdaptor<R>>(
-						AnimatedValue<Vector3, R>::make(std::move(trans), m2->globalSequences, no_fix),
-						AnimatedValue<Vector3, R>::make(std::move(rot), m2->globalSequences, no_fix),
-						AnimatedValue<Vector3, R>::make(std::move(scale), m2->globalSequences, no_fix)
+						AnimatedValue<Vector3, R>::make(std::move(trans), m2->trackStore, no_fix),
+						AnimatedValue<Vector3, R>::make(std::move(rot), m2->trackStore, no_fix),
+						AnimatedValue<Vector3, R>::make(std::move(scale), m2->trackStore, no_fix)
 					);
 
 					m2->textureAnimationAdaptors.push_back(std::move(adaptor));
@@ -823,8 +823,8 @@ namespace core {
 								auto trans_data = AnimationBlock<Vector3, R>::fromDefinition(boneDef.translation, buffer_view, animFiles);
 								auto scale_data = AnimationBlock<Vector3, R>::fromDefinition(boneDef.scale, buffer_view, animFiles);
 
-								auto trans_value = AnimatedValue<Vector3, R>::make(std::move(trans_data), m2->globalSequences, Vector3::yUpToZUp);
-								auto scale_value = AnimatedValue<Vector3, R>::make(std::move(scale_data), m2->globalSequences, [](const Vector3& v) {
+								auto trans_value = AnimatedValue<Vector3, R>::make(std::move(trans_data), m2->trackStore, Vector3::yUpToZUp);
+								auto scale_value = AnimatedValue<Vector3, R>::make(std::move(scale_data), m2->trackStore, [](const Vector3& v) {
 									return Vector3(v.x, v.z, v.y);
 									});
 
@@ -833,7 +833,7 @@ namespace core {
 									auto adaptor = std::make_unique<GenericModelBoneAdaptor<R>>(
 										std::move(boneDef),
 										std::move(trans_value),
-										AnimatedValue<Quaternion, R>::make(std::move(rot_data), m2->globalSequences, fix_quaternion),
+										AnimatedValue<Quaternion, R>::make(std::move(rot_data), m2->trackStore, fix_quaternion),
 										std::move(scale_value)
 									);
 
@@ -846,7 +846,7 @@ namespace core {
 									auto adaptor = std::make_unique<GenericModelBoneAdaptor<R>>(
 										std::move(boneDef),
 										std::move(trans_value),
-										AnimatedValue<Quaternion, R>::template make<PACK_QUATERNION, Quat16ToQuat32>(std::move(rot_data), m2->globalSequences, fix_quaternion),
+										AnimatedValue<Quaternion, R>::template make<PACK_QUATERNION, Quat16ToQuat32>(std::move(rot_data), m2->trackStore, fix_quaternion),
 										std::move(scale_value)
 									);
 
@@ -937,17 +937,17 @@ namespace core {
 
 						 adaptor->definition = particleDef;
 
-						 adaptor->speed = AnimatedValue<float, R>::make(std::move(speed), m2->globalSequences, no_fix);
-						 adaptor->variation = AnimatedValue<float, R>::make(std::move(variation), m2->globalSequences, no_fix);
-						 adaptor->spread = AnimatedValue<float, R>::make(std::move(spread), m2->globalSequences, no_fix);
-						 adaptor->lat = AnimatedValue<float, R>::make(std::move(lat), m2->globalSequences, no_fix);
-						 adaptor->gravity = AnimatedValue<float, R>::make(std::move(gravity), m2->globalSequences, no_fix);
-						 adaptor->lifespan = AnimatedValue<float, R>::make(std::move(lifespan), m2->globalSequences, no_fix);
-						 adaptor->rate = AnimatedValue<float, R>::make(std::move(rate), m2->globalSequences, no_fix);
-						 adaptor->areal = AnimatedValue<float, R>::make(std::move(areal), m2->globalSequences, no_fix);
-						 adaptor->areaw = AnimatedValue<float, R>::make(std::move(areaw), m2->globalSequences, no_fix);
-						 adaptor->deacceleration = AnimatedValue<float, R>::make(std::move(deacceleration), m2->globalSequences, no_fix);
-						 adaptor->enabled = AnimatedValue<float, R>::make(std::move(enabled), m2->globalSequences, no_fix);
+						 adaptor->speed = AnimatedValue<float, R>::make(std::move(speed), m2->trackStore, no_fix);
+						 adaptor->variation = AnimatedValue<float, R>::make(std::move(variation), m2->trackStore, no_fix);
+						 adaptor->spread = AnimatedValue<float, R>::make(std::move(spread), m2->trackStore, no_fix);
+						 adaptor->lat = AnimatedValue<float, R>::make(std::move(lat), m2->trackStore, no_fix);
+						 adaptor->gravity = AnimatedValue<float, R>::make(std::move(gravity), m2->trackStore, no_fix);
+						 adaptor->lifespan = AnimatedValue<float, R>::make(std::move(lifespan), m2->trackStore, no_fix);
+						 adaptor->rate = AnimatedValue<float, R>::make(std::move(rate), m2->trackStore, no_fix);
+						 adaptor->areal = AnimatedValue<float, R>::make(std::move(areal), m2->trackStore, no_fix);
+						 adaptor->areaw = AnimatedValue<float, R>::make(std::move(areaw), m2->trackStore, no_fix);
+						 adaptor->deacceleration = AnimatedValue<float, R>::make(std::move(deacceleration), m2->trackStore, no_fix);
+						 adaptor->enabled = AnimatedValue<float, R>::make(std::move(enabled), m2->trackStore, no_fix);
 						 adaptor->rem = 0;
 
 						 
@@ -1054,10 +1054,10 @@ namespace core {
 
 					auto adaptor = std::make_unique<GenericModelRibbonEmitter<R>>(
 						std::move(ribbon_def),
-						AnimatedValue<Vector3, R>::make(std::move(color_data), m2->globalSequences, no_fix),
-						AnimatedValue<float, R>::template make<int16_t, ShortToFloat>(std::move(alpha_data), m2->globalSequences, no_fix),
-						AnimatedValue<float, R>::make(std::move(above_data), m2->globalSequences, no_fix),
-						AnimatedValue<float, R>::make(std::move(below_data), m2->globalSequences, no_fix)
+						AnimatedValue<Vector3, R>::make(std::move(color_data), m2->trackStore, no_fix),
+						AnimatedValue<float, R>::template make<int16_t, ShortToFloat>(std::move(alpha_data), m2->trackStore, no_fix),
+						AnimatedValue<float, R>::make(std::move(above_data), m2->trackStore, no_fix),
+						AnimatedValue<float, R>::make(std::move(below_data), m2->trackStore, no_fix)
 					);
 
 					adaptor->textures = std::move(textures);
@@ -1081,6 +1081,8 @@ namespace core {
 			//lights
 		}
 
+		// all animated values have been created, the track store is read only from here.
+		m2->trackStore->shrink();
 	}
 
 	
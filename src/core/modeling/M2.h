@@ -5,6 +5,10 @@
 #include "../utility/Color.h"
 #include "Animation.h"
 #include "ModelAdaptors.h"
+#include "BonePalette.h"
+#include "BakedAnimation.h"
+#include "BoneTrackEvaluator.h"
+#include "MaterialAnimation.h"
 #include "ModelPathInfo.h"
 #include <memory>
 #include <optional>
@@ -173,7 +177,7 @@ namespace core {
 		}
 
 		const std::vector<uint32_t>& getGlobalSequences() const {
-			return *globalSequences;
+			return trackStore->globalSequences;
 		}
 
 		const std::vector<Vector3>& getVertices() const {
@@ -231,7 +235,8 @@ namespace core {
 		std::vector<std::unique_ptr<ModelRibbonEmitterAdaptor>> ribbonAdaptors;
 		std::vector<std::unique_ptr<ModelParticleEmitterAdaptor>> particleAdaptors;	
 
-		std::shared_ptr<std::vector<uint32_t>> globalSequences;
+		// key data of every animated value, shared by the adaptors.
+		std::shared_ptr<AnimationTrackStore> trackStore;
 
 		std::vector<Vector3> vertices;
 		std::vector<Vector3> normals;
@@ -343,6 +348,8 @@ namespace core {
 			M2Loader loader(m2.get(), fs, uri);
 			m2->modelPathInfo =  ModelPathInfo(m2->getFileInfo().path, fs);	
 			m2->renderPasses = std::move(loader.renderPasses);
+			m2->bonePalette.init(m2->getBoneAdaptors());
+			m2->resetParticles();
 
 			return std::make_pair(std::move(m2), std::move(loader.textures));
 		}
@@ -356,59 +363,76 @@ namespace core {
 			return renderPasses;
 		}
 
+		const BonePalette& getBonePalette() const {
+			return bonePalette;
+		}
+
 		void updateParticles(size_t animation_index, const AnimationTickArgs& tick) {
 			for (auto& particle : particleAdaptors) {
-				particle->update(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
+				particle->update(animation_index, tick, bonePalette);
+			}
+		}
+
+		// restart all particle emitters, each emitter draws from its own sequence derived from the seed and its index.
+		void resetParticles(uint64_t seed = 0) {
+			uint64_t stream = 0;
+			for (auto& particle : particleAdaptors) {
+				particle->reset(seed, stream++);
 			}
 		}
 
 		void updateRibbons(size_t animation_index, const AnimationTickArgs& tick) {
 			for (auto& ribbon : ribbonAdaptors) {
-				ribbon->update(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
+				ribbon->update(animation_index, tick, bonePalette);
 			}
 		}
 
+		// each call calculates one simulation step, see presentBones.
 		void calculateBones(size_t animation_index, const AnimationTickArgs& tick) {
-
-			const auto keybone_lookup_size = keyBoneLookup.size();
-			const auto bone_adaptor_size = boneAdaptors.size();
-
-			if (bone_adaptor_size == 0) {
+			if (boneAdaptors.size() == 0) {
 				return;
 			}
 
-			for (auto& bone : boneAdaptors) {
-				bone->resetCalculated();
-			}
+			bonePalette.beginStep();
+			trackEvaluator.calculate(animation_index, tick, getBoneAdaptors(), bonePalette);
+		}
 
-			//TODO check if char different logic?
-			if (keybone_lookup_size > KeyBones::BONE_ROOT) {
-				const auto keybone_val = keyBoneLookup.at(KeyBones::BONE_ROOT);
-				for (auto i = 0; i < keybone_val; i++) {
-					boneAdaptors[i]->calculateMatrix(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
-				}
+		// blend the bones between the last two calculated steps for display, until the next step is calculated.
+		void presentBones(float alpha) {
+			bonePalette.present(alpha);
+		}
 
-				const int32_t upper = std::ranges::min({
-					(int32_t)KeyBones::BONE_MAX,
-					(int32_t)(keybone_lookup_size - 1),
-					(int32_t)(bone_adaptor_size - 1)
-					});
+		// evaluate the color, transparency and texture animation tracks used by the render passes for the current frame.
+		void calculateMaterials(std::optional<size_t> animation_index, const AnimationTickArgs& tick) {
+			materialAnimation.calculate(animation_index, tick, getColorAdaptors(), getTransparencyAdaptors(), getTextureAnimationAdaptors());
+		}
 
-				for (int32_t i = KeyBones::BONE_ROOT; i < upper; i++) {
-					const auto keybone_val = keyBoneLookup.at(i);
-					if (keybone_val >= 0) {
-						boneAdaptors[i]->calculateMatrix(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
-					}
-				}
-			}
+		const MaterialAnimationState& getMaterialAnimation() const {
+			return materialAnimation;
+		}
+
+		// limit bone evaluation to the bones (and their ancestors) marked as required, an empty mask evaluates all bones.
+		void setRequiredBones(const std::vector<bool>& required) {
+			bonePalette.setRequired(required);
+		}
 
-			for (auto& bone : boneAdaptors) {
-				bone->calculateMatrix(animation_index, tick, reinterpret_cast<std::vector<ModelBoneAdaptor*>&>(boneAdaptors));
+		void calculateBones(const BakedAnimation& baked, const AnimationTickArgs& tick) {
+			if (boneAdaptors.size() == 0) {
+				return;
 			}
+
+			const auto& bones = getBoneAdaptors();
+			bonePalette.beginStep();
+			bonePalette.calculateWith([&](size_t bone_index, Matrix& local, Quaternion& rotation) -> bool {
+				return baked.calculateLocal(bone_index, bones[bone_index], tick, local, rotation);
+			});
 		}
 
 	protected:
 		std::vector<ModelRenderPass> renderPasses;
+		BonePalette bonePalette;
+		BoneTrackEvaluator trackEvaluator;
+		MaterialAnimationState materialAnimation;
 
 	private:
 		ModelPathInfo modelPathInfo;
@@ -0,0 +1,66 @@
+#include "../../stdafx.h"
+#include "MaterialAnimation.h"
+
+namespace core {
+
+	void MaterialAnimationState::calculate(std::optional<size_t> animation_index, const AnimationTickArgs& tick,
+		const std::vector<ModelColorAdaptor*>& colorAdaptors,
+		const std::vector<ModelTransparencyAdaptor*>& transparencyAdaptors,
+		const std::vector<ModelTextureAnimationAdaptor*>& textureAnimationAdaptors)
+	{
+		colors.resize(colorAdaptors.size());
+		colorUsed.resize(colorAdaptors.size());
+
+		for (size_t i = 0; i < colorAdaptors.size(); i++) {
+			const auto* adaptor = colorAdaptors[i];
+			auto& color = colors[i];
+
+			colorUsed[i] = adaptor->colorUses(0);
+			if (!colorUsed[i]) {
+				continue;
+			}
+
+			color.color = adaptor->colorValue(0, tick);
+			color.opacityAnimated = animation_index.has_value() && adaptor->opacityUses(animation_index.value());
+			color.opacity = color.opacityAnimated ? adaptor->opacityValue(animation_index.value(), tick) : 1.0f;
+		}
+
+		transparencies.resize(transparencyAdaptors.size());
+		transparencyUsed.resize(transparencyAdaptors.size());
+
+		for (size_t i = 0; i < transparencyAdaptors.size(); i++) {
+			const auto* adaptor = transparencyAdaptors[i];
+
+			transparencyUsed[i] = adaptor->transparencyUses(0);
+			transparencies[i] = transparencyUsed[i] ? adaptor->transparencyValue(0, tick) : 1.0f;
+		}
+
+		animated = animation_index.has_value();
+		textureAnimations.resize(animated ? textureAnimationAdaptors.size() : 0);
+
+		if (animated) {
+			const auto index = animation_index.value();
+
+			for (size_t i = 0; i < textureAnimationAdaptors.size(); i++) {
+				const auto* adaptor = textureAnimationAdaptors[i];
+				auto& anim = textureAnimations[i];
+
+				anim.translated = adaptor->translationUses(index);
+				anim.rotated = adaptor->rotationUses(index);
+				anim.scaled = adaptor->scaleUses(index);
+
+				if (anim.translated) {
+					anim.translation = adaptor->translationValue(index, tick);
+				}
+
+				if (anim.rotated) {
+					anim.rotation = adaptor->rotationValue(index, tick);
+				}
+
+				if (anim.scaled) {
+					anim.scale = adaptor->scaleValue(index, tick);
+				}
+			}
+		}
+	}
+}
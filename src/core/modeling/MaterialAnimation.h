@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "../utility/Vector3.h"
+#include "Animation.h"
+#include "ModelAdaptors.h"
+
+namespace core {
+
+	/// <summary>
+	/// Flat storage of the evaluated color, transparency and texture animation tracks of a model.
+	/// Tracks are evaluated once per frame, render passes then index the results rather than evaluating (often shared) tracks themselves.
+	/// </summary>
+	class MaterialAnimationState {
+	public:
+
+		struct Color {
+			Vector3 color;
+			float opacity = 1.0f;
+			bool opacityAnimated = false;
+		};
+
+		struct TextureAnimation {
+			Vector3 translation;
+			Vector3 rotation;
+			Vector3 scale;
+			bool translated = false;
+			bool rotated = false;
+			bool scaled = false;
+		};
+
+		MaterialAnimationState() = default;
+		MaterialAnimationState(MaterialAnimationState&&) = default;
+		MaterialAnimationState& operator=(MaterialAnimationState&&) = default;
+
+		// opacity and texture animations are only evaluated when an animation index is given, colors and transparency always use the first animation.
+		void calculate(std::optional<size_t> animation_index, const AnimationTickArgs& tick,
+			const std::vector<ModelColorAdaptor*>& colorAdaptors,
+			const std::vector<ModelTransparencyAdaptor*>& transparencyAdaptors,
+			const std::vector<ModelTextureAnimationAdaptor*>& textureAnimationAdaptors);
+
+		// returns nullptr when the index is invalid or the track is unused.
+		const Color* getColor(int16_t index) const {
+			return (index >= 0 && (size_t)index < colorUsed.size() && colorUsed[index]) ? &colors[index] : nullptr;
+		}
+
+		const float* getTransparency(int16_t index) const {
+			return (index >= 0 && (size_t)index < transparencyUsed.size() && transparencyUsed[index]) ? &transparencies[index] : nullptr;
+		}
+
+		const TextureAnimation* getTextureAnimation(int16_t index) const {
+			return (animated && index >= 0 && (size_t)index < textureAnimations.size()) ? &textureAnimations[index] : nullptr;
+		}
+
+	protected:
+		std::vector<Color> colors;
+		std::vector<uint8_t> colorUsed;
+
+		std::vector<float> transparencies;
+		std::vector<uint8_t> transparencyUsed;
+
+		std::vector<TextureAnimation> textureAnimations;
+
+		// texture animations only apply to passes rendered with an animation index.
+		bool animated = false;
+	};
+}
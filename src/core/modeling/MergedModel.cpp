@@ -7,7 +7,8 @@
 namespace core {
 
 	MergedModel::MergedModel(Model* _owner, Type _type, id_t _id) :
-		model(nullptr), owner(_owner), type(_type), id(_id), ComponentMeta(ComponentMeta::Type::MERGED)
+		model(nullptr), owner(_owner), type(_type), id(_id), ComponentMeta(ComponentMeta::Type::MERGED),
+		mappedBoneCount(0), ownerBoneCount(0)
 	{
 		assert(owner != nullptr);
 	}
@@ -26,76 +27,224 @@ namespace core {
 
 		initAnimationData(model.get());
 		initGeosetData(model.get(), false);
+
+		boneMap.assign(model->getBoneAdaptors().size(), -1);
+		mappedBoneCount = 0;
+		buildInfluences();
 	}
 
 	void MergedModel::merge(float resolution) {
 		// attempt to relate 'our' bones to the owner
-		uint16_t bone_index = 0;
-		uint16_t owner_bone_index = 0;
-		for (const auto* bone : model->getBoneAdaptors()) {
-			owner_bone_index = 0;
-			for (const auto* owner_bone : owner->model->getBoneAdaptors()) {
-				const auto max_pivot_diff = (bone->getPivot() - owner_bone->getPivot())
-					.abs()
-					.max();
-				const bool close_match = max_pivot_diff < resolution;
-
-				if (close_match) {
-					boneMap[bone_index] = owner_bone_index;
-					break;
+		// owner pivots are bucketed into a grid of 'resolution' sized cells, so only neighbouring cells need comparing.
+		const auto& owner_bones = owner->model->getBoneAdaptors();
+		const auto& bones = model->getBoneAdaptors();
+
+		// cells are 'resolution' wide, anything smaller than the finest resolution (or nan) is clamped rather than divided by.
+		if (!(resolution >= RESOLUTION_FINE)) {
+			resolution = RESOLUTION_FINE;
+		}
+
+		auto cell_of = [resolution](const Vector3& pivot) -> std::array<int32_t, 3> {
+			return {
+				(int32_t)std::floor(pivot.x / resolution),
+				(int32_t)std::floor(pivot.y / resolution),
+				(int32_t)std::floor(pivot.z / resolution)
+			};
+		};
+
+		auto cell_key = [](int32_t x, int32_t y, int32_t z) -> uint64_t {
+			return ((uint64_t)(uint32_t)x * 73856093u) ^ ((uint64_t)(uint32_t)y * 19349663u) ^ ((uint64_t)(uint32_t)z * 83492791u);
+		};
+
+		std::unordered_map<uint64_t, std::vector<uint16_t>> grid;
+		grid.reserve(owner_bones.size());
+
+		for (uint16_t owner_bone_index = 0; owner_bone_index < owner_bones.size(); owner_bone_index++) {
+			const auto cell = cell_of(owner_bones[owner_bone_index]->getPivot());
+			grid[cell_key(cell[0], cell[1], cell[2])].push_back(owner_bone_index);
+		}
+
+		boneMap.assign(bones.size(), -1);
+		mappedBoneCount = 0;
+
+		for (size_t bone_index = 0; bone_index < bones.size(); bone_index++) {
+			const auto& pivot = bones[bone_index]->getPivot();
+			const auto cell = cell_of(pivot);
+			int32_t match = -1;
+
+			for (int32_t x = cell[0] - 1; x <= cell[0] + 1; x++) {
+				for (int32_t y = cell[1] - 1; y <= cell[1] + 1; y++) {
+					for (int32_t z = cell[2] - 1; z <= cell[2] + 1; z++) {
+						auto found = grid.find(cell_key(x, y, z));
+						if (found == grid.end()) {
+							continue;
+						}
+
+						for (const auto owner_bone_index : found->second) {
+							const auto max_pivot_diff = (pivot - owner_bones[owner_bone_index]->getPivot())
+								.abs()
+								.max();
+
+							// lowest matching owner index wins, same as a linear search.
+							if (max_pivot_diff < resolution && (match < 0 || owner_bone_index < match)) {
+								match = owner_bone_index;
+							}
+						}
+					}
 				}
+			}
 
-				owner_bone_index++;
+			if (match > -1) {
+				boneMap[bone_index] = match;
+				mappedBoneCount++;
 			}
-			bone_index++;
 		}
+
+		buildInfluences();
 	}
 
-	void MergedModel::update(const Animator& animator, const AnimationTickArgs& tick)
+	void MergedModel::buildInfluences() {
+		const auto& vertices = model->getRawVertices();
+		ownerBoneCount = owner->model->getBoneAdaptors().size();
+
+		influences.clear();
+		influences.resize(vertices.size() * ModelVertexM2::BONE_COUNT, Influence{ 0, 0.0f });
+
+		size_t index = 0;
+		for (const auto& vertex : vertices) {
+			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++, index++) {
+				if (vertex.boneWeights[b] == 0) {
+					continue;
+				}
+
+				const auto bone_index = vertex.bones[b];
+				auto& influence = influences[index];
+				influence.weight = (float)vertex.boneWeights[b] / 255.0f;
+
+				if (bone_index < boneMap.size() && boneMap[bone_index] > -1) {
+					influence.bone = (uint16_t)boneMap[bone_index];
+				}
+				else {
+					influence.bone = (uint16_t)(ownerBoneCount + bone_index);
+				}
+			}
+		}
+
+		renewSkinningInputId();
+	}
+
+	void MergedModel::getSkinningInput(std::vector<SkinningVertex>& out) const
 	{
-		model->calculateBones(animator.getAnimationIndex().value(), tick);
+		ModelAnimationInfo::getSkinningInput(out);
+
+		for (size_t index = 0; index < out.size(); index++) {
+			const Influence* influence = &influences[index * ModelVertexM2::BONE_COUNT];
+
+			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++, influence++) {
+				out[index].bones[b] = influence->bone;
+				out[index].weights[b] = influence->weight;
+			}
+		}
+	}
+
+	void MergedModel::getSkinningPalette(std::vector<Matrix>& mat, std::vector<Matrix>& mrot) const
+	{
+		const auto& bones = model->getBonePalette();
+		const auto& owner_bones = owner->model->getBonePalette();
+
+		mat = owner_bones.getMatrices();
+		mat.insert(mat.end(), bones.getMatrices().begin(), bones.getMatrices().end());
+
+		mrot = owner_bones.getRotationMatrices();
+		mrot.insert(mrot.end(), bones.getRotationMatrices().begin(), bones.getRotationMatrices().end());
+	}
 
-		//updateAnimation(model.get());
-		// use an alternative implementation that can use the owner bones too.
-		updateAnimationWithOwner();
+	void MergedModel::step(const Animator& animator, const AnimationTickArgs& tick)
+	{
+		model->calculateBones(animator.getAnimationIndex().value(), tick);
 
 		model->updateParticles(animator.getAnimationIndex().value(), tick);
 		model->updateRibbons(animator.getAnimationIndex().value(), tick);
 	}
 
+	void MergedModel::present(float alpha)
+	{
+		model->presentBones(alpha);
+
+		presentSkinning();
+	}
+
+	void MergedModel::updateRequiredBones(std::vector<bool>& owner_required)
+	{
+		std::vector<bool> required(model->getBoneAdaptors().size(), false);
+		boneDependencies.collect(geosetState, required);
+
+		for (size_t bone_index = 0; bone_index < required.size(); bone_index++) {
+			if (!required[bone_index]) {
+				continue;
+			}
+
+			const auto mapped = boneMap[bone_index];
+			if (mapped > -1) {
+				if ((size_t)mapped < owner_required.size()) {
+					owner_required[mapped] = true;
+				}
+
+				// emitters still read from our own palette.
+				const auto& emitter_bones = boneDependencies.getEmitterBones();
+				required[bone_index] = std::find(emitter_bones.begin(), emitter_bones.end(), bone_index) != emitter_bones.end();
+			}
+		}
+
+		model->setRequiredBones(required);
+	}
+
 	void MergedModel::updateAnimationWithOwner() {
-		const auto& boneAdaptors = model->getBoneAdaptors();
+		if (!cpuSkinning) {
+			return;
+		}
+
+		const auto& bones = model->getBonePalette();
+		const auto& owner_bones = owner->model->getBonePalette();
 
-		if (boneAdaptors.size() == 0) {
+		if (bones.size() == 0) {
 			return;
 		}
 
-		auto index = 0;
-		for (auto& orgVert : model->getRawVertices()) {
-			Vector3 v = Vector3(0, 0, 0);
-			Vector3 n = Vector3(0, 0, 0);
+		assert(ownerBoneCount == owner_bones.size());
 
-			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++)
-			{
-				if (orgVert.boneWeights[b] > 0) {
-					const auto bone_index = orgVert.bones[b];
-					const ModelBoneAdaptor* adaptor = boneAdaptors[bone_index];
+		const auto& owner_mat = owner_bones.getMatrices();
+		const auto& owner_mrot = owner_bones.getRotationMatrices();
+		const auto& own_mat = bones.getMatrices();
+		const auto& own_mrot = bones.getRotationMatrices();
 
-					if (boneMap.contains(bone_index)) {
-						const auto mapped_index = boneMap[bone_index];
-						adaptor = owner->model->getBoneAdaptors().at(mapped_index);
-					}
+		const auto vertex_count = precomputed.size();
+
+		// only visible geosets are skinned, hidden vertices keep their last values.
+		for (const auto& range : visibleVertexRanges) {
+			const auto end = std::min<size_t>(range.start + range.count, vertex_count);
+
+			for (size_t index = range.start; index < end; index++) {
+				Vector3 v = Vector3(0, 0, 0);
+				Vector3 n = Vector3(0, 0, 0);
+				const Influence* influence = &influences[index * ModelVertexM2::BONE_COUNT];
+
+				for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++, influence++)
+				{
+					if (influence->weight > 0) {
+						const bool from_owner = influence->bone < ownerBoneCount;
+						const auto palette_index = from_owner ? influence->bone : influence->bone - ownerBoneCount;
+						const Matrix& mat = from_owner ? owner_mat[palette_index] : own_mat[palette_index];
+						const Matrix& mrot = from_owner ? owner_mrot[palette_index] : own_mrot[palette_index];
 
-					Vector3 tv = adaptor->getMat() * precomputed[index].position;
-					Vector3 tn = adaptor->getMRot() * precomputed[index].normal;
-					v += tv * ((float)orgVert.boneWeights[b] / 255.0f);
-					n += tn * ((float)orgVert.boneWeights[b] / 255.0f);
+						v += (mat * precomputed[index].position) * influence->weight;
+						n += (mrot * precomputed[index].normal) * influence->weight;
+					}
 				}
-			}
 
-			animatedVertices[index] = v;
-			animatedNormals[index] = n;
-			index++;
+				animatedVertices[index] = v;
+				animatedNormals[index] = n;
+			}
 		}
 	}
 };
\ No newline at end of file
@@ -39,7 +39,19 @@ namespace core {
 		void initialise(const GameFileUri& uri, M2Model::Factory& factory, GameFileSystem* fs, GameDatabase* db, TextureManager& manager);
 		void merge(float resolution);
 
-		void update(const Animator& animator, const AnimationTickArgs& tick);
+		// advance the simulation by a single fixed step.
+		void step(const Animator& animator, const AnimationTickArgs& tick);
+
+		// skin using bones blended between the last two steps, the owner must already be presenting.
+		void present(float alpha);
+
+		// restrict our bone evaluation to the visible geometry, bones mapped to the owner are marked in owner_required instead.
+		void updateRequiredBones(std::vector<bool>& owner_required);
+
+		void getSkinningInput(std::vector<SkinningVertex>& out) const override;
+
+		// owner palette followed by our own.
+		void getSkinningPalette(std::vector<Matrix>& mat, std::vector<Matrix>& mrot) const override;
 
 		Type getType() const {
 			return type;
@@ -60,13 +72,41 @@ namespace core {
 		std::unique_ptr<M2Model> model;
 		Model* owner;
 
-		//this model -> parent model, format
-		std::unordered_map<uint16_t, uint16_t> boneMap;
+		// owner bone matched to each of our bones, -1 when unmatched.
+		const std::vector<int32_t>& getBoneMap() const {
+			return boneMap;
+		}
+
+		size_t getMappedBoneCount() const {
+			return mappedBoneCount;
+		}
 
 	protected:
 
 		void updateAnimationWithOwner();
 
+		// use an alternative implementation that can use the owner bones too.
+		void skinPresented() override {
+			updateAnimationWithOwner();
+		}
+
+		// rebuild the per vertex influences against the combined owner + own palette.
+		void buildInfluences();
+
+		//this model -> parent model, format
+		std::vector<int32_t> boneMap;
+		size_t mappedBoneCount;
+
+		struct Influence {
+			// indices below ownerBoneCount refer to the owner palette, the rest to our own palette (offset by ownerBoneCount).
+			uint16_t bone;
+			float weight;
+		};
+
+		// ModelVertexM2::BONE_COUNT entries per vertex, unused entries have a weight of 0.
+		std::vector<Influence> influences;
+		size_t ownerBoneCount;
+
 	private:
 
 		// type and id are purely for wmvx usage, has no relation to any game file data.
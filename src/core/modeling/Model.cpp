@@ -12,6 +12,8 @@ namespace core {
 		animate = false;
 		model = nullptr;
 		characterInitialised = false;
+		bakeSampleRate = 0;
+		attachmentRevision = 0;
 	}
 
 	void Model::initialise(const GameFileUri& uri, M2Model::Factory& factory, GameFileSystem* fs, GameDatabase* db, TextureManager& manager)
@@ -48,43 +50,264 @@ namespace core {
 
 	}
 
-	void Model::update(uint32_t delta_time_msecs)
+	void Model::update(const FixedStepClock::Frame& frame)
 	{
+		updateProfiler.endFrame();
+
 		if (animate && animator.getAnimationId().has_value()) {
-			const AnimationTickArgs& tick = animator.tick(delta_time_msecs);
+			updateSelf(frame);
+
+			{
+				UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::ATTACHMENTS);
+				for (auto& child : attachments) {
+					for (const auto& tick : stepTicks) {
+						child->step(animator, tick);
+					}
+					child->present(frame.alpha);
+				}
+			}
+
+			{
+				UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::MERGED);
+				for (auto& rel : merged) {
+					for (const auto& tick : stepTicks) {
+						rel->step(animator, tick);
+					}
+					rel->present(frame.alpha);
+				}
+			}
+		}
+	}
+
+	void Model::update(const FixedStepClock::Frame& frame, JobGraph& jobs)
+	{
+		// jobs queued by the previous update have completed, so its timings are final.
+		updateProfiler.endFrame();
+
+		if (!animate || !animator.getAnimationId().has_value()) {
+			return;
+		}
+
+		const auto owner_job = jobs.add([this, frame]() {
+			updateSelf(frame);
+		});
+
+		const float alpha = frame.alpha;
+
+		for (auto& child : attachments) {
+			jobs.add([this, att = child.get(), alpha]() {
+				UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::ATTACHMENTS);
+				for (const auto& tick : stepTicks) {
+					att->stepModel(animator, tick);
+				}
+				att->presentModel(alpha);
+			}, { owner_job });
+
+			for (auto& effect : child->effects) {
+				jobs.add([this, eff = effect.get(), alpha]() {
+					UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::ATTACHMENTS);
+					for (const auto& tick : stepTicks) {
+						eff->step(animator, tick);
+					}
+					eff->present(alpha);
+				}, { owner_job });
+			}
+		}
+
+		for (auto& rel : merged) {
+			jobs.add([this, merged_model = rel.get(), alpha]() {
+				UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::MERGED);
+				for (const auto& tick : stepTicks) {
+					merged_model->step(animator, tick);
+				}
+				merged_model->present(alpha);
+			}, { owner_job });
+		}
+	}
+
+	void Model::updateSelf(const FixedStepClock::Frame& frame)
+	{
+		const auto animation_index = animator.getAnimationIndex().value();
+
+		stepTicks.clear();
+		updateRequiredBones();
+
+		for (uint32_t i = 0; i < frame.steps; i++) {
+			const AnimationTickArgs& tick = animator.tick(frame.stepMsecs);
+			stepTicks.emplace_back(tick.currentFrame, tick.deltaTime, tick.absoluteTime);
+
+			{
+				UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::BONES);
+
+				const auto* baked = getBakedAnimation(animation_index);
+				if (baked != nullptr) {
+					model->calculateBones(*baked, tick);
+				}
+				else {
+					model->calculateBones(animation_index, tick);
+				}
+			}
+
+			{
+				UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::PARTICLES);
+				model->updateParticles(animation_index, tick);
+			}
+
+			{
+				UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::RIBBONS);
+				model->updateRibbons(animation_index, tick);
+			}
+		}
+
+		{
+			// skinned once per frame regardless of the step count.
+			UpdateProfiler::ScopedTimer timer(updateProfiler, (size_t)UpdatePhase::SKINNING);
+			model->presentBones(frame.alpha);
+			// culled models keep their last skinned vertices until the renderer finds them visible, see ensureSkinned.
+			presentSkinning();
+		}
+	}
+
+	const char* Model::getUpdatePhaseName(UpdatePhase phase)
+	{
+		switch (phase) {
+		case UpdatePhase::BONES:
+			return "Bones";
+		case UpdatePhase::SKINNING:
+			return "Skinning";
+		case UpdatePhase::PARTICLES:
+			return "Particles";
+		case UpdatePhase::RIBBONS:
+			return "Ribbons";
+		case UpdatePhase::ATTACHMENTS:
+			return "Attachments";
+		case UpdatePhase::MERGED:
+			return "Merged";
+		default:
+			return "Unknown";
+		}
+	}
+
+	const BakedAnimation* Model::getBakedAnimation(size_t animation_index)
+	{
+		if (bakeSampleRate == 0 || model == nullptr) {
+			return nullptr;
+		}
 
-			model->calculateBones(animator.getAnimationIndex().value(), tick);
-			updateAnimation();
+		auto found = bakedAnimations.find(animation_index);
+		if (found != bakedAnimations.end()) {
+			return found->second.get();
+		}
+
+		const auto& sequences = model->getModelAnimationSequenceAdaptors();
+		if (animation_index >= sequences.size()) {
+			return nullptr;
+		}
+
+		auto baked = BakedAnimation::bake(model->getBoneAdaptors(), animation_index, sequences[animation_index]->getDuration(), bakeSampleRate);
+		const auto* result = baked.get();
+		bakedAnimations.emplace(animation_index, std::move(baked));
+
+		return result;
+	}
+
+	void Model::setCpuSkinning(bool enabled)
+	{
+		cpuSkinning = enabled;
 
-			model->updateParticles(animator.getAnimationIndex().value(), tick);
-			model->updateRibbons(animator.getAnimationIndex().value(), tick);
+		for (auto& att : attachments) {
+			att->visit<Attachment::AttachOwnedModel>([&](Attachment::AttachOwnedModel* owned) {
+				owned->cpuSkinning = enabled;
+			});
 
-			for (auto& child : attachments) {
-				child->update(animator, tick);
+			for (auto& effect : att->effects) {
+				effect->cpuSkinning = enabled;
 			}
+		}
 
+		for (auto& rel : merged) {
+			rel->cpuSkinning = enabled;
+		}
+	}
+
+	void Model::updateRequiredBones()
+	{
+		std::vector<uint64_t> signature;
+		signature.reserve(4 + (merged.size() * 3));
+		signature.push_back(geosetState.getRevision());
+		signature.push_back(attachmentRevision);
+		signature.push_back(renderOptions.showBones ? 1 : 0);
+		signature.push_back(merged.size());
+
+		for (const auto& rel : merged) {
+			signature.push_back(rel->getId());
+			signature.push_back(rel->getGeosetState().getRevision());
+			signature.push_back(rel->getMappedBoneCount());
+		}
+
+		if (signature == requiredBonesSignature) {
+			return;
+		}
+
+		requiredBonesSignature = std::move(signature);
+
+		if (renderOptions.showBones) {
+			// debug rendering needs the whole skeleton.
+			model->setRequiredBones({});
 			for (auto& rel : merged) {
-				rel->update(animator, tick);
+				rel->model->setRequiredBones({});
 			}
+			return;
 		}
+
+		std::vector<bool> required(model->getBoneAdaptors().size(), false);
+		boneDependencies.collect(geosetState, required);
+
+		for (const auto& att : attachments) {
+			att->visit<Attachment::AttachOwnedModel>([&](Attachment::AttachOwnedModel* owned) {
+				if (owned->bone < required.size()) {
+					required[owned->bone] = true;
+				}
+			});
+		}
+
+		for (auto& rel : merged) {
+			rel->updateRequiredBones(required);
+		}
+
+		model->setRequiredBones(required);
 	}
 
 	void ModelHelper::addItem(CharacterSlot slot, const core::CharacterItemWrapper& wrapper, std::function<void(Attachment*, uint32_t)> visual_handler) {
 		assert(_attach_provider != nullptr);
-		//TODO only update if needed - currenlty item gets removed and re-added even if no changes are needed.
-		_model->removeAttachments(slot);
 
 		const auto attach_positions = _attach_provider->getAttachmentPositions(slot, wrapper.item(), _model->characterOptions.sheatheWeapons);
 
 		const auto* item_display = wrapper.display();
 		const auto& char_details = _model->getCharacterDetails();
 
-		auto attachment_index = 0;
 		const auto item_models = item_display->getModel(slot, wrapper.item()->getInventorySlotId(), *_model_context);
 		const auto item_textures = item_display->getModelTexture(slot, wrapper.item()->getInventorySlotId(), *_texture_context);
 		assert(item_models.size() >= attach_positions.size());
 		assert(item_textures.size() >= attach_positions.size());
 
+		//TODO move into attachment provider.
+		//TODO handle item visuals for BFA+
+		const auto itemVisualId = item_display->getItemVisualId();
+		// effects are only recorded when they have been applied.
+		const uint32_t applied_visual_id = visual_handler ? itemVisualId : 0;
+
+		struct Request {
+			AttachmentPosition position;
+			GameFileUri model;
+			GameFileUri texture;
+			Attachment* attachment;
+		};
+
+		std::vector<Request> requests;
+		requests.reserve(attach_positions.size());
+
+		auto attachment_index = 0;
 		for (auto attach_pos : attach_positions) {
 
 			GameFileUri model_path = item_models[attachment_index];
@@ -98,28 +321,70 @@ namespace core {
 				model_path = GameFileUri::replaceExtension(model_path.getPath(), "m2");
 			}
 
+			requests.push_back({ attach_pos, model_path, texture_path, nullptr });
+			attachment_index++;
+		}
+
+		// match the requested models against what is already attached to the slot, only changes get loaded.
+		std::vector<Attachment*> existing;
+		for (auto* att : _model->getAttachments()) {
+			if (att->getSlot() == slot) {
+				existing.push_back(att);
+			}
+		}
+
+		for (auto& request : requests) {
+			for (auto& att : existing) {
+				if (att != nullptr && _attach_provider->updateAttachment(att, request.position, wrapper, request.model, request.texture, _model, _scene)) {
+					request.attachment = att;
+					att = nullptr;
+					break;
+				}
+			}
+		}
+
+		// stale attachments are removed before loading, so replacements dont collide with their positions or merged ids.
+		for (auto* att : existing) {
+			if (att != nullptr) {
+				_model->removeAttachment(att);
+			}
+		}
+
+		attachment_index = 0;
+		for (auto& request : requests) {
+
 			try {
+				Attachment* att = request.attachment;
+				std::unique_ptr<Attachment> created;
+
+				if (att != nullptr) {
+					Log::message("Reused attachment model: " + request.model.toString());
 
-				Log::message("Loaded attachment model: " + model_path.toString());
-				Log::message("Loaded attachment texture: " + texture_path.toString());
-
-				std::unique_ptr<Attachment> att = _attach_provider->makeAttachment(
-					slot,
-					attach_pos,
-					wrapper,
-					model_path,
-					texture_path,
-					_model,
-					_scene
-				);
-
-				//TODO move into attachment provider.
-				//TODO handle item visuals for BFA+
-				const auto itemVisualId = item_display->getItemVisualId();
-
-				if (itemVisualId > 0 && visual_handler) {
-					visual_handler(att.get(), itemVisualId);
+					if (att->itemVisualId != applied_visual_id) {
+						att->effects.clear();
+					}
 				}
+				else {
+					Log::message("Loaded attachment model: " + request.model.toString());
+					Log::message("Loaded attachment texture: " + request.texture.toString());
+
+					created = _attach_provider->makeAttachment(
+						slot,
+						request.position,
+						wrapper,
+						request.model,
+						request.texture,
+						_model,
+						_scene
+					);
+
+					att = created.get();
+				}
+
+				if (applied_visual_id > 0 && att->itemVisualId != applied_visual_id) {
+					visual_handler(att, applied_visual_id);
+				}
+				att->itemVisualId = applied_visual_id;
 
 				QString display_name = wrapper.item()->getName();
 				if (display_name.length() > 0) {
@@ -130,11 +395,9 @@ namespace core {
 					);
 				}
 
-
-				{
-					auto* tmp = att.get();
-					_model->addAttachment(std::move(att));
-					_scene->addComponent(tmp);
+				if (created != nullptr) {
+					_model->addAttachment(std::move(created));
+					_scene->addComponent(att);
 				}
 
 			}
@@ -10,6 +10,10 @@
 #include "TabardCustomization.h"
 #include "TextureSet.h"
 #include "ComponentMeta.h"
+#include "BakedAnimation.h"
+#include "../utility/JobGraph.h"
+#include "../utility/Profiler.h"
+#include "../utility/FixedStepClock.h"
 
 
 namespace core {
@@ -134,10 +138,50 @@ namespace core {
 
 		void initialise(const GameFileUri& uri, M2Model::Factory& factory, GameFileSystem* fs, GameDatabase* db, TextureManager& manager);
 
-		void update(uint32_t delta_time_msecs);
+		// run the frame's fixed simulation steps, then skin with bones blended by the frame alpha.
+		void update(const FixedStepClock::Frame& frame);
 
+		// queue the update onto the job graph, attachments, effects and merged models run once the owner bones are calculated.
+		void update(const FixedStepClock::Frame& frame, JobGraph& jobs);
+
+		// sample rate (per second) used for baked bone playback, 0 evaluates the bone tracks live.
+		void setBakeSampleRate(uint32_t rate) {
+			if (bakeSampleRate != rate) {
+				bakeSampleRate = rate;
+				bakedAnimations.clear();
+			}
+		}
+
+		uint32_t getBakeSampleRate() const {
+			return bakeSampleRate;
+		}
+
+		// baked data for the animation, baked on first use. returns nullptr when baking is disabled.
+		const BakedAnimation* getBakedAnimation(size_t animation_index);
+
+		// applies to the attachments, effects and merged models too, disabled when the renderer skins on the gpu.
+		void setCpuSkinning(bool enabled);
+
+		enum class UpdatePhase : size_t {
+			BONES,
+			SKINNING,
+			PARTICLES,
+			RIBBONS,
+			// attachment models and their effects.
+			ATTACHMENTS,
+			MERGED,
+			COUNT
+		};
+
+		using UpdateProfiler = PhaseProfiler<(size_t)UpdatePhase::COUNT>;
+
+		// rolling cpu time of each update phase, a frame is committed at the start of every update.
+		const UpdateProfiler& getUpdateProfiler() const {
+			return updateProfiler;
+		}
+
+		static const char* getUpdatePhaseName(UpdatePhase phase);
 
-		
 
 		std::unique_ptr<M2Model> model;
 		TextureSet textureSet;
@@ -189,6 +233,7 @@ namespace core {
 			});
 
 			attachments.push_back(std::move(attachment));
+			attachmentRevision++;
 		}
 
 
@@ -196,9 +241,17 @@ namespace core {
 			std::erase_if(attachments, [&, slot](const std::unique_ptr<Attachment>& att) -> bool {
 				return att->getSlot() == slot;
 			});
+			attachmentRevision++;
 		}
 
-		void setAttachmentPosition(Attachment* attachment, AttachmentPosition position) const {
+		void removeAttachment(const Attachment* attachment) {
+			std::erase_if(attachments, [attachment](const std::unique_ptr<Attachment>& att) -> bool {
+				return att.get() == attachment;
+			});
+			attachmentRevision++;
+		}
+
+		void setAttachmentPosition(Attachment* attachment, AttachmentPosition position) {
 
 			if (position >= AttachmentPosition::MAX) {
 				throw std::runtime_error("Attachment position not valid.");
@@ -212,6 +265,7 @@ namespace core {
 				attachDef->getBone(), 
 				Vector3::yUpToZUp(attachDef->getPosition())
 			);
+			attachmentRevision++;
 		}
 
 		const std::optional<CharacterDetails>& getCharacterDetails() const {
@@ -232,6 +286,27 @@ namespace core {
 		std::vector<std::unique_ptr<Attachment>> attachments;
 		std::optional<CharacterDetails> characterDetails;
 
+		uint32_t bakeSampleRate;
+		std::map<size_t, std::unique_ptr<BakedAnimation>> bakedAnimations;
+
+		// update of the model itself, excluding attachments and merged models.
+		void updateSelf(const FixedStepClock::Frame& frame);
+
+		void skinPresented() override {
+			updateAnimation(getVisibleVertexRanges());
+		}
+
+		// ticks of the steps taken by the last updateSelf, replayed by attachments, effects and merged models.
+		std::vector<AnimationTickArgs> stepTicks;
+
+		// recalculates which bones need evaluating, only when geosets, attachments or merges have changed.
+		void updateRequiredBones();
+
+		uint32_t attachmentRevision;
+		std::vector<uint64_t> requiredBonesSignature;
+
+		UpdateProfiler updateProfiler;
+
 	};
 
 	class Scene;
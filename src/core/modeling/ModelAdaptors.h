@@ -4,11 +4,15 @@
 #include "../utility/Vector3.h"
 #include "../utility/Vector2.h"
 #include "../utility/Matrix.h"
+#include "../utility/Math.h"
 #include "Animation.h"
 #include "Texture.h"
 #include "../utility/Memory.h"
 
 namespace core {
+
+	class BonePalette;
+
 	class ModelGeosetAdaptor {
 	public:
 
@@ -98,17 +102,31 @@ namespace core {
 		virtual const IAnimatedValue<Quaternion>* getRotation() const = 0;
 		virtual const IAnimatedValue<Vector3>* getScale() const = 0;
 
-		virtual void calculateMatrix(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) = 0;
+		// calculates the bone transform relative to its parent, returns true if the bone is rotated (rotation will be set).
+		virtual bool calculateLocal(size_t animation_index, const AnimationTickArgs& tick, Matrix& local, Quaternion& rotation) const = 0;
 
-		virtual const Matrix& getMat() const = 0;
-		virtual const Matrix& getMRot() const = 0;
-
-		virtual const Vector3& getTranslationPivot() const = 0;
 		virtual const Vector3& getPivot() const = 0;
 
 		virtual int16_t getParentBoneId() const = 0;
 
-		virtual void resetCalculated() = 0;
+		// build a parent-relative transform around the pivot, null components are skipped.
+		static void composeLocal(const Vector3& pivot, const Vector3* translation, const Quaternion* rotation, const Vector3* scale, Matrix& local) {
+			local.translation(pivot);
+
+			if (translation != nullptr) {
+				local *= Matrix::newTranslation(*translation);
+			}
+
+			if (rotation != nullptr) {
+				local *= Matrix::newQuatRotate(*rotation);
+			}
+
+			if (scale != nullptr) {
+				local *= Matrix::newScale(*scale);
+			}
+
+			local *= Matrix::newTranslation(pivot * -1.0f);
+		}
 	};
 
 
@@ -119,17 +137,25 @@ namespace core {
 			Vector3 position;
 			Vector3 up;
 			Vector3 back;
-			float len, len0;
+			float len = 0.0f;
+			float len0 = 0.0f;
+		};
+
+		struct RibbonVertex {
+			Vector3 position;
+			Vector2 texCoords;
 		};
 
 		ModelRibbonEmitterAdaptor() = default;
 		ModelRibbonEmitterAdaptor(ModelRibbonEmitterAdaptor&&) = default;
 		virtual ~ModelRibbonEmitterAdaptor() {}
 
-		virtual void update(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) = 0;
+		virtual void update(size_t animation_index, const AnimationTickArgs& tick, const BonePalette& bones) = 0;
 
 		virtual const std::vector<uint16_t> getTexture() const = 0;
 
+		constexpr virtual uint16_t getBone() const = 0;
+
 		virtual const Vector4& getTColor() const = 0;
 
 		virtual float getLength() const = 0;
@@ -138,7 +164,10 @@ namespace core {
 
 		virtual float getTBelow() const = 0;
 
-		virtual const std::list<RibbonSegment>& getSegments() const = 0;
+		virtual size_t getSegmentCount() const = 0;
+
+		// triangle strip covering all segments, rebuilt on each update.
+		virtual const std::vector<RibbonVertex>& getStrip() const = 0;
 	};
 
 	class ModelParticleEmitterAdaptor {
@@ -167,7 +196,13 @@ namespace core {
 
 		virtual const std::list<Particle>& getParticles() const = 0;
 
-		virtual void update(size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones) = 0;
+		virtual void update(size_t animation_index, const AnimationTickArgs& tick, const BonePalette& bones) = 0;
+
+		// clears live particles and restarts the random sequence, emitters given the same seed and stream spawn identical particles.
+		virtual void reset(uint64_t seed, uint64_t stream) = 0;
+
+		// per emitter generator, used when spawning particles.
+		virtual RandomGenerator& getRandom() = 0;
 
 		virtual const Vector3& getPosition() const = 0;
 
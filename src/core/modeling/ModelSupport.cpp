@@ -1,5 +1,7 @@
 #include "../../stdafx.h"
 #include "ModelSupport.h"
+#include <algorithm>
+#include <atomic>
 
 namespace core {
 
@@ -44,27 +46,49 @@ namespace core {
 				Vector3::yUpToZUp(orgVert.normal).normalize()
 			);
 		}
+
+		renewSkinningInputId();
 	}
 
 	void ModelAnimationInfo::updateAnimation() {
+		if (!cpuSkinning) {
+			return;
+		}
 
-		const auto& boneAdaptors = model->getBoneAdaptors();
+		updateAnimation(0, model->getRawVertices().size());
+	}
 
-		if (boneAdaptors.size() == 0) {
+	void ModelAnimationInfo::updateAnimation(const std::vector<GeosetVertexRange>& ranges) {
+		if (!cpuSkinning) {
 			return;
 		}
 
-		auto index = 0;
-		for (auto& orgVert : model->getRawVertices()) {
+		for (const auto& range : ranges) {
+			updateAnimation(range.start, std::min<size_t>(range.start + range.count, model->getRawVertices().size()));
+		}
+	}
+
+	void ModelAnimationInfo::updateAnimation(size_t start, size_t end) {
+
+		const auto& bones = model->getBonePalette();
+
+		if (bones.size() == 0) {
+			return;
+		}
+
+		const auto& raw_vertices = model->getRawVertices();
+
+		for (size_t index = start; index < end; index++) {
+			const auto& orgVert = raw_vertices[index];
 			Vector3 v = Vector3(0, 0, 0);
 			Vector3 n = Vector3(0, 0, 0);
 
 			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++)
 			{
 				if (orgVert.boneWeights[b] > 0) {
-					const auto& adaptor = boneAdaptors[orgVert.bones[b]];
-					Vector3 tv = adaptor->getMat() * precomputed[index].position; 
-					Vector3 tn = adaptor->getMRot() * precomputed[index].normal;
+					const auto bone_index = orgVert.bones[b];
+					Vector3 tv = bones.getMat(bone_index) * precomputed[index].position; 
+					Vector3 tn = bones.getMRot(bone_index) * precomputed[index].normal;
 					v += tv * ((float)orgVert.boneWeights[b] / 255.0f);
 					n += tn * ((float)orgVert.boneWeights[b] / 255.0f);
 				}
@@ -72,12 +96,196 @@ namespace core {
 
 			animatedVertices[index] = v;
 			animatedNormals[index] = n;
-			index++;
 		}
 	}
 
+	void ModelAnimationInfo::getSkinningInput(std::vector<SkinningVertex>& out) const {
+		const auto& raw_vertices = model->getRawVertices();
+		out.resize(raw_vertices.size());
+
+		for (size_t index = 0; index < raw_vertices.size(); index++) {
+			const auto& orgVert = raw_vertices[index];
+			auto& vertex = out[index];
+
+			vertex.position = precomputed[index].position;
+			vertex.normal = precomputed[index].normal;
+			vertex.textureCoords = orgVert.textureCoords;
+
+			for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++) {
+				vertex.bones[b] = orgVert.bones[b];
+				vertex.weights[b] = (float)orgVert.boneWeights[b] / 255.0f;
+			}
+		}
+	}
+
+	void ModelAnimationInfo::getSkinningPalette(std::vector<Matrix>& mat, std::vector<Matrix>& mrot) const {
+		const auto& bones = model->getBonePalette();
+		mat = bones.getMatrices();
+		mrot = bones.getRotationMatrices();
+	}
+
+	bool ModelAnimationInfo::updateBounds() {
+		if (bindBoundsInputId != skinningInputId) {
+			buildBindBounds();
+			bindBoundsInputId = skinningInputId;
+		}
+
+		getSkinningPalette(boundsPalette, boundsRotations);
+		const auto& mat = boundsPalette;
+
+		geosetBounds.resize(bindBounds.size());
+		bounds = BoundingSphere();
+
+		for (size_t i = 0; i < bindBounds.size(); i++) {
+			const auto& bind = bindBounds[i];
+			auto& posed = geosetBounds[i];
+			posed = BoundingSphere();
+
+			// skinned positions are weighted averages of the positions each bone gives,
+			// so the sphere enclosing the geoset moved by each of its bones encloses the skinned geoset.
+			for (const auto bone : bind.bones) {
+				if (bone >= mat.size()) {
+					continue;
+				}
+
+				const auto& m = mat[bone];
+				float scale = 0.0f;
+				for (size_t col = 0; col < 3; col++) {
+					scale = std::max(scale, std::sqrt((m.m[0][col] * m.m[0][col]) + (m.m[1][col] * m.m[1][col]) + (m.m[2][col] * m.m[2][col])));
+				}
+
+				BoundingSphere moved;
+				moved.center = m * bind.sphere.center;
+				moved.radius = bind.sphere.radius * scale;
+				posed.merge(moved);
+			}
+
+			bounds.merge(posed);
+		}
+
+		if (!viewFrustum.has_value() || bounds.isEmpty()) {
+			return true;
+		}
+
+		return viewFrustum->intersects(bounds);
+	}
+
+	void ModelAnimationInfo::presentSkinning() {
+		skinningStale = !updateBounds();
+		if (!skinningStale) {
+			skinPresented();
+		}
+	}
+
+	void ModelAnimationInfo::ensureSkinned() {
+		if (skinningStale) {
+			skinPresented();
+			skinningStale = false;
+		}
+	}
+
+	void ModelAnimationInfo::buildBindBounds() {
+		bindBounds.clear();
+
+		std::vector<SkinningVertex> vertices;
+		getSkinningInput(vertices);
+
+		const auto& geosets = model->getGeosetAdaptors();
+		bindBounds.resize(geosets.size());
+
+		for (size_t i = 0; i < geosets.size(); i++) {
+			const size_t start = std::min<size_t>(geosets[i]->getVertexStart(), vertices.size());
+			const size_t end = std::min<size_t>(start + geosets[i]->getVertexCount(), vertices.size());
+
+			if (start == end) {
+				continue;
+			}
+
+			auto& bind = bindBounds[i];
+
+			Vector3 min = vertices[start].position;
+			Vector3 max = vertices[start].position;
+			for (size_t v = start; v < end; v++) {
+				const auto& position = vertices[v].position;
+				min = Vector3(std::min(min.x, position.x), std::min(min.y, position.y), std::min(min.z, position.z));
+				max = Vector3(std::max(max.x, position.x), std::max(max.y, position.y), std::max(max.z, position.z));
+
+				for (size_t b = 0; b < ModelVertexM2::BONE_COUNT; b++) {
+					if (vertices[v].weights[b] > 0.0f) {
+						bind.bones.push_back((uint16_t)vertices[v].bones[b]);
+					}
+				}
+			}
+
+			bind.sphere.center = (min + max) * 0.5f;
+			bind.sphere.radius = 0.0f;
+			for (size_t v = start; v < end; v++) {
+				bind.sphere.radius = std::max(bind.sphere.radius, (vertices[v].position - bind.sphere.center).length());
+			}
+
+			std::sort(bind.bones.begin(), bind.bones.end());
+			bind.bones.erase(std::unique(bind.bones.begin(), bind.bones.end()), bind.bones.end());
+		}
+	}
+
+	void ModelAnimationInfo::renewSkinningInputId() {
+		static std::atomic<uint64_t> next_id = 1;
+		skinningInputId = next_id++;
+	}
+
 	void ModelGeosetInfo::initGeosetData(const M2Model* _model, bool default_vis) {
+		geosetModel = _model;
 		geosetState.init(_model, default_vis);
+		boneDependencies.init(_model);
+		updateVisibleLists();
+	}
+
+	void ModelGeosetInfo::updateGeosets() {
+		if (geosetTransform.apply(geosetState)) {
+			updateVisibleLists();
+		}
+	}
+
+	void ModelGeosetInfo::updateVisibleLists() {
+		visiblePasses.clear();
+		visibleVertexRanges.clear();
+
+		if (geosetModel == nullptr) {
+			return;
+		}
+
+		const auto& passes = geosetModel->getRenderPasses();
+		for (uint32_t i = 0; i < passes.size(); i++) {
+			if (geosetState.indexVisible(passes[i].geosetIndex)) {
+				visiblePasses.push_back(i);
+			}
+		}
+
+		const auto& geosets = geosetModel->getGeosetAdaptors();
+		for (uint32_t i = 0; i < geosets.size(); i++) {
+			if (geosetState.indexVisible(i) && geosets[i]->getVertexCount() > 0) {
+				visibleVertexRanges.push_back({ geosets[i]->getVertexStart(), geosets[i]->getVertexCount() });
+			}
+		}
+
+		std::sort(visibleVertexRanges.begin(), visibleVertexRanges.end(), [](const auto& a, const auto& b) {
+			return a.start < b.start;
+		});
+
+		// join touching or overlapping ranges, so skinning walks each vertex once.
+		std::vector<GeosetVertexRange> merged;
+		merged.reserve(visibleVertexRanges.size());
+		for (const auto& range : visibleVertexRanges) {
+			if (!merged.empty() && range.start <= merged.back().start + merged.back().count) {
+				auto& last = merged.back();
+				last.count = std::max(last.start + last.count, range.start + range.count) - last.start;
+			}
+			else {
+				merged.push_back(range);
+			}
+		}
+
+		visibleVertexRanges = std::move(merged);
 	}
 
 }
\ No newline at end of file
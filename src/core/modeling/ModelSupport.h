@@ -3,7 +3,10 @@
 #include <optional>
 #include <map>
 #include <vector>
+#include "../utility/Vector2.h"
 #include "../utility/Vector3.h"
+#include "../utility/Matrix.h"
+#include "../utility/Frustum.h"
 #include "../game/GameConstants.h"
 #include "../filesystem/GameFileSystem.h"
 #include "Texture.h"
@@ -11,6 +14,7 @@
 #include "../database/GameDatasetAdaptors.h"
 #include "../modeling/M2.h"
 #include "../modeling/Geoset.h"
+#include "../modeling/BoneDependencies.h"
 
 namespace core {
 
@@ -82,6 +86,15 @@ namespace core {
 
 	};
 
+	// bind pose vertex and the palette entries influencing it, the static input used when skinning on the gpu.
+	struct SkinningVertex {
+		Vector3 position;
+		Vector3 normal;
+		Vector2 textureCoords;
+		float bones[ModelVertexM2::BONE_COUNT];
+		float weights[ModelVertexM2::BONE_COUNT];
+	};
+
 	class ModelAnimationInfo {
 	public:
 		ModelAnimationInfo() = default;
@@ -91,11 +104,53 @@ namespace core {
 		std::vector<Vector3> animatedVertices;
 		std::vector<Vector3> animatedNormals;
 
+		// when false updateAnimation is skipped, the renderer skins from the bone palette itself.
+		bool cpuSkinning = true;
+
 		void initAnimationData(const M2Model* model);
 
 		void updateAnimation();
 
+		// skin only the given vertex ranges, vertices outside of them keep their previous values.
+		void updateAnimation(const std::vector<GeosetVertexRange>& ranges);
+
+		// changes whenever the skinning input does, so data derived from it can be cached.
+		uint64_t getSkinningInputId() const {
+			return skinningInputId;
+		}
+
+		virtual void getSkinningInput(std::vector<SkinningVertex>& out) const;
+
+		// palette indexed by SkinningVertex::bones.
+		virtual void getSkinningPalette(std::vector<Matrix>& mat, std::vector<Matrix>& mrot) const;
+
+		// bounds of each geoset (indexed as the model geosets) and of the whole component, posed by the current palette.
+		std::vector<BoundingSphere> geosetBounds;
+		BoundingSphere bounds;
+
+		// set by the renderer from the last frame drawn, in the space of the component.
+		// when empty nothing is culled.
+		std::optional<Frustum> viewFrustum;
+
+		// pose the bounds with the current palette, returns false when they are outside the view frustum and skinning can be skipped.
+		bool updateBounds();
+
+		// pose the bounds, then skin unless the component is outside the view frustum.
+		void presentSkinning();
+
+		// the view frustum is from the previous frame, so a component culled by it can still be visible in the next.
+		// the renderer calls this before drawing a component, skinning it if its last present was culled.
+		void ensureSkinned();
+
 	protected:
+		// skins the vertices that are drawn, all of them unless overridden.
+		virtual void skinPresented() {
+			updateAnimation();
+		}
+
+		// set when presentSkinning skipped skinning, until the component is skinned.
+		bool skinningStale = false;
+
 		struct VertData {
 			Vector3 position;
 			Vector3 normal;
@@ -103,6 +158,29 @@ namespace core {
 
 		//purely for speed, we convert the data from raw format and store for use.
 		std::vector<VertData> precomputed;
+
+		void updateAnimation(size_t start, size_t end);
+
+		void renewSkinningInputId();
+
+		uint64_t skinningInputId = 0;
+
+		// bind pose bounds of a geoset, and the palette entries that can move it.
+		struct GeosetBindBounds {
+			BoundingSphere sphere;
+			std::vector<uint16_t> bones;
+		};
+
+		// rebuilt when the skinning input changes.
+		std::vector<GeosetBindBounds> bindBounds;
+		uint64_t bindBoundsInputId = 0;
+
+		void buildBindBounds();
+
+		// scratch space for updateBounds.
+		std::vector<Matrix> boundsPalette;
+		std::vector<Matrix> boundsRotations;
+
 	private:
 		const M2Model* model;
 	};
@@ -123,12 +201,31 @@ namespace core {
 			return geosetTransform;
 		}
 
-		void updateGeosets() {
-			geosetTransform.apply(geosetState);
+		void updateGeosets();
+
+		const BoneDependencies& getBoneDependencies() const {
+			return boneDependencies;
+		}
+
+		// indices of the render passes belonging to visible geosets, in render pass order.
+		const std::vector<uint32_t>& getVisiblePasses() const {
+			return visiblePasses;
+		}
+
+		// merged vertex ranges of the visible geosets, sorted by start.
+		const std::vector<GeosetVertexRange>& getVisibleVertexRanges() const {
+			return visibleVertexRanges;
 		}
 
 		protected:
 			GeosetState geosetState;
 			GeosetTransform geosetTransform;
+			BoneDependencies boneDependencies;
+
+			const M2Model* geosetModel = nullptr;
+			std::vector<uint32_t> visiblePasses;
+			std::vector<GeosetVertexRange> visibleVertexRanges;
+
+			void updateVisibleLists();
 	};
 };
\ No newline at end of file
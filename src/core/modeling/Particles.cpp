@@ -3,16 +3,17 @@
 
 namespace core {
 
-	void CalcSpreadMatrix(float Spread1, float Spread2, float w, float l)
+	Matrix CalcSpreadMatrix(RandomGenerator& random, float Spread1, float Spread2, float w, float l)
 	{
 		int i, j;
 		float a[2], c[2], s[2];
 		Matrix	Temp;
+		Matrix	SpreadMat;
 
 		SpreadMat.unit();
 
-		a[0] = Random::between(-Spread1, Spread1) / 2.0f;
-		a[1] = Random::between(-Spread2, Spread2) / 2.0f;
+		a[0] = random.between(-Spread1, Spread1) / 2.0f;
+		a[1] = random.between(-Spread2, Spread2) / 2.0f;
 
 		/*SpreadMat.m[0][0]*=l;
 		SpreadMat.m[1][1]*=l;
@@ -43,10 +44,12 @@ namespace core {
 		for (i = 0; i < 3; i++)
 			for (j = 0; j < 3; j++)
 				SpreadMat.m[i][j] *= Size;
+
+		return SpreadMat;
 	}
 
 	ModelParticleEmitterAdaptor::Particle ParticleFactory::plane(ModelParticleEmitterAdaptor* emitter,
-		size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones,
+		size_t animation_index, const AnimationTickArgs& tick, const BonePalette& bones,
 		Args args) 
 	{
 		ModelParticleEmitterAdaptor::Particle p;
@@ -56,17 +59,18 @@ namespace core {
 		//Spread Calculation
 		Matrix mrot;
 
-		const auto* bone = allbones[emitter->getBone()];
-		const auto parentBoneId = bone->getParentBoneId();
+		const auto bone_index = emitter->getBone();
+		const auto parentBoneId = bones.getParent(bone_index);
+
+		auto& random = emitter->getRandom();
 
-		CalcSpreadMatrix(args.spr, args.spr, 1.0f, 1.0f);
-		mrot = bone->getMRot() * SpreadMat;
+		mrot = bones.getMRot(bone_index) * CalcSpreadMatrix(random, args.spr, args.spr, 1.0f, 1.0f);
 
 
 		if (emitter_flags == 1041) { // Trans Halo
-			p.position = bone->getMat() * (emitter->getPosition() + Vector3(Random::between(-args.l, args.l), 0, Random::between(-args.w, args.w)));
+			p.position = bones.getMat(bone_index) * (emitter->getPosition() + Vector3(random.between(-args.l, args.l), 0, random.between(-args.w, args.w)));
 
-			const float t = Random::between(0.0f, float(2 * PI));
+			const float t = random.between(0.0f, float(2 * PI));
 
 			p.position = Vector3(0.0f, emitter->getPosition().y + 0.15f, emitter->getPosition().z) + Vector3(cos(t) / 8, 0.0f, sin(t) / 8); // Need to manually correct for the halo - why?
 			assert(!isnan(p.position.x));
@@ -76,7 +80,7 @@ namespace core {
 
 			Vector3 dir(0.0f, 1.0f, 0.0f);
 			p.dir = dir;
-			p.speed = dir.normalize() * args.spd * Random::between(0.0f, args.var);
+			p.speed = dir.normalize() * args.spd * random.between(0.0f, args.var);
 			assert(!isnan(p.speed.x));
 		}
 		else if (emitter_flags == 25 && parentBoneId < 1) { // Weapon Flame
@@ -103,15 +107,15 @@ namespace core {
 
 		}
 		else {
-			p.position = emitter->getPosition() + Vector3(Random::between(-args.l, args.l), 0, Random::between(-args.w, args.w));
+			p.position = emitter->getPosition() + Vector3(random.between(-args.l, args.l), 0, random.between(-args.w, args.w));
 			
 			assert(!isnan(p.position.x));
 
 			//Vec3D dir = mrot * Vec3D(0,1,0);
-			Vector3 dir = bone->getMRot() * Vector3(0, 1, 0);
+			Vector3 dir = bones.getMRot(bone_index) * Vector3(0, 1, 0);
 			p.dir = dir;//.normalize();
 			p.down = Vector3(0, -1.0f, 0); // dir * -1.0f;
-			const auto randf_result = Random::between(-args.var, args.var);
+			const auto randf_result = random.between(-args.var, args.var);
 			p.speed = dir.normalize() * args.spd * (1.0f + randf_result);
 			assert(!isnan(p.speed.x));
 		}
@@ -137,25 +141,27 @@ namespace core {
 		p.origin = p.position;
 
 		const auto tex_dimension = emitter->getTextureDimension();
-		p.tile = Random::between(0, std::max(1, (int)tex_dimension[0]) * std::max(1, (int)tex_dimension[1]) - 1);
+		p.tile = random.between(0, std::max(1, (int)tex_dimension[0]) * std::max(1, (int)tex_dimension[1]) - 1);
 
 		return p;
 	}
 
 	ModelParticleEmitterAdaptor::Particle ParticleFactory::sphere(ModelParticleEmitterAdaptor* emitter,
-		size_t animation_index, const AnimationTickArgs& tick, std::vector<ModelBoneAdaptor*>& allbones,
+		size_t animation_index, const AnimationTickArgs& tick, const BonePalette& bones,
 		Args args) 
 	{
 		ModelParticleEmitterAdaptor::Particle p;
 
 		const uint32_t emitter_flags = emitter->getFlags();
 
-		const auto* bone = allbones[emitter->getBone()];
+		const auto bone_index = emitter->getBone();
+
+		auto& random = emitter->getRandom();
 
 		Vector3 dir;
 		float radius;
 
-		radius = Random::between(0.0f, 1.0f);
+		radius = random.between(0.0f, 1.0f);
 
 		// Old method
 		//float t = randfloat(0,2*PI);
@@ -164,31 +170,30 @@ namespace core {
 		// Spread should never be zero for sphere particles ?
 		float t = 0;
 		if (args.spr == 0) {
-			t = Random::between((float)-PI, (float)PI);
+			t = random.between((float)-PI, (float)PI);
 		}
 		else {
-			t = Random::between(-args.spr, args.spr);
+			t = random.between(-args.spr, args.spr);
 		}
 
 		//Spread Calculation
 		Matrix mrot;
 
-		CalcSpreadMatrix(args.spr * 2, args.spr2 * 2, args.w, args.l);
-		mrot = bone->getMRot() * SpreadMat;
+		mrot = bones.getMRot(bone_index) * CalcSpreadMatrix(random, args.spr * 2, args.spr2 * 2, args.w, args.l);
 
 
 		if (emitter_flags == 57 || emitter_flags == 313) { // Faith Halo
 			Vector3 bdir(args.w * cosf(t) * 1.6, 0.0f, args.l * sinf(t) * 1.6);
 
 			p.position = emitter->getPosition() + bdir;
-			p.tpos = bone->getMat() * p.position;
+			p.tpos = bones.getMat(bone_index) * p.position;
 			assert(!isnan(p.position.x));
 
 			if (bdir.lengthSquared() == 0)
 				p.speed = Vector3(0, 0, 0);
 			else {
-				dir = bone->getMRot() * (bdir.normalize());//mrot * Vec3D(0, 1.0f,0);
-				p.speed = dir.normalize() * args.spd * (1.0f + Random::between(-args.var, args.var));   // ?
+				dir = bones.getMRot(bone_index) * (bdir.normalize());//mrot * Vec3D(0, 1.0f,0);
+				p.speed = dir.normalize() * args.spd * (1.0f + random.between(-args.var, args.var));   // ?
 				assert(!isnan(p.speed.x));
 			}
 
@@ -203,7 +208,7 @@ namespace core {
 			bdir.y = temp;
 
 			p.position = emitter->getPosition() + bdir;
-			p.tpos = bone->getMat() * emitter->getPosition() + bdir;
+			p.tpos = bones.getMat(bone_index) * emitter->getPosition() + bdir;
 			assert(!isnan(p.position.x));
 
 
@@ -214,15 +219,15 @@ namespace core {
 			if ((bdir.lengthSquared() == 0) && ((emitter_flags & 0x100) != 0x100))
 			{
 				p.speed = Vector3(0, 0, 0);
-				dir = bone->getMRot() * Vector3(0, 1, 0);
+				dir = bones.getMRot(bone_index) * Vector3(0, 1, 0);
 			}
 			else {
 				if (emitter_flags & 0x100)
-					dir = bone->getMRot() * Vector3(0, 1, 0);
+					dir = bones.getMRot(bone_index) * Vector3(0, 1, 0);
 				else
 					dir = bdir.normalize();
 
-				p.speed = dir.normalize() * args.spd * (1.0f + Random::between(-args.var, args.var));   // ?
+				p.speed = dir.normalize() * args.spd * (1.0f + random.between(-args.var, args.var));   // ?
 				assert(!isnan(p.speed.x));
 			}
 		}
@@ -244,7 +249,7 @@ namespace core {
 		p.origin = p.position;
 
 		const auto tex_dimension = emitter->getTextureDimension();
-		p.tile = Random::between(0, std::max(1, (int)tex_dimension[0]) * std::max(1, (int)tex_dimension[1]) - 1);
+		p.tile = random.between(0, std::max(1, (int)tex_dimension[0]) * std::max(1, (int)tex_dimension[1]) - 1);
 
 		return p;
 	}
@@ -2,14 +2,14 @@
 #include <vector>
 #include <algorithm>
 #include "../utility/Matrix.h"
+#include "../utility/Math.h"
 #include "Animation.h"
 #include "ModelAdaptors.h"
+#include "BonePalette.h"
 
 namespace core {
 
-//TODO remove static variable -  probably needs to be moved into the emitter classes? looks like it needs to be kept between calls
-	static Matrix	SpreadMat;
-	void CalcSpreadMatrix(float Spread1, float Spread2, float w, float l);
+	Matrix CalcSpreadMatrix(RandomGenerator& random, float Spread1, float Spread2, float w, float l);
 
 
 	class ParticleFactory {
@@ -30,7 +30,7 @@ namespace core {
 			ModelParticleEmitterAdaptor*, 
 			size_t, 
 			const AnimationTickArgs&, 
-			std::vector<ModelBoneAdaptor*>&,
+			const BonePalette&,
 			Args
 		)>;
 
@@ -38,7 +38,7 @@ namespace core {
 			ModelParticleEmitterAdaptor* emitter,
 			size_t animation_index, 
 			const AnimationTickArgs& tick, 
-			std::vector<ModelBoneAdaptor*>& allbones,
+			const BonePalette& bones,
 			Args args
 		);
 
@@ -46,7 +46,7 @@ namespace core {
 			ModelParticleEmitterAdaptor* emitter,
 			size_t animation_index, 
 			const AnimationTickArgs& tick, 
-			std::vector<ModelBoneAdaptor*>& allbones,
+			const BonePalette& bones,
 			Args args
 		);
 
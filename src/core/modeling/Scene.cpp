@@ -83,6 +83,10 @@ namespace core {
 		//TODO sceneChanged needs to be emitted from elsewhere too.
 	}
 
+	void Scene::requestRedraw() {
+		emit redrawRequested();
+	}
+
 	bool _contains_meta_child(
 		ComponentMeta* search,
 		const std::vector<ComponentMeta*>& children) {
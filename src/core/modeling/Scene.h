@@ -35,6 +35,9 @@ namespace core {
 
 		void componentUpdated(ComponentMeta* component);
 
+		// something drawn has changed without the scene structure changing, e.g render options, placement or animation.
+		void requestRedraw();
+
 		Model* findComponentRoot(ComponentMeta* meta) const;
 
 	signals:
@@ -42,6 +45,7 @@ namespace core {
 		void componentRemoved(ComponentMeta* meta);
 		void modelSelectionChanged(const Selection& selection);
 		void sceneChanged();
+		void redrawRequested();
 
 
 	private:
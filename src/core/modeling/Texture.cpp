@@ -322,6 +322,11 @@ namespace core {
 		components.emplace_back(textureUri, region, layer_index, blend_mode);
 	}
 
+	void CharacterTextureBuilder::addLayers(const CharacterTextureBuilder& other)
+	{
+		components.insert(components.end(), other.components.begin(), other.components.end());
+	}
+
 	std::shared_ptr<Texture> CharacterTextureBuilder::build(CharacterComponentTextureAdaptor* componentTextureAdaptor, TextureManager* manager, GameFileSystem* fs)
 	{
 		GLuint id = Texture::INVALID_ID;
@@ -87,6 +87,10 @@ namespace core {
 		void setBaseLayer(const GameFileUri& textureUri);
 		void pushBaseLayer(const GameFileUri& textureUri, BlendMode blend_mode = BlendMode::BLIT);
 		void addLayer(const GameFileUri& textureUri, CharacterRegion region, int layer_index, BlendMode blend_mode = BlendMode::BLIT);
+		// append the layers of another builder, base layers are left unchanged.
+		void addLayers(const CharacterTextureBuilder& other);
+
+		bool operator==(const CharacterTextureBuilder&) const = default;
 
 		std::shared_ptr<Texture> build(CharacterComponentTextureAdaptor* componentTextureAdaptor, TextureManager* manager, GameFileSystem* fs);
 
@@ -110,11 +114,15 @@ namespace core {
 			{
 				return layerIndex < c.layerIndex;
 			}
+
+			bool operator==(const Component&) const = default;
 		};
 
 		struct BaseLayer {
 			GameFileUri uri = 0ul;
 			BlendMode blendMode = BlendMode::BLIT;
+
+			bool operator==(const BaseLayer&) const = default;
 		};
 
 		std::vector<Component> components;
@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace core {
+
+	/// <summary>
+	/// Converts variable frame times into a whole number of fixed simulation steps.
+	/// Time left over from previous frames is carried forward, the remainder is exposed as alpha for blending between the last two steps.
+	/// </summary>
+	class FixedStepClock {
+	public:
+
+		struct Frame {
+			// simulation steps to run this frame, may be 0 when frames are shorter than a step.
+			uint32_t steps = 0;
+			uint32_t stepMsecs = 0;
+			// progress towards the next step [0, 1), used to blend the display between the previous and latest step.
+			float alpha = 1.0f;
+		};
+
+		FixedStepClock(uint32_t step_msecs, uint32_t max_steps) :
+			stepMsecs(std::max(step_msecs, 1u)), maxSteps(std::max(max_steps, 1u)), accumulated(0.0) {}
+
+		Frame advance(double elapsed_msecs) {
+			accumulated += std::max(elapsed_msecs, 0.0);
+
+			Frame frame;
+			frame.stepMsecs = stepMsecs;
+			frame.steps = (uint32_t)std::min(accumulated / stepMsecs, (double)maxSteps);
+			accumulated -= (double)frame.steps * stepMsecs;
+
+			if (accumulated >= stepMsecs) {
+				// too far behind to catch up (e.g after a stall), drop the backlog rather than spiralling.
+				accumulated = std::fmod(accumulated, (double)stepMsecs);
+			}
+
+			frame.alpha = (float)(accumulated / stepMsecs);
+
+			return frame;
+		}
+
+		uint32_t getStepMsecs() const {
+			return stepMsecs;
+		}
+
+	protected:
+		uint32_t stepMsecs;
+		uint32_t maxSteps;
+		double accumulated;
+	};
+}
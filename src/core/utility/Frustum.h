@@ -0,0 +1,98 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "Vector3.h"
+#include "Matrix.h"
+
+namespace core {
+
+	struct BoundingSphere {
+		Vector3 center;
+		float radius = -1.0f;
+
+		// default constructed spheres are empty, and contain nothing.
+		bool isEmpty() const {
+			return radius < 0.0f;
+		}
+
+		// grow to enclose the other sphere as well.
+		void merge(const BoundingSphere& other) {
+			if (other.isEmpty()) {
+				return;
+			}
+
+			if (isEmpty()) {
+				*this = other;
+				return;
+			}
+
+			const Vector3 offset = other.center - center;
+			const float distance = offset.length();
+
+			if (distance + other.radius <= radius) {
+				return;
+			}
+
+			if (distance + radius <= other.radius) {
+				*this = other;
+				return;
+			}
+
+			const float merged_radius = (distance + radius + other.radius) * 0.5f;
+			center += offset * ((merged_radius - radius) / distance);
+			radius = merged_radius;
+		}
+	};
+
+	/// <summary>
+	/// Planes of a view volume, extracted from a combined projection * modelview matrix (in core::Matrix row order).
+	/// Planes are in the space the matrix transforms from, so a model space frustum can be tested against model space bounds.
+	/// </summary>
+	class Frustum {
+	public:
+
+		static Frustum fromMatrix(const Matrix& clip) {
+			Frustum frustum;
+
+			for (size_t i = 0; i < 3; i++) {
+				for (size_t side = 0; side < 2; side++) {
+					const float sign = side == 0 ? 1.0f : -1.0f;
+					auto& plane = frustum.planes[(i * 2) + side];
+					for (size_t j = 0; j < 4; j++) {
+						plane[j] = clip.m[3][j] + (sign * clip.m[i][j]);
+					}
+
+					const float length = std::sqrt((plane[0] * plane[0]) + (plane[1] * plane[1]) + (plane[2] * plane[2]));
+					if (length > 0.0f) {
+						for (auto& value : plane) {
+							value /= length;
+						}
+					}
+				}
+			}
+
+			return frustum;
+		}
+
+		// conservative, spheres near corners can pass without being visible.
+		bool intersects(const BoundingSphere& sphere) const {
+			if (sphere.isEmpty()) {
+				return false;
+			}
+
+			for (const auto& plane : planes) {
+				const float distance = (plane[0] * sphere.center.x) + (plane[1] * sphere.center.y) + (plane[2] * sphere.center.z) + plane[3];
+				if (distance < -sphere.radius) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+	protected:
+		// left, right, bottom, top, near, far. normals point inwards.
+		std::array<std::array<float, 4>, 6> planes;
+	};
+}
@@ -0,0 +1,93 @@
+#include "../../stdafx.h"
+#include "JobGraph.h"
+
+namespace core {
+
+	JobGraph::JobGraph(QThreadPool* _pool) : pool(_pool), remaining(0)
+	{
+		assert(pool != nullptr);
+	}
+
+	JobGraph::JobId JobGraph::add(std::function<void()> job, std::initializer_list<JobId> depends_on)
+	{
+		const JobId id = jobs.size();
+		auto entry = std::make_unique<Job>();
+		entry->callback = std::move(job);
+		jobs.push_back(std::move(entry));
+
+		for (const auto dependency : depends_on) {
+			dependsOn(id, dependency);
+		}
+
+		return id;
+	}
+
+	void JobGraph::dependsOn(JobId job, JobId dependency)
+	{
+		// dependencies must already exist, which also guarantees the graph is acyclic.
+		assert(dependency < job && job < jobs.size());
+		jobs[dependency]->dependents.push_back(job);
+		jobs[job]->dependencyCount++;
+	}
+
+	void JobGraph::run()
+	{
+		if (jobs.size() == 0) {
+			return;
+		}
+
+		remaining = jobs.size();
+		error = nullptr;
+
+		for (auto& job : jobs) {
+			job->pending = job->dependencyCount;
+		}
+
+		for (JobId id = 0; id < jobs.size(); id++) {
+			if (jobs[id]->dependencyCount == 0) {
+				dispatch(id);
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this]() { return remaining == 0; });
+
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	void JobGraph::dispatch(JobId id)
+	{
+		pool->start([this, id]() {
+			execute(id);
+		});
+	}
+
+	void JobGraph::execute(JobId id)
+	{
+		auto& job = *jobs[id];
+
+		try {
+			job.callback();
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+
+		// dependents still run after a failure, so the graph always drains.
+		for (const auto dependent : job.dependents) {
+			if (--jobs[dependent]->pending == 0) {
+				dispatch(dependent);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--remaining == 0) {
+			finished.notify_all();
+		}
+	}
+}
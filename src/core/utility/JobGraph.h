@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class QThreadPool;
+
+namespace core {
+
+	/// <summary>
+	/// Set of jobs with explicit dependency edges, executed on a thread pool.
+	/// A job only starts once every job it depends on has finished, run() blocks until the whole graph completes.
+	/// </summary>
+	class JobGraph {
+	public:
+		using JobId = size_t;
+
+		JobGraph(QThreadPool* _pool);
+		JobGraph(const JobGraph&) = delete;
+
+		JobId add(std::function<void()> job, std::initializer_list<JobId> depends_on = {});
+
+		// add an edge, 'job' will not start until 'dependency' has finished.
+		void dependsOn(JobId job, JobId dependency);
+
+		// execute all jobs and wait for them to complete, the first exception thrown by a job is rethrown here.
+		void run();
+
+		size_t size() const {
+			return jobs.size();
+		}
+
+	protected:
+
+		struct Job {
+			std::function<void()> callback;
+			std::vector<JobId> dependents;
+			uint32_t dependencyCount = 0;
+			std::atomic<uint32_t> pending = 0;
+		};
+
+		void dispatch(JobId id);
+		void execute(JobId id);
+
+		QThreadPool* pool;
+		std::vector<std::unique_ptr<Job>> jobs;
+
+		std::mutex mutex;
+		std::condition_variable finished;
+		size_t remaining;
+		std::exception_ptr error;
+	};
+}
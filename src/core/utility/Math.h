@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 //TODO many math, vector, etc functions can be replaced by glm.
 
@@ -50,4 +51,52 @@ namespace core {
 
 		static int32_t between(int32_t lower, int32_t upper);
 	};
+
+	/// <summary>
+	/// Seedable PCG32 generator, each instance has its own state so can be used independently per thread / owner.
+	/// Same seed and stream always produce the same sequence.
+	/// </summary>
+	class RandomGenerator {
+	public:
+		RandomGenerator(uint64_t seed = 0, uint64_t stream = 0) {
+			this->seed(seed, stream);
+		}
+
+		void seed(uint64_t seed, uint64_t stream = 0) {
+			state = 0;
+			increment = (stream << 1u) | 1u;
+			next();
+			state += seed;
+			next();
+		}
+
+		uint32_t next() {
+			const uint64_t old_state = state;
+			state = old_state * 6364136223846793005ULL + increment;
+			const uint32_t xorshifted = (uint32_t)(((old_state >> 18u) ^ old_state) >> 27u);
+			const uint32_t rot = (uint32_t)(old_state >> 59u);
+			return (xorshifted >> rot) | (xorshifted << ((~rot + 1u) & 31));
+		}
+
+		/// <summary>
+		/// returns a random value between 0...1
+		/// </summary>
+		float normalised() {
+			// top 24 bits, exactly representable as a float.
+			return (next() >> 8) * (1.0f / 16777215.0f);
+		}
+
+		float between(float lower, float upper) {
+			return lower + (upper - lower) * normalised();
+		}
+
+		int32_t between(int32_t lower, int32_t upper) {
+			const auto range = (uint64_t)((int64_t)upper - lower + 1);
+			return lower + (int32_t)(((uint64_t)next() * range) >> 32);
+		}
+
+	protected:
+		uint64_t state;
+		uint64_t increment;
+	};
 };
\ No newline at end of file
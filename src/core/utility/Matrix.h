@@ -99,6 +99,18 @@ namespace core {
 			return *this = this->operator*(p);
 		}
 
+		// component-wise blend, r = 0 gives a and r = 1 gives b.
+		static Matrix lerp(const Matrix& a, const Matrix& b, float r)
+		{
+			Matrix o;
+			for (size_t j = 0; j < 4; j++) {
+				for (size_t i = 0; i < 4; i++) {
+					o.m[j][i] = a.m[j][i] + ((b.m[j][i] - a.m[j][i]) * r);
+				}
+			}
+			return o;
+		}
+
 		operator float* ()
 		{
 			return (float*)this;
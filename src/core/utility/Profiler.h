@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace core {
+
+	/// <summary>
+	/// Rolling CPU timings for a fixed set of phases.
+	/// Timers may run concurrently (e.g from update jobs), time spent within a frame is summed per phase and committed to the rolling window by endFrame.
+	/// </summary>
+	template<size_t PhaseCount, size_t WindowSize = 60>
+	class PhaseProfiler {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		// all values are in milliseconds.
+		struct Stats {
+			double last = 0.0;
+			double average = 0.0;
+			double peak = 0.0;
+		};
+
+		class ScopedTimer {
+		public:
+			ScopedTimer(PhaseProfiler& _profiler, size_t _phase) :
+				profiler(_profiler), phase(_phase), start(clock::now()) {}
+			ScopedTimer(const ScopedTimer&) = delete;
+
+			~ScopedTimer() {
+				profiler.add(phase, clock::now() - start);
+			}
+
+		protected:
+			PhaseProfiler& profiler;
+			size_t phase;
+			clock::time_point start;
+		};
+
+		PhaseProfiler() {
+			for (auto& value : pending) {
+				value = 0;
+			}
+
+			for (auto& values : history) {
+				values.fill(0);
+			}
+		}
+
+		PhaseProfiler(PhaseProfiler&& other) :
+			history(other.history), cursor(other.cursor), frames(other.frames)
+		{
+			for (size_t phase = 0; phase < PhaseCount; phase++) {
+				pending[phase] = other.pending[phase].load();
+			}
+		}
+
+		void add(size_t phase, clock::duration duration) {
+			pending[phase].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed);
+		}
+
+		// commit the time collected since the last call as a new frame, must not be called while timers are running.
+		void endFrame() {
+			for (size_t phase = 0; phase < PhaseCount; phase++) {
+				history[phase][cursor] = pending[phase].exchange(0, std::memory_order_relaxed);
+			}
+
+			cursor = (cursor + 1) % WindowSize;
+			frames = std::min(frames + 1, WindowSize);
+		}
+
+		Stats getStats(size_t phase) const {
+			Stats stats;
+
+			if (frames == 0) {
+				return stats;
+			}
+
+			const auto& values = history[phase];
+			int64_t total = 0;
+			int64_t peak = 0;
+
+			for (size_t i = 0; i < frames; i++) {
+				total += values[i];
+				peak = std::max(peak, values[i]);
+			}
+
+			stats.last = toMilliseconds(values[(cursor + WindowSize - 1) % WindowSize]);
+			stats.average = toMilliseconds(total) / frames;
+			stats.peak = toMilliseconds(peak);
+
+			return stats;
+		}
+
+		static constexpr size_t getPhaseCount() {
+			return PhaseCount;
+		}
+
+	protected:
+		static double toMilliseconds(int64_t nanoseconds) {
+			return nanoseconds / 1000000.0;
+		}
+
+		std::array<std::atomic<int64_t>, PhaseCount> pending;
+		// nanoseconds per phase per frame, only the first 'frames' entries are valid.
+		std::array<std::array<int64_t, WindowSize>, PhaseCount> history;
+		size_t cursor = 0;
+		size_t frames = 0;
+	};
+}
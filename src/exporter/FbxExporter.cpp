@@ -289,7 +289,7 @@ namespace exporter {
 				//only doing owned attachments here, the merged type attachments will be handled in the previous step.
 				attachment->visit<core::Attachment::AttachOwnedModel>([&](const core::Attachment::AttachOwnedModel* owned) {
 					std::map<uint32_t, fbxsdk::FbxNode*> attach_bone_nodes_map;
-					Matrix m = model->model->getBoneAdaptors()[owned->bone]->getMat();
+					Matrix m = model->model->getBonePalette().getMat(owned->bone);
 					FbxNode* attach_mesh_node = createMesh(owned, mSdkManager, mScene, m);
 					FbxNode* attach_skeleton_node = createSkeleton(owned->model.get(), mSdkManager, mScene, attach_bone_nodes_map);
 